@@ -89,6 +89,25 @@ const memoryChart = new Chart(document.getElementById('memoryChart').getContext(
   }
 })
 
+function seedChart(metric, data, chart) {
+  fetch(`/api/history?metric=${metric}&res=hires`)
+    .then((response) => response.json())
+    .then((history) => {
+      const values = history.hires.v.slice(-maxDataPoints)
+      const offset = maxDataPoints - values.length
+      // Missing samples stay null so the chart leaves a gap instead of a dip
+      data.fill(null, 0, offset)
+      values.forEach((value, i) => {
+        data[offset + i] = value
+      })
+      chart.update()
+    })
+    .catch((error) => console.error('Error:', error))
+}
+
+seedChart('device_cpu', cpuData, cpuChart)
+seedChart('device_heap', memoryData, memoryChart)
+
 fetch('/settings')
   .then((response) => response.json())
   .then((data) => {
@@ -311,6 +330,7 @@ function updateSystemInfo(data) {
       if (key === 'temperature') value += ' °C'
       if (key === 'wifiStrength') value += ' dBm'
       if (key === 'heapFragmentation') value += '%'
+      if (key.endsWith('Us')) value += ' µs'
 
       element.textContent = value
     }
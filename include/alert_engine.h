@@ -0,0 +1,82 @@
+#ifndef ALERT_ENGINE_H
+#define ALERT_ENGINE_H
+
+#include "metrics_history.h"
+
+#define ALERT_MAX_RULES 16
+#define ALERT_NAME_LENGTH 16
+#define ALERT_RULES_MAX_LENGTH 256
+#define ALERT_WEBHOOK_MAX_LENGTH 96
+#define ALERT_EVENT_QUEUE ALERT_MAX_RULES // room to clear every rule on a recompile
+#define ALERT_NOTIFY_INTERVAL_MS 300000 // per rule
+#define ALERT_NOTIFY_BURST 4            // notifications allowed per window, all rules
+#define ALERT_NOTIFY_WINDOW_MS 60000
+
+enum AlertAction : uint8_t
+{
+    ALERT_ACTION_BANNER = 1,
+    ALERT_ACTION_FLASH = 2,
+    ALERT_ACTION_NOTIFY = 4
+};
+
+struct AlertRule
+{
+    char name[ALERT_NAME_LENGTH];
+    MetricId metric;
+    bool rate;  // compare the change per second instead of the value
+    bool above; // trips above limit, otherwise below
+    float limit;
+    float clear; // must come back past this to clear; equals limit without hysteresis
+    uint32_t forMs;
+    uint8_t actions;
+};
+
+struct AlertState
+{
+    bool active;
+    bool pending; // tripped, waiting for forMs
+    bool notified; // the current activation was notified
+    float value;   // last evaluated value or rate
+    uint64_t sinceMs; // start of pending or active
+    uint32_t fireCount;
+};
+
+// Carries a copy of its rule, so a queued event stays valid when the rules
+// are recompiled
+struct AlertEvent
+{
+    AlertRule rule;
+    bool active;
+    bool notify; // passed rate limiting
+    float value;
+    uint64_t atMs;
+};
+
+// Evaluates alert rules against metric samples as they are recorded. Rules
+// are chained per metric, so a sample only touches the rules watching that
+// metric, and all state lives in fixed arrays. The rule text has entries
+// "name=[rate:]metric>limit[/clear][@seconds][+action...]" separated by ';',
+// with '<' for low limits and actions banner, flash and notify (banner and
+// notify when none are given). Names are letters, digits, '_' and '-'.
+class AlertEngine
+{
+public:
+    static const char *defaultRules();
+    // Keeps the previous rules and fills error when the text is invalid.
+    // Active alerts of the previous rules are queued as cleared.
+    static bool compile(const char *rules, char *error, size_t errorSize);
+    // Checks the text without applying it
+    static bool validate(const char *rules, char *error, size_t errorSize);
+    static size_t ruleCount();
+    static const AlertRule &rule(size_t index);
+    static const AlertState &state(size_t index);
+    static size_t activeCount();
+
+    static void observe(MetricId metric, float value, uint64_t nowMs);
+    // Transitions in the order they happened; false when none are left
+    static bool pollEvent(AlertEvent &event);
+    static uint32_t evalCount();
+    static uint32_t droppedEvents();
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef ALERT_NOTIFIER_H
+#define ALERT_NOTIFIER_H
+
+#define ALERT_FLASH_COUNT 3
+#define ALERT_WEBHOOK_TIMEOUT_MS 2000
+#define ALERT_WEBHOOK_QUEUE 4     // posts waiting for the webhook task
+#define ALERT_WEBHOOK_STACK 6144
+#define ALERT_PAYLOAD_SIZE 192
+
+// Drains alert transitions and carries out their actions: the on-screen
+// banner, a backlight flash, and MQTT/webhook notifications for events that
+// passed the engine's rate limiting. Call from loop(). Webhook posts are
+// handed to a task of their own, so a slow webhook never holds up loop().
+void handleAlerts();
+
+#endif
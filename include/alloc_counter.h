@@ -0,0 +1,21 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <stdint.h>
+
+// Counts heap allocations: every malloc and calloc, and realloc calls that
+// had to create or move a block. The counter wraps those symbols at link
+// time, so it is only active in builds with
+//   -D ALLOC_COUNTER -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc
+// such as the esp32dev-soak and soak environments of platformio.example.ini.
+// Code that calls heap_caps_malloc() directly is not seen, and neither is
+// LVGL, which allocates from its own pool.
+class AllocCounter
+{
+public:
+    static bool enabled();
+    // Allocations since boot; stays 0 without ALLOC_COUNTER
+    static uint32_t count();
+};
+
+#endif
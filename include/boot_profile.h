@@ -0,0 +1,33 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <stdint.h>
+
+// Boot milestones in the order they usually happen. WiFi and storage come
+// up in the background, so their place among the others varies.
+enum BootPhase : uint8_t
+{
+    BOOT_DISPLAY,    // panel and LVGL driver ready
+    BOOT_FIRST_PAINT,
+    BOOT_SETTINGS,
+    BOOT_STORAGE,    // SPIFFS mounted
+    BOOT_WIFI,       // associated with an address
+    BOOT_WEB,        // web server listening
+    BOOT_FIRST_DATA, // first Glances cycle without a fetch error
+    BOOT_PHASE_COUNT
+};
+
+// Records when each boot milestone was first reached, in milliseconds of
+// esp_timer time, which starts early in the bootloader handoff. Safe to mark
+// from other tasks.
+class BootProfile
+{
+public:
+    static void mark(BootPhase phase);
+    static bool reached(BootPhase phase);
+    static uint32_t phaseMs(BootPhase phase);
+    static const char *phaseName(BootPhase phase);
+    static void print();
+};
+
+#endif
@@ -10,6 +10,8 @@ extern const char *const password;
 extern String glances_host;
 extern uint16_t glances_port;
 #define GLANCES_UPDATE_INTERVAL 2000
+// Detail pages hidden for this long are deleted and rebuilt on next use; 0 keeps them
+#define GUI_FREE_IDLE_PAGE_MS 120000
 
 // Debug configuration
 extern bool debug_mode;
@@ -0,0 +1,57 @@
+#ifndef CONTAINER_TOP_H
+#define CONTAINER_TOP_H
+
+#include "process_top.h"
+
+#define CONTAINER_TOP_N 10
+#define CONTAINER_NAME_LENGTH 24
+
+enum ContainerState : uint8_t
+{
+    CONTAINER_RUNNING,
+    CONTAINER_PAUSED,
+    CONTAINER_STOPPED,
+    CONTAINER_RESTARTING,
+    CONTAINER_UNHEALTHY
+};
+
+struct ContainerEntry
+{
+    char name[CONTAINER_NAME_LENGTH];
+    ContainerState state;
+    float cpu;   // percent of one core
+    float memMb;
+};
+
+struct ContainerSummary
+{
+    uint16_t total;
+    uint16_t running;
+    uint16_t restarting;
+    uint16_t unhealthy;
+};
+
+// Keeps the heaviest containers of the Glances container list in a
+// fixed-size min-heap, like ProcessTop. Restarting and unhealthy containers
+// rank above every healthy one so they always make the list.
+class ContainerTop
+{
+public:
+    static void setSort(ProcessSort sort);
+    static ProcessSort sort();
+
+    static ContainerState parseState(const char *status, const char *health);
+    static const char *stateName(ContainerState state);
+
+    static void beginPass();
+    static void add(const char *name, ContainerState state, float cpu, float memMb);
+    // Orders the kept entries heaviest first
+    static void endPass(uint32_t parseUs);
+
+    static size_t count();
+    static const ContainerEntry &entry(size_t index);
+    static const ContainerSummary &summary();
+    static uint32_t parseUs();
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef CORE_HEATMAP_H
+#define CORE_HEATMAP_H
+
+#include <lvgl.h>
+
+#define HEATMAP_MAX_CORES 128
+#define HEATMAP_BUCKETS 10
+#define HEATMAP_GAP 2
+
+// Grid of per-core load cells drawn by a custom draw routine. Loads are
+// quantised into buckets and only cells whose bucket changed are
+// invalidated, so an update costs a compare per core plus a redraw of the
+// cells that actually moved. There is a single heatmap instance.
+lv_obj_t *core_heatmap_create(lv_obj_t *parent);
+// loads are 0-100 percent; a change in count relayouts the grid
+void core_heatmap_set_loads(const float *loads, uint16_t count);
+void core_heatmap_set_colors(lv_color_t idle, lv_color_t busy, lv_color_t hot);
+
+struct HeatmapStats
+{
+    uint16_t cores;
+    uint16_t changedCells; // in the last update
+    uint32_t updateUs;     // last core_heatmap_set_loads()
+    uint32_t drawUs;       // last draw callback
+};
+
+const HeatmapStats &core_heatmap_stats();
+
+#endif
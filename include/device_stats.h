@@ -0,0 +1,49 @@
+#ifndef DEVICE_STATS_H
+#define DEVICE_STATS_H
+
+#include <Arduino.h>
+
+#define DEVICE_STATS_INTERVAL_MS 1000
+#define DEVICE_STATS_MAX_TASKS 24
+
+// Work done by loop(); timed separately because it all runs in one task
+enum LoopStage : uint8_t
+{
+    STAGE_LVGL,
+    STAGE_GLANCES,
+    STAGE_WEB,
+    STAGE_MQTT,
+    STAGE_OTHER, // the rest of loop(), measured by LoopLatency
+    STAGE_COUNT
+};
+
+struct TaskStat
+{
+    char name[16];
+    float cpuPercent;        // share of one core, -1 without run-time stats
+    uint32_t stackHighWater; // bytes never used since the task started
+    int8_t core;             // -1 when not pinned
+    uint8_t priority;
+};
+
+// Device CPU accounting. Uses FreeRTOS run-time counters when the SDK is built
+// with them, otherwise falls back to sampling the running task on each tick,
+// which only yields per-core utilisation.
+class DeviceStats
+{
+public:
+    static void begin();
+    static void update();
+
+    static void addStageTime(LoopStage stage, uint32_t us);
+    static float stageShare(LoopStage stage);
+    static const char *stageName(LoopStage stage);
+
+    static float coreUsage(int core);
+    static float totalUsage();
+    static size_t taskCount();
+    static const TaskStat &task(size_t index);
+    static bool hasRunTimeStats();
+};
+
+#endif
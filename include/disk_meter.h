@@ -0,0 +1,59 @@
+#ifndef DISK_METER_H
+#define DISK_METER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DISKIO_MAX_ENTRIES 32 // diskio array positions tracked, partitions included
+#define DISKIO_MAX_DISKS 12
+#define DISKIO_NAME_LENGTH 16
+#define DISKIO_HISTORY 60
+
+struct DiskRate
+{
+    char name[DISKIO_NAME_LENGTH];
+    bool valid;
+    bool stacked; // md/dm device on top of other disks, left out of the total
+    float readRate;  // bytes per second
+    float writeRate;
+    float readIops;
+    float writeIops;
+};
+
+struct DiskTotals
+{
+    bool valid;
+    float readRate;
+    float writeRate;
+    float readIops;
+    float writeIops;
+    int8_t busiest; // disk index with the most bytes moved, -1 when idle
+};
+
+// Turns Glances' cumulative diskio counters into throughput and IOPS over
+// our own poll interval. Partitions, loop and ram devices are skipped.
+//
+// The array position of every entry is mapped to a disk once; later payloads
+// only hash each name to confirm the position still holds the same device,
+// so a pass is linear and copies no strings. The map is rebuilt when the
+// entry count or a name changes.
+class DiskMeter
+{
+public:
+    // nowUs must be monotonic and taken when the payload arrived
+    static void beginPass(uint64_t nowUs);
+    static void addEntry(const char *name, uint64_t readBytes, uint64_t writeBytes, uint64_t readCount,
+                         uint64_t writeCount);
+    // Returns false until a disk has been seen in two passes
+    static bool endPass();
+
+    static size_t diskCount();
+    static const DiskRate &disk(size_t index);
+    static const DiskTotals &totals();
+    // Total throughput of the last passes, oldest first; returns the count
+    static size_t history(float *out, size_t maxCount);
+    static uint32_t rebuildCount();
+    static void reset();
+};
+
+#endif
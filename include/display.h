@@ -4,6 +4,8 @@
 #include <lvgl.h>
 #include <TFT_eSPI.h>
 
+#define DISPLAY_FLASH_STEP_MS 150
+
 extern TFT_eSPI tft;
 extern lv_disp_draw_buf_t draw_buf;
 extern lv_color_t *buf1;
@@ -12,5 +14,10 @@ extern lv_color_t *buf2;
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p);
 void init_display();
 void display_sleep(bool sleep);
+bool display_is_awake();
+// Blinks the backlight without blocking, e.g. to draw attention to an alert
+void display_flash(uint8_t times);
+// micros() at the end of the last LVGL refresh that drew something
+uint32_t display_last_refresh_us();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef FETCH_STATS_H
+#define FETCH_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FETCH_STATS_MAX_ENDPOINTS 12
+#define FETCH_HIST_BUCKETS 11
+
+enum FetchPhase : uint8_t
+{
+    PHASE_DNS,
+    PHASE_CONNECT,
+    PHASE_TTFB,
+    PHASE_BODY,
+    PHASE_PARSE,
+    PHASE_TOTAL,
+    PHASE_COUNT
+};
+
+enum FetchError : uint8_t
+{
+    FETCH_ERR_WIFI,
+    FETCH_ERR_DNS,
+    FETCH_ERR_CONNECT,
+    FETCH_ERR_TIMEOUT,
+    FETCH_ERR_HTTP,
+    FETCH_ERR_PARSE,
+    FETCH_ERR_COUNT
+};
+
+// Timing of a single request. Phases that were not reached stay 0.
+struct FetchTrace
+{
+    uint32_t phaseUs[PHASE_COUNT];
+    uint32_t bytes;
+    int status;
+};
+
+struct EndpointStats
+{
+    char endpoint[24];
+    uint32_t count;
+    uint32_t errors[FETCH_ERR_COUNT];
+    uint32_t histogram[PHASE_COUNT][FETCH_HIST_BUCKETS];
+    uint32_t phaseMaxUs[PHASE_COUNT];
+    uint64_t phaseSumUs[PHASE_COUNT];
+    uint64_t bytesTotal;
+    FetchTrace last;
+};
+
+// Per-endpoint latency histograms and error counters for Glances requests.
+// Endpoints are keyed by their path; the table is fixed size and static.
+class FetchStats
+{
+public:
+    static void record(const char *endpoint, const FetchTrace &trace);
+    static void recordError(const char *endpoint, FetchError error, const FetchTrace &trace);
+
+    static size_t endpointCount();
+    static const EndpointStats &endpoint(size_t index);
+    // Errors of all endpoints since boot or the last reset()
+    static uint32_t errorCount();
+    // Upper bound of a histogram bucket in microseconds; the last is open
+    static uint32_t bucketLimitUs(size_t bucket);
+    static const char *phaseName(FetchPhase phase);
+    static const char *errorName(FetchError error);
+    static void printTrace(const char *endpoint, const FetchTrace &trace);
+    static void printSummary();
+    static void reset();
+
+private:
+    static EndpointStats *find(const char *endpoint);
+};
+
+#endif
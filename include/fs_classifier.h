@@ -0,0 +1,86 @@
+#ifndef FS_CLASSIFIER_H
+#define FS_CLASSIFIER_H
+
+#include "glob_pattern.h"
+
+#define FS_MAX_RULES 16
+#define FS_MAX_CONDITIONS 2
+#define FS_MAX_DRIVES 40
+#define FS_RULES_MAX_LENGTH 320
+
+enum FsGroup : uint8_t
+{
+    FS_GROUP_IGNORE,
+    FS_GROUP_ARRAY,
+    FS_GROUP_CACHE
+};
+
+enum FsField : uint8_t
+{
+    FS_FIELD_MNT,
+    FS_FIELD_OPTIONS,
+    FS_FIELD_DEVICE,
+    FS_FIELD_TYPE
+};
+
+struct FsCondition
+{
+    FsField field;
+    GlobPattern pattern;
+};
+
+struct FsRule
+{
+    FsGroup group;
+    uint8_t conditionCount;
+    FsCondition conditions[FS_MAX_CONDITIONS];
+};
+
+struct DriveInfo
+{
+    char name[24];
+    uint64_t size;
+    uint64_t used;
+    float percent;
+    FsGroup group;
+};
+
+// Result of one pass over the /api/4/fs array
+struct FsSummary
+{
+    uint64_t arraySize;
+    uint64_t arrayUsed;
+    uint64_t cacheSize;
+    uint64_t cacheUsed;
+    uint16_t arrayCount;
+    uint16_t cacheCount;
+    uint16_t mountCount;
+    uint16_t driveCount;
+    DriveInfo drives[FS_MAX_DRIVES];
+};
+
+// Classifies mounts with user rules of the form "group:field=pattern",
+// separated by ';'. group is array, cache or ignore; field is mnt, opt, dev
+// or type; pattern may start and/or end with '*'. A rule may join two
+// conditions with '&', and then matches only when both do. The first
+// matching rule wins and unmatched mounts are ignored. Rules are compiled once, when they
+// change, so classifying a mount never parses text.
+class FsClassifier
+{
+public:
+    static const char *defaultRules();
+    // Keeps the previous rules and fills error when the text is invalid
+    static bool compile(const char *rules, char *error, size_t errorSize);
+    // Checks the text without applying it
+    static bool validate(const char *rules, char *error, size_t errorSize);
+    static size_t ruleCount();
+
+    static FsGroup classify(const char *mnt, const char *options, const char *device, const char *type);
+
+    static void beginPass(FsSummary &summary);
+    static void addMount(FsSummary &summary, const char *mnt, const char *options, const char *device,
+                         const char *type, uint64_t size, uint64_t used);
+    static float percent(uint64_t used, uint64_t size);
+};
+
+#endif
@@ -2,12 +2,86 @@
 #define GLANCES_API_H
 
 #include <ArduinoJson.h>
+#include <WiFiClient.h>
+#include "fetch_stats.h"
+#include "glances_parse.h"
+#include "fs_classifier.h"
+#include "net_meter.h"
+#include "sensor_map.h"
+#include "core_heatmap.h"
+
+#define GLANCES_CONNECT_TIMEOUT_MS 3000
+#define GLANCES_RESPONSE_TIMEOUT_MS 5000
+// Whole request, from DNS to the last byte. The loop watchdog is fed between
+// requests, so this stays well under LOOP_WDT_TIMEOUT_S.
+#define GLANCES_REQUEST_TIMEOUT_MS 8000
+#define FETCH_SUMMARY_EVERY_CYCLES 30
+// Largest response fetchData() reads whole; arrays are streamed instead
+#define GLANCES_PAYLOAD_SIZE 3072
+#define GLANCES_REQUEST_SIZE 192
+
+// Latest values parsed from Glances, shared with publishers such as MQTT.
+// Floats are NAN until the first successful fetch.
+struct HostMetrics
+{
+    float cpu_percent;
+    float cpu_cores;
+    float mem_percent;
+    float mem_total_gb;
+    float load1;
+    float temperature;
+    float disk_percent;
+    float cache_percent;
+    float net_rx_rate;
+    float net_tx_rate;
+    float net_rx_peak;
+    float net_tx_peak;
+    char uptime[32];
+    uint32_t updated_ms;
+};
+
+// Load of each logical core from /api/4/percpu, indexed by cpu_number
+struct PerCpuLoads
+{
+    uint16_t count;
+    float total[HEATMAP_MAX_CORES];
+};
+
+// One updateGlancesData() pass, from its first request to the refreshed
+// screen. A cycle fails when any of its requests records a fetch error.
+struct GlancesCycleStats
+{
+    uint32_t cycles;
+    uint32_t failedCycles;
+    uint32_t lastCycleMs;
+    uint32_t maxCycleMs;
+    bool lastOk;
+    uint32_t lastOkMs;   // millis() at the end of the last clean cycle
+    uint32_t lastAllocs; // heap allocations during the last cycle, see AllocCounter
+    uint32_t maxAllocs;
+};
+
+extern HostMetrics host_metrics;
+extern FsSummary fs_summary;
+extern PerCpuLoads percpu_loads;
+extern GlancesCycleStats glances_cycle;
 
 struct GlancesAPI
 {
-    static bool fetchData(const char *endpoint, StaticJsonDocument<4096> &doc);
-    static void updateCPUData(StaticJsonDocument<4096> &doc);
-    static void updateMemoryData(StaticJsonDocument<4096> &doc);
+    // deadline is the millis() time by which the whole request must be done
+    static bool openRequest(const char *endpoint, WiFiClient &client, FetchTrace &trace, int &contentLength,
+                            unsigned long deadline);
+    static bool fetchData(const char *endpoint, JsonDocument &doc, const JsonDocument *filter = nullptr);
+    static bool streamArray(const char *endpoint, JsonDocument &filter, JsonDocument &element,
+                            ArrayElementCallback callback, void *context, FetchTrace *traceOut = nullptr);
+    static bool updateFsData();
+    static bool updateNetworkData();
+    static bool updateDiskIoData();
+    static bool updateSensorData();
+    static bool updatePerCpuData();
+    static bool updateProcessData();
+    static bool updateContainerData();
+    static void updateRegistryData(JsonDocument &doc);
 };
 
 void updateGlancesData();
@@ -0,0 +1,87 @@
+#ifndef GLANCES_PARSE_H
+#define GLANCES_PARSE_H
+
+#include <ArduinoJson.h>
+#include <Stream.h>
+
+// Capacities of the filter and per-element documents of each streamed
+// endpoint: a slot per kept field plus room for the copied keys and strings.
+// Slots are twice as large on a 64-bit host, so the sizes are written in
+// JSON_OBJECT_SIZE and the native tests check the corpus responses fit.
+#define GLANCES_FS_FILTER_SIZE JSON_OBJECT_SIZE(6)
+#define GLANCES_FS_ELEMENT_SIZE (JSON_OBJECT_SIZE(6) + 416)
+#define GLANCES_NET_FILTER_SIZE JSON_OBJECT_SIZE(5)
+#define GLANCES_NET_ELEMENT_SIZE (JSON_OBJECT_SIZE(5) + 176)
+#define GLANCES_DISKIO_FILTER_SIZE JSON_OBJECT_SIZE(5)
+#define GLANCES_DISKIO_ELEMENT_SIZE (JSON_OBJECT_SIZE(5) + 176)
+#define GLANCES_SENSOR_FILTER_SIZE JSON_OBJECT_SIZE(3)
+#define GLANCES_SENSOR_ELEMENT_SIZE (JSON_OBJECT_SIZE(3) + 208)
+#define GLANCES_PROCESS_FILTER_SIZE JSON_OBJECT_SIZE(4)
+#define GLANCES_PROCESS_ELEMENT_SIZE (JSON_OBJECT_SIZE(4) + 192)
+#define GLANCES_CONTAINER_FILTER_SIZE (JSON_OBJECT_SIZE(7) + 2 * JSON_OBJECT_SIZE(1))
+#define GLANCES_CONTAINER_ELEMENT_SIZE (JSON_OBJECT_SIZE(7) + 2 * JSON_OBJECT_SIZE(1) + 176)
+
+typedef void (*ArrayElementCallback)(JsonObjectConst item, void *context);
+
+// What one walk of a streamed array saw
+struct ArrayPass
+{
+    size_t elements;
+    size_t peakElementBytes; // largest memoryUsage() of one filtered element
+    bool overflowed;         // an element did not fit its document
+    uint32_t parseUs;        // time inside deserializeJson
+    DeserializationError error;
+};
+
+// Context of the endpoints whose counters become rates. The pass is stamped
+// when the first element arrives, so DNS and connect jitter do not leak into
+// the rate interval.
+struct RatePass
+{
+    uint64_t (*nowUs)();
+    bool started;
+};
+
+// Element filters and field extraction for the Glances endpoints, kept free
+// of networking so the same code runs in the native tests. Each on*Entry
+// callback hands one filtered array element to the module that keeps the
+// result.
+class GlancesParse
+{
+public:
+    // Reads a JSON array from stream one filtered element at a time, so
+    // memory use is bounded by the largest element rather than the whole
+    // body. Between elements it waits for data until deadline, a millis()
+    // time; inside an element the stream's own timeout applies. False on
+    // malformed JSON or a stream that stops before the closing bracket.
+    static bool walkArray(Stream &stream, JsonDocument &filter, JsonDocument &element, ArrayElementCallback callback,
+                          void *context, unsigned long deadline, ArrayPass &pass);
+
+    static void fsFilter(JsonDocument &filter);
+    // context is the FsSummary being filled
+    static void onFsEntry(JsonObjectConst fs, void *context);
+
+    static void netFilter(JsonDocument &filter);
+    // context is a RatePass
+    static void onNetEntry(JsonObjectConst iface, void *context);
+
+    static void diskIoFilter(JsonDocument &filter);
+    // context is a RatePass
+    static void onDiskIoEntry(JsonObjectConst disk, void *context);
+
+    static void sensorFilter(JsonDocument &filter);
+    static void onSensorEntry(JsonObjectConst sensor, void *context);
+
+    static void processFilter(JsonDocument &filter);
+    static void onProcessEntry(JsonObjectConst process, void *context);
+
+    static void containerFilter(JsonDocument &filter);
+    static void onContainerEntry(JsonObjectConst container, void *context);
+
+    // Glances sends "3 days, 4:05:06", or a plain number of seconds; both
+    // come out in that style. Other strings are copied as they are, and
+    // anything else leaves out empty.
+    static void formatUptime(JsonVariantConst uptime, char *out, size_t size);
+};
+
+#endif
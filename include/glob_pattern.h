@@ -0,0 +1,31 @@
+#ifndef GLOB_PATTERN_H
+#define GLOB_PATTERN_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define GLOB_PATTERN_MAX 48
+
+// A pattern with an optional leading and/or trailing '*', compiled once into
+// the cheapest matching strategy so matching is a single compare or search.
+struct GlobPattern
+{
+    enum Kind : uint8_t
+    {
+        EXACT,
+        PREFIX,
+        SUFFIX,
+        CONTAINS,
+        ANY
+    };
+
+    Kind kind;
+    uint8_t length;
+    char literal[GLOB_PATTERN_MAX];
+
+    // Returns false for empty patterns, inner wildcards or overlong literals
+    bool compile(const char *pattern, size_t patternLength);
+    bool matches(const char *text) const;
+};
+
+#endif
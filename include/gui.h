@@ -3,6 +3,21 @@
 
 #include <lvgl.h>
 #include "config.h"
+#include "fs_classifier.h"
+#include "sensor_map.h"
+
+enum GuiPage
+{
+    PAGE_OVERVIEW,
+    PAGE_DRIVES,
+    PAGE_DISKIO,
+    PAGE_NETWORK,
+    PAGE_SENSORS,
+    PAGE_CORES,
+    PAGE_PROCESSES,
+    PAGE_CONTAINERS,
+    PAGE_COUNT
+};
 
 struct ArcWithLabel
 {
@@ -12,26 +27,23 @@ struct ArcWithLabel
 
 ArcWithLabel create_arc(lv_obj_t *parent, const char *text, lv_color_t color);
 lv_obj_t *create_button_label(lv_obj_t *parent, const char *text, const ThemeColors *theme);
-lv_obj_t *create_compact_label(lv_obj_t *parent, const char *text, const ThemeColors *theme);
-void update_compact_label(lv_obj_t *btn, const char *text);
 void update_arc_label(lv_obj_t *label, const char *text);
 
 void create_system_monitor_gui();
 
 void set_arc_value_animated(lv_obj_t *arc, int32_t value, uint32_t duration = 500);
 
-extern lv_obj_t *cpu_label;
-extern lv_obj_t *ram_label;
-extern lv_obj_t *disk_label;
-extern lv_obj_t *uptime_label;
-extern lv_obj_t *network_label;
-extern lv_obj_t *cores_label;
-extern lv_obj_t *total_ram_label;
-extern lv_obj_t *temp_label;
-extern lv_obj_t *load_label;
-extern lv_obj_t *cache_label;
-
-extern ArcWithLabel cpu_arc_obj;
-extern ArcWithLabel ram_arc_obj;
+void gui_show_page(GuiPage page);
+GuiPage gui_current_page();
+bool gui_find_page(const char *name, GuiPage &page);
+// Redraws the visible page from the latest data and frees detail pages that
+// have been hidden for a while
+void gui_refresh();
+lv_color_t sensor_level_color(SensorLevel level);
+// Alert banner over all pages; a tap dismisses it until reveal is set again
+void gui_show_alert(const char *text, bool reveal);
+void gui_hide_alert();
+// Status line along the bottom of all pages, e.g. while connecting; NULL hides it
+void gui_set_status(const char *text);
 
 #endif
\ No newline at end of file
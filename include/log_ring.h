@@ -0,0 +1,94 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LOG_RING_SLOTS 64      // entries kept; older ones are overwritten
+#define LOG_ARG_BYTES 64       // captured arguments per entry, strings included
+#define LOG_LINE_LENGTH 160    // formatted message
+#define LOG_DRAIN_PER_LOOP 4   // entries printed to Serial per drain() call
+#define LOG_SERIAL_BUFFER 1024 // Serial TX buffer the drain writes into
+
+enum LogLevel : uint8_t
+{
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_COUNT
+};
+
+enum LogModule : uint8_t
+{
+    LOG_MOD_SYSTEM,
+    LOG_MOD_WIFI,
+    LOG_MOD_GLANCES,
+    LOG_MOD_WEB,
+    LOG_MOD_MQTT,
+    LOG_MOD_ALERT,
+    LOG_MOD_COUNT
+};
+
+struct LogEntry
+{
+    uint32_t seq; // from 1, in the order entries were written
+    uint32_t ms;  // millis() when written
+    LogLevel level;
+    LogModule module;
+};
+
+// Log entries in a fixed ring of binary records. Writing only captures the
+// format pointer and the raw arguments; the text is formatted later, when the
+// entry is drained to Serial or read through /api/logs. Writers claim a slot
+// with one atomic increment and never wait, so any task can log. The write
+// path runs from flash, so IRAM_ATTR interrupt handlers, which can run while
+// the flash cache is off, must not call it.
+// Readers check a per-slot sequence number and skip entries that were
+// overwritten while being read.
+//
+// Formats must be string literals. Supported conversions are d i u x X o c
+// with the h, l, ll, z and j modifiers, f e g, s and p; strings are copied
+// into the entry, cut to the space that is left.
+class LogRing
+{
+public:
+    static bool enabled(LogLevel level, LogModule module);
+    static void write(LogLevel level, LogModule module, const char *format, ...)
+        __attribute__((format(printf, 3, 4)));
+
+    static LogLevel level(LogModule module);
+    static void setLevel(LogModule module, LogLevel level);
+    static void setAllLevels(LogLevel level);
+    static const char *levelName(LogLevel level);
+    static const char *moduleName(LogModule module);
+    static bool parseLevel(const char *name, LogLevel &level);
+    static bool parseModule(const char *name, LogModule &module);
+
+    // Sequence number of the newest entry, 0 before the first
+    static uint32_t head();
+    // Sequence number of the oldest entry still in the ring
+    static uint32_t oldest();
+    // False when the entry was overwritten or is still being written
+    static bool read(uint32_t seq, LogEntry &entry, char *text, size_t textSize);
+
+    // Prints pending entries while they fit in the Serial TX buffer, so it
+    // never waits on the UART. Call from loop().
+    static void drain();
+    // Entries overwritten before drain() printed them
+    static uint32_t dropped();
+};
+
+#define LOG_AT(level, module, ...)                          \
+    do                                                      \
+    {                                                       \
+        if (LogRing::enabled(level, module))                \
+            LogRing::write(level, module, __VA_ARGS__);     \
+    } while (0)
+
+#define LOG_E(module, ...) LOG_AT(LOG_LEVEL_ERROR, module, __VA_ARGS__)
+#define LOG_W(module, ...) LOG_AT(LOG_LEVEL_WARN, module, __VA_ARGS__)
+#define LOG_I(module, ...) LOG_AT(LOG_LEVEL_INFO, module, __VA_ARGS__)
+#define LOG_D(module, ...) LOG_AT(LOG_LEVEL_DEBUG, module, __VA_ARGS__)
+
+#endif
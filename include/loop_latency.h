@@ -0,0 +1,74 @@
+#ifndef LOOP_LATENCY_H
+#define LOOP_LATENCY_H
+
+#include <Arduino.h>
+#include "device_stats.h"
+
+#define LOOP_LATENCY_BUCKETS 96 // four per power of two, the last one open ended from ~30 s
+#define LOOP_STALL_HISTORY 8
+#define LOOP_WDT_TIMEOUT_S 15
+#define LOOP_IDLE_MAX_MS 5    // longest the loop sleeps waiting for LVGL's next timer
+
+// Durations in µs on a log-linear scale, so quantiles are within 25% at any
+// magnitude without keeping samples
+struct LatencyHistogram
+{
+    uint32_t count;
+    uint32_t maxUs;
+    uint32_t lastUs;
+    uint64_t sumUs;
+    uint32_t buckets[LOOP_LATENCY_BUCKETS];
+};
+
+// A stage that ran past its budget; STAGE_OTHER is loop() time outside the
+// timed stages
+struct LoopStall
+{
+    uint32_t atMs; // millis() when the stage ended
+    uint32_t us;
+    LoopStage stage;
+};
+
+// Latency of each loop() iteration and of each stage in it, and the task
+// watchdog that guards the loop task. The watchdog is fed between stages and
+// by long operations, so only a single step that hangs trips it.
+class LoopLatency
+{
+public:
+    // Subscribes the calling task; call from setup(), which runs in the loop task
+    static void beginWatchdog();
+    static bool watchdogActive();
+    static void feed();
+
+    static void beginIteration();
+    // Records the iteration and the time it spent outside the timed stages
+    static void endIteration();
+    static void addStage(LoopStage stage, uint32_t us);
+
+    static const LatencyHistogram &iteration();
+    static const LatencyHistogram &stage(LoopStage stage);
+    // Upper limit of the bucket holding quantile q, capped at the maximum seen
+    static uint32_t quantileUs(const LatencyHistogram &histogram, float q);
+    static uint32_t budgetUs(LoopStage stage);
+    static uint32_t overruns(LoopStage stage);
+    // Most recent stalls, newest first
+    static size_t stallCount();
+    static const LoopStall &stall(size_t index);
+    // Why the device last restarted, e.g. "task_wdt" after the watchdog fired
+    static const char *resetReason();
+    static void reset();
+};
+
+// Adds the lifetime of the object to a loop stage
+class StageTimer
+{
+public:
+    explicit StageTimer(LoopStage stage) : stage(stage), start(micros()) {}
+    ~StageTimer() { LoopLatency::addStage(stage, micros() - start); }
+
+private:
+    LoopStage stage;
+    uint32_t start;
+};
+
+#endif
@@ -46,17 +46,22 @@
  *=========================*/
 
 /*1: use custom malloc/free, 0: use the built-in `lv_mem_alloc()` and `lv_mem_free()`*/
-#define LV_MEM_CUSTOM 1
+/*The built-in TLSF pool keeps UI objects out of the heap that WiFi and HTTP churn, and
+ *lv_mem_monitor() reports its use and fragmentation on /api/telemetry*/
+#define LV_MEM_CUSTOM 0
 #if LV_MEM_CUSTOM == 0
     /*Size of the memory available for `lv_mem_alloc()` in bytes (>= 2kB)*/
-    #define LV_MEM_SIZE (40U * 1024U)          /*[bytes]*/
+    /*Sized for the overview plus the 40-row drives page; check lvgl.maxUsed after changing pages*/
+    #define LV_MEM_SIZE (64U * 1024U)          /*[bytes]*/
 
     /*Set an address for the memory pool instead of allocating it as a normal array. Can be in external SRAM too.*/
     #define LV_MEM_ADR 0     /*0: unused*/
     /*Instead of an address give a memory allocator that will be called to get a memory pool for LVGL. E.g. my_malloc*/
     #if LV_MEM_ADR == 0
-        //#define LV_MEM_POOL_INCLUDE your_alloc_library  /* Uncomment if using an external allocator*/
-        //#define LV_MEM_POOL_ALLOC   your_alloc          /* Uncomment if using an external allocator*/
+        /*Taken from internal RAM once in lv_init(), which setup() calls before WiFi starts, while the
+         *heap is still in one piece. Aborts the boot if the pool does not fit.*/
+        #define LV_MEM_POOL_INCLUDE <lvgl_pool.h>
+        #define LV_MEM_POOL_ALLOC(size) lvgl_pool_alloc(size)
     #endif
 
 #else       /*LV_MEM_CUSTOM*/
@@ -436,7 +441,7 @@
 
 #define LV_USE_ANIMIMG    0
 
-#define LV_USE_BAR        0
+#define LV_USE_BAR        1
 
 #define LV_USE_BTN        1
 
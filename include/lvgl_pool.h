@@ -0,0 +1,19 @@
+#ifndef LVGL_POOL_H
+#define LVGL_POOL_H
+
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+
+// LVGL's LV_MEM_POOL_ALLOC. Included from LVGL's C sources, so it stays
+// plain C. Without its pool LVGL would write through a NULL pointer on the
+// first object it creates, so a failed allocation stops the boot with the
+// reason in the panic output instead.
+static inline void *lvgl_pool_alloc(size_t size)
+{
+    void *pool = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (pool == NULL)
+        esp_system_abort("LVGL pool: not enough internal RAM for LV_MEM_SIZE");
+    return pool;
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef METRIC_FORMAT_H
+#define METRIC_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FORMAT_SCALE_UP 99950 // hundredths of a unit that no longer fit three digits
+#define FORMAT_SCALE_DOWN 90  // hundredths below which a scaled value drops a unit
+
+enum UnitBase : uint8_t
+{
+    UNIT_IEC, // 1024, suffixes K M G T P
+    UNIT_SI   // 1000, suffixes k M G T P
+};
+
+// Unit a label last showed, kept by the caller for each label. A value
+// moves up a unit once it needs four digits and back down only below 0.9
+// of the larger unit, so a rate hovering near 1 M does not flicker between
+// "1.00M" and "999K". Zero-initialized, it starts at bytes.
+struct UnitScale
+{
+    uint8_t unit;
+};
+
+// Number formatting for the display and the web pages, with integer
+// arithmetic only: no snprintf, no float printing and no allocation.
+// Every function writes a terminated string of at most size - 1 characters
+// and returns its length. NAN prints "--", and so does a number that does
+// not fit the buffer; only text() cuts its string to fit.
+//
+// Scaled sizes and rates keep three significant digits ("1.23M", "12.3M",
+// "123M"), so their width does not change with the value.
+class MetricFormat
+{
+public:
+    static size_t bytes(char *buf, size_t size, uint64_t bytes, UnitBase base = UNIT_IEC,
+                        UnitScale *scale = nullptr);
+    // Bytes per second, IEC, without a "/s" suffix
+    static size_t rate(char *buf, size_t size, float bytesPerSec, UnitScale *scale = nullptr);
+    static size_t fixed(char *buf, size_t size, float value, uint8_t decimals);
+    static size_t percent(char *buf, size_t size, float value, uint8_t decimals);
+    // Whole degrees: "45°C"
+    static size_t temperature(char *buf, size_t size, float celsius);
+    // Glances' uptime style: "3 days, 4:05:06", or "4:05:06" under a day
+    static size_t duration(char *buf, size_t size, uint32_t seconds);
+    // Reads the duration() style back; false for anything else
+    static bool parseDuration(const char *text, uint32_t &seconds);
+
+    static size_t text(char *buf, size_t size, const char *text);
+    // Right-aligns the string already in buf to width with leading spaces
+    static size_t padLeft(char *buf, size_t size, size_t width);
+};
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef METRIC_REGISTRY_H
+#define METRIC_REGISTRY_H
+
+#include <lvgl.h>
+#include <math.h>
+#include "glances_api.h"
+#include "gui.h"
+#include "metric_format.h"
+#include "metrics_history.h"
+
+#define METRIC_MAX_KEYS_PER_ENDPOINT 4
+
+enum MetricKind : uint8_t
+{
+    METRIC_NUMBER, // stored scaled in value
+    METRIC_UPTIME  // the whole response, shortened into HostMetrics::uptime
+};
+
+enum MetricWidget : uint8_t
+{
+    WIDGET_NONE,
+    WIDGET_ARC, // gauge with a title, the value and a detail line
+    WIDGET_CARD // icon and value text
+};
+
+enum MetricColumn : uint8_t
+{
+    COLUMN_LEFT,
+    COLUMN_RIGHT
+};
+
+typedef void (*MetricFormatter)(char *buf, size_t size, const HostMetrics &metrics);
+typedef SensorLevel (*MetricLevel)(const HostMetrics &metrics);
+
+// One value on the overview: where it comes from and how it is shown.
+// Values with an endpoint are read by the fetch plan below; the others are
+// filled by the streamed parsers (sensors, filesystems, network).
+struct MetricDesc
+{
+    const char *endpoint;
+    const char *key; // member of the endpoint's object; NULL for the whole response
+    MetricKind kind;
+    float scale;
+    float HostMetrics::*value; // NAN until fetched; the widget waits for it
+    MetricId history;          // METRIC_COUNT when not kept; streamed values record their own
+
+    MetricWidget widget;
+    MetricColumn column;
+    const char *title; // arc title or card icon; a card without one centers a single label
+    lv_color_t ThemeColors::*color; // arc color
+    const char *placeholder;
+    MetricFormatter format;
+    MetricFormatter detail; // arc detail line
+    MetricLevel level;      // colors the value text; NULL keeps the theme color
+    GuiPage page;           // opened by tapping the widget
+};
+
+// Overview formatters, called for every widget on every refresh, so they
+// go through MetricFormat rather than snprintf
+inline void format_cpu(char *buf, size_t size, const HostMetrics &m)
+{
+    MetricFormat::percent(buf, size, m.cpu_percent, 0);
+}
+
+inline void format_cores(char *buf, size_t size, const HostMetrics &m)
+{
+    if (isnan(m.cpu_cores))
+    {
+        MetricFormat::text(buf, size, "--");
+        return;
+    }
+    size_t len = MetricFormat::fixed(buf, size, m.cpu_cores, 0);
+    MetricFormat::text(buf + len, size - len, " cores");
+}
+
+inline void format_mem(char *buf, size_t size, const HostMetrics &m)
+{
+    MetricFormat::percent(buf, size, m.mem_percent, 0);
+}
+
+inline void format_mem_total(char *buf, size_t size, const HostMetrics &m)
+{
+    if (isnan(m.mem_total_gb))
+    {
+        MetricFormat::text(buf, size, "--");
+        return;
+    }
+    size_t len = MetricFormat::text(buf, size, "/ ");
+    len += MetricFormat::fixed(buf + len, size - len, m.mem_total_gb, 1);
+    MetricFormat::text(buf + len, size - len, " GB");
+}
+
+inline void format_temp(char *buf, size_t size, const HostMetrics &m)
+{
+    MetricFormat::temperature(buf, size, m.temperature);
+}
+
+inline void format_load(char *buf, size_t size, const HostMetrics &m)
+{
+    size_t len = MetricFormat::text(buf, size, "Load: ");
+    MetricFormat::fixed(buf + len, size - len, m.load1, 1);
+}
+
+inline void format_uptime(char *buf, size_t size, const HostMetrics &m)
+{
+    size_t len = MetricFormat::text(buf, size, " ");
+    MetricFormat::text(buf + len, size - len, m.uptime);
+}
+
+inline void format_drives(char *buf, size_t size, const HostMetrics &m)
+{
+    size_t len = MetricFormat::text(buf, size, "Drives: ");
+    MetricFormat::percent(buf + len, size - len, m.disk_percent, 1);
+}
+
+inline void format_cache(char *buf, size_t size, const HostMetrics &m)
+{
+    size_t len = MetricFormat::text(buf, size, "Cache: ");
+    MetricFormat::percent(buf + len, size - len, m.cache_percent, 1);
+}
+
+// Each direction keeps its own unit so neither flickers between K and M
+inline void format_network(char *buf, size_t size, const HostMetrics &m)
+{
+    static UnitScale down, up;
+    size_t len = MetricFormat::text(buf, size, LV_SYMBOL_DOWNLOAD " ");
+    len += MetricFormat::rate(buf + len, size - len, m.net_rx_rate, &down);
+    len += MetricFormat::text(buf + len, size - len, "    " LV_SYMBOL_UPLOAD " ");
+    MetricFormat::rate(buf + len, size - len, m.net_tx_rate, &up);
+}
+
+// Level of the first mapped sensor that is present, which feeds the
+// host temperature
+inline SensorLevel host_temp_level(const HostMetrics &)
+{
+    for (size_t i = 0; i < SensorMap::slotCount(); i++)
+    {
+        const SensorReading &reading = SensorMap::reading(i);
+        if (reading.present)
+            return reading.level;
+    }
+    return SENSOR_LEVEL_OK;
+}
+
+template <float HostMetrics::*Value, int Warn, int Crit>
+SensorLevel level_above(const HostMetrics &m)
+{
+    return m.*Value >= Crit ? SENSOR_LEVEL_CRIT : m.*Value >= Warn ? SENSOR_LEVEL_WARN : SENSOR_LEVEL_OK;
+}
+
+// The overview, in layout order within each column. Adding a value is one
+// row here plus its HostMetrics member.
+inline constexpr MetricDesc metric_registry[] = {
+    {"/api/4/cpu", "total", METRIC_NUMBER, 1.0f, &HostMetrics::cpu_percent, METRIC_HOST_CPU,
+     WIDGET_ARC, COLUMN_LEFT, "CPU", &ThemeColors::cpu_color, "--", format_cpu, format_cores, NULL, PAGE_CORES},
+    {"/api/4/cpu", "cpucore", METRIC_NUMBER, 1.0f, &HostMetrics::cpu_cores, METRIC_COUNT,
+     WIDGET_NONE, COLUMN_LEFT, NULL, NULL, NULL, NULL, NULL, NULL, PAGE_OVERVIEW},
+    {"/api/4/mem", "percent", METRIC_NUMBER, 1.0f, &HostMetrics::mem_percent, METRIC_HOST_MEM,
+     WIDGET_ARC, COLUMN_RIGHT, "RAM", &ThemeColors::ram_color, "--", format_mem, format_mem_total, NULL,
+     PAGE_PROCESSES},
+    {"/api/4/mem", "total", METRIC_NUMBER, 1.0f / (1024.0f * 1024.0f * 1024.0f), &HostMetrics::mem_total_gb,
+     METRIC_COUNT, WIDGET_NONE, COLUMN_RIGHT, NULL, NULL, NULL, NULL, NULL, NULL, PAGE_OVERVIEW},
+    {NULL, NULL, METRIC_NUMBER, 1.0f, &HostMetrics::temperature, METRIC_COUNT,
+     WIDGET_CARD, COLUMN_LEFT, LV_SYMBOL_WARNING, NULL, "-- °C", format_temp, NULL, host_temp_level, PAGE_SENSORS},
+    {"/api/4/load", "min1", METRIC_NUMBER, 1.0f, &HostMetrics::load1, METRIC_HOST_LOAD,
+     WIDGET_CARD, COLUMN_LEFT, LV_SYMBOL_CHARGE, NULL, "Load: -.-", format_load, NULL, NULL, PAGE_CORES},
+    {"/api/4/uptime", NULL, METRIC_UPTIME, 1.0f, NULL, METRIC_COUNT,
+     WIDGET_CARD, COLUMN_LEFT, LV_SYMBOL_POWER, NULL, " ---", format_uptime, NULL, NULL, PAGE_PROCESSES},
+    {NULL, NULL, METRIC_NUMBER, 1.0f, &HostMetrics::disk_percent, METRIC_COUNT,
+     WIDGET_CARD, COLUMN_RIGHT, LV_SYMBOL_DRIVE, NULL, "Drives: ---%", format_drives, NULL,
+     level_above<&HostMetrics::disk_percent, 90, 95>, PAGE_DRIVES},
+    {NULL, NULL, METRIC_NUMBER, 1.0f, &HostMetrics::cache_percent, METRIC_COUNT,
+     WIDGET_CARD, COLUMN_RIGHT, LV_SYMBOL_SAVE, NULL, "Cache: ---%", format_cache, NULL,
+     level_above<&HostMetrics::cache_percent, 90, 95>, PAGE_DRIVES},
+    {NULL, NULL, METRIC_NUMBER, 1.0f, &HostMetrics::net_rx_rate, METRIC_COUNT,
+     WIDGET_CARD, COLUMN_RIGHT, NULL, NULL, LV_SYMBOL_DOWNLOAD " --- " LV_SYMBOL_UPLOAD " ---", format_network,
+     NULL, NULL, PAGE_NETWORK},
+};
+
+inline constexpr size_t metric_count = sizeof(metric_registry) / sizeof(metric_registry[0]);
+
+// The fetch plan: each endpoint the registry reads, once, with the rows it
+// fills. Built by the compiler from the table above.
+struct MetricFetchStep
+{
+    const char *endpoint;
+    uint8_t rowCount;
+    uint8_t rows[METRIC_MAX_KEYS_PER_ENDPOINT];
+};
+
+constexpr bool metric_same_text(const char *a, const char *b)
+{
+    while (*a && *a == *b)
+    {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+// The row that first names its endpoint starts a fetch step
+constexpr bool metric_starts_step(size_t row)
+{
+    if (!metric_registry[row].endpoint)
+        return false;
+    for (size_t i = 0; i < row; i++)
+    {
+        if (metric_registry[i].endpoint && metric_same_text(metric_registry[i].endpoint, metric_registry[row].endpoint))
+            return false;
+    }
+    return true;
+}
+
+constexpr size_t metric_step_count()
+{
+    size_t count = 0;
+    for (size_t row = 0; row < metric_count; row++)
+        count += metric_starts_step(row);
+    return count;
+}
+
+template <size_t N>
+struct MetricFetchPlan
+{
+    MetricFetchStep steps[N];
+};
+
+constexpr MetricFetchPlan<metric_step_count()> metric_make_fetch_plan()
+{
+    MetricFetchPlan<metric_step_count()> plan{};
+    size_t step = 0;
+    for (size_t row = 0; row < metric_count; row++)
+    {
+        if (!metric_starts_step(row))
+            continue;
+        MetricFetchStep &s = plan.steps[step++];
+        s.endpoint = metric_registry[row].endpoint;
+        for (size_t other = row; other < metric_count; other++)
+        {
+            const MetricDesc &d = metric_registry[other];
+            if (d.endpoint && metric_same_text(d.endpoint, s.endpoint) && s.rowCount < METRIC_MAX_KEYS_PER_ENDPOINT)
+                s.rows[s.rowCount++] = other;
+        }
+    }
+    return plan;
+}
+
+inline constexpr auto metric_fetch_plan = metric_make_fetch_plan();
+inline constexpr size_t metric_fetch_steps = metric_step_count();
+
+// Checks the table once per build instead of on every update
+constexpr bool metric_registry_valid()
+{
+    for (size_t row = 0; row < metric_count; row++)
+    {
+        const MetricDesc &d = metric_registry[row];
+        if ((d.kind == METRIC_NUMBER) != (d.value != NULL))
+            return false;
+        if (d.endpoint ? d.kind == METRIC_NUMBER && !d.key : d.history != METRIC_COUNT)
+            return false;
+        if (d.widget != WIDGET_NONE && (!d.format || !d.placeholder))
+            return false;
+        if (d.widget == WIDGET_ARC && (!d.title || !d.color || !d.detail))
+            return false;
+        size_t keys = 0;
+        for (size_t other = 0; d.endpoint && other < metric_count; other++)
+        {
+            if (metric_registry[other].endpoint && metric_same_text(metric_registry[other].endpoint, d.endpoint))
+                keys++;
+        }
+        if (keys > METRIC_MAX_KEYS_PER_ENDPOINT || (d.endpoint && !d.key && keys > 1))
+            return false;
+    }
+    return true;
+}
+
+static_assert(metric_registry_valid(), "metric_registry: numbers need a value and, when fetched, a key; only "
+                                       "fetched values keep history; widgets need a formatter, arcs a title, "
+                                       "color and detail; an endpoint has up to METRIC_MAX_KEYS_PER_ENDPOINT keys "
+                                       "or one whole-response row");
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef METRICS_HISTORY_H
+#define METRICS_HISTORY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Round-robin metric history. Every metric keeps a high resolution ring of raw
+// samples plus a ring of consolidated min/avg/max buckets, both indexed by
+// absolute time slot so gaps show up as missing values. All storage is static.
+#define HISTORY_HIRES_STEP_MS 2000UL
+#define HISTORY_HIRES_SAMPLES 150                 // 5 minutes
+#define HISTORY_BUCKET_STEP_MS (15UL * 60 * 1000) // 15 minutes
+#define HISTORY_BUCKETS 96                        // 24 hours
+
+enum MetricId : uint8_t
+{
+    METRIC_HOST_CPU,
+    METRIC_HOST_MEM,
+    METRIC_HOST_LOAD,
+    METRIC_HOST_TEMP,
+    METRIC_HOST_NET_RX,
+    METRIC_HOST_NET_TX,
+    METRIC_DEVICE_CPU,
+    METRIC_DEVICE_HEAP,
+    METRIC_DEVICE_RSSI,
+    METRIC_DEVICE_TEMP,
+    METRIC_COUNT
+};
+
+struct HistoryBucket
+{
+    float min;
+    float avg;
+    float max;
+};
+
+struct MetricSeries
+{
+    float hires[HISTORY_HIRES_SAMPLES];
+    HistoryBucket buckets[HISTORY_BUCKETS];
+    uint32_t hiresSlot;
+    uint32_t bucketSlot;
+    float accMin;
+    float accMax;
+    float accSum;
+    uint16_t accCount;
+    bool started;
+};
+
+#define HISTORY_MEMORY_BYTES (sizeof(MetricSeries) * METRIC_COUNT)
+
+typedef void (*MetricObserver)(MetricId id, float value, uint64_t nowMs);
+
+class MetricsHistory
+{
+public:
+    static void record(MetricId id, float value, uint64_t nowMs);
+    // Called with every recorded sample, e.g. to evaluate alerts
+    static void setObserver(MetricObserver observer);
+
+    // Copy samples newer than sinceMs, oldest first. startMs receives the
+    // timestamp of the first copied slot; missing samples are NAN.
+    static size_t copyHires(MetricId id, uint64_t sinceMs, uint64_t &startMs, float *out, size_t maxCount);
+    // Same for consolidated buckets, including the bucket still being filled.
+    static size_t copyBuckets(MetricId id, uint64_t sinceMs, uint64_t &startMs, HistoryBucket *out, size_t maxCount);
+
+    static const char *metricName(MetricId id);
+    static bool findMetric(const char *name, MetricId &id);
+    static void clear();
+
+private:
+    static MetricSeries series[METRIC_COUNT];
+    static MetricObserver observer;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MQTT_PUBLISHER_H
+#define MQTT_PUBLISHER_H
+
+#include <stdint.h>
+
+#define MQTT_MIN_PUBLISH_INTERVAL_MS 5000
+#define MQTT_MAX_PUBLISH_INTERVAL_MS 60000
+#define MQTT_RECONNECT_MIN_MS 1000
+#define MQTT_RECONNECT_MAX_MS 60000
+#define MQTT_BUFFER_SIZE 1024
+#define MQTT_CONNECT_STACK 4096 // DNS, TCP connect and CONNACK run in their own task
+
+class MqttPublisher
+{
+public:
+    static void begin();
+    static void loop();
+    // Call after the broker settings change to drop the current session
+    static void reconfigure();
+    // Request an immediate state publish, e.g. after a command was applied
+    static void requestPublish();
+    static bool publish(const char *subtopic, const char *payload, bool retained = false);
+    static bool isConnected();
+
+private:
+    // Starts a connect in the background; loop() picks up the result
+    static void connect();
+    static void connectTask(void *);
+    static void finishConnect();
+    static void publishDiscovery();
+    static void publishState(bool force);
+    static void onMessage(char *topic, uint8_t *payload, unsigned int length);
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef NET_METER_H
+#define NET_METER_H
+
+#include "glob_pattern.h"
+
+#define NET_MAX_PATTERNS 8
+#define NET_MAX_INTERFACES 16
+#define NET_INDEX_SLOTS 32
+#define NET_INTERFACES_MAX_LENGTH 96
+#define NET_NAME_LENGTH 24
+#define NET_PEAK_HOLD_MS 60000
+
+enum NetMode : uint8_t
+{
+    NET_MODE_FIRST, // the interface matching the earliest pattern
+    NET_MODE_SUM    // all matching interfaces added up
+};
+
+struct NetRates
+{
+    bool valid;
+    float rxRate;
+    float txRate;
+    float rxPeak;
+    float txPeak;
+    uint8_t interfaceCount;
+    char name[NET_NAME_LENGTH];
+};
+
+struct NetInterfaceRate
+{
+    const char *name;
+    bool valid;
+    float rxRate;
+    float txRate;
+};
+
+// Turns Glances' cumulative interface counters into rates measured over our
+// own poll interval. Interfaces are selected by a ',' separated list of
+// patterns in priority order; a leading '!' excludes. Per-interface counters
+// from the previous payload are kept in a small hash index that is rebuilt
+// once per payload, so looking one up never walks the whole list.
+class NetMeter
+{
+public:
+    static const char *defaultPatterns();
+    // Keeps the previous selection and fills error when the text is invalid
+    static bool compile(const char *patterns, NetMode mode, char *error, size_t errorSize);
+    // Checks the patterns without applying them
+    static bool validate(const char *patterns, char *error, size_t errorSize);
+    static const char *modeName(NetMode mode);
+    static bool parseMode(const char *name, NetMode &mode);
+
+    // nowUs must be monotonic and taken when the payload arrived
+    static void beginPass(uint64_t nowUs);
+    static void addInterface(const char *name, uint64_t rxBytes, uint64_t txBytes);
+    // Returns false until an interface has been seen in two passes
+    static bool endPass();
+    static const NetRates &rates();
+    // Matching interfaces of the last complete payload
+    static size_t interfaceCount();
+    static NetInterfaceRate interfaceRate(size_t index);
+    static void reset();
+};
+
+#endif
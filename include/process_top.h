@@ -0,0 +1,47 @@
+#ifndef PROCESS_TOP_H
+#define PROCESS_TOP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PROCESS_TOP_N 10
+#define PROCESS_NAME_LENGTH 20
+
+enum ProcessSort : uint8_t
+{
+    PROCESS_SORT_CPU,
+    PROCESS_SORT_MEM
+};
+
+struct ProcessEntry
+{
+    char name[PROCESS_NAME_LENGTH];
+    uint32_t pid;
+    float cpu;
+    float mem;
+};
+
+// Keeps the N heaviest processes of a process list in a fixed-size min-heap,
+// so memory stays the same whether the host runs 50 or 5,000 processes. The
+// lightest kept entry sits at the root and is the only one compared against
+// each new process.
+class ProcessTop
+{
+public:
+    static void setSort(ProcessSort sort);
+    static ProcessSort sort();
+    static const char *sortName(ProcessSort sort);
+    static bool parseSort(const char *name, ProcessSort &sort);
+
+    static void beginPass();
+    static void add(const char *name, uint32_t pid, float cpu, float mem);
+    // Orders the kept entries heaviest first
+    static void endPass(uint32_t parseUs);
+
+    static size_t count();
+    static const ProcessEntry &entry(size_t index);
+    static uint32_t processCount();
+    static uint32_t parseUs();
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef SENSOR_MAP_H
+#define SENSOR_MAP_H
+
+#include "glob_pattern.h"
+
+#define SENSOR_MAX_SLOTS 6
+#define SENSOR_MAX_PATTERNS 4
+#define SENSOR_NAME_LENGTH 12
+#define SENSOR_LABEL_LENGTH 24
+#define SENSOR_MAP_MAX_LENGTH 192
+#define SENSOR_DEFAULT_WARN 60
+#define SENSOR_DEFAULT_CRIT 80
+
+enum SensorLevel : uint8_t
+{
+    SENSOR_LEVEL_OK,
+    SENSOR_LEVEL_WARN,
+    SENSOR_LEVEL_CRIT
+};
+
+struct SensorSlot
+{
+    char name[SENSOR_NAME_LENGTH];
+    uint8_t patternCount;
+    GlobPattern patterns[SENSOR_MAX_PATTERNS];
+    float warn;
+    float crit;
+};
+
+struct SensorReading
+{
+    bool present;
+    SensorLevel level;
+    float value;
+    float min; // since boot or the last resetExtremes()
+    float max;
+    char label[SENSOR_LABEL_LENGTH];
+};
+
+// Maps Glances temperature sensors to named slots. The map text has entries
+// "name=pattern|pattern@warn/crit" separated by ';'; each slot takes the
+// first temperature sensor whose label matches one of its patterns.
+//
+// The sensors array can be long, so matching labels against patterns is done
+// once: the resulting array position of every slot is remembered and reused
+// until the number of entries or a mapped label changes.
+class SensorMap
+{
+public:
+    static const char *defaultMap();
+    // Keeps the previous map and fills error when the text is invalid
+    static bool compile(const char *map, char *error, size_t errorSize);
+    // Checks the map without applying it
+    static bool validate(const char *map, char *error, size_t errorSize);
+    static size_t slotCount();
+    static const SensorSlot &slot(size_t index);
+
+    static void beginPass();
+    static void addSensor(const char *label, const char *type, float value);
+    static void endPass();
+
+    static const SensorReading &reading(size_t index);
+    static SensorLevel levelOf(size_t index, float value);
+    static uint32_t rebuildCount();
+    static void resetExtremes();
+};
+
+#endif
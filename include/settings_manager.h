@@ -3,6 +3,7 @@
 #include <Preferences.h>
 #include <functional>
 #include "config.h"
+#include "touch.h"
 
 class SettingsManager {
 public:
@@ -12,16 +13,49 @@ public:
     static bool getDarkMode();
     static void setDarkMode(bool isDark);
     static void saveSettings();
+    // Setters called between these two save the record once, and call the
+    // theme callback at most once, in commit()
+    static void beginUpdate();
+    static void commit();
     static void updateThemeColor(const char* colorName, uint32_t color);
     static const ThemeColors& getCurrentTheme();
     static void setThemeChangeCallback(ThemeCallback callback) {
         themeCallback = callback;
     }
     static void clearSavedColors();
+    static void resetCurrentTheme();
     static const String& getGlancesHost();
     static uint16_t getGlancesPort();
     static void setGlancesHost(const String& host);
     static void setGlancesPort(uint16_t port);
+    static uint32_t getLoadTimeUs();
+    static const char* getMqttHost();
+    static uint16_t getMqttPort();
+    static const char* getMqttUser();
+    static const char* getMqttPassword();
+    static const char* getMqttTopic();
+    static void setMqttHost(const String& host);
+    static void setMqttPort(uint16_t port);
+    static void setMqttCredentials(const String& user, const String& password);
+    static void setMqttTopic(const String& topic);
+    // Empty means the built-in filesystem classification rules
+    static const char* getFsRules();
+    static void setFsRules(const String& rules);
+    // Empty means the built-in interface patterns; mode is a NetMode
+    static const char* getNetInterfaces();
+    static uint8_t getNetMode();
+    static void setNetInterfaces(const String& patterns, uint8_t mode);
+    // Empty means the built-in temperature sensor map
+    static const char* getSensorMap();
+    static void setSensorMap(const String& map);
+    static const TouchCalibration& getTouchCalibration();
+    static void setTouchCalibration(const TouchCalibration& calibration);
+    // Empty means the built-in alert rules
+    static const char* getAlertRules();
+    static void setAlertRules(const String& rules);
+    // Empty disables webhook notifications
+    static const char* getAlertWebhook();
+    static void setAlertWebhook(const String& url);
 
     static ThemeCallback themeCallback;
 
@@ -29,6 +63,17 @@ private:
     static Preferences preferences;
     static bool darkMode;
     static void loadSettings();
+    static bool migrateLegacyKeys();
+    static void removeLegacyBench();
+#ifdef SETTINGS_LEGACY_BENCH
+    static void measureLegacyLoad();
+#endif
+    static void applyRecord();
+    static void changed(bool theme);
     static String glancesHost;
     static uint16_t glancesPort;
-};
\ No newline at end of file
+    static uint32_t loadTimeUs;
+    static bool updating;
+    static bool pendingSave;
+    static bool pendingTheme;
+};
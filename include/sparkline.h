@@ -0,0 +1,16 @@
+#ifndef SPARKLINE_H
+#define SPARKLINE_H
+
+#include <lvgl.h>
+
+#define SPARKLINE_MAX_POINTS 60
+
+// Small line graph drawn by a custom draw routine, scaled to the largest
+// value shown. The values are copied into the object, which frees them when
+// it is deleted.
+lv_obj_t *sparkline_create(lv_obj_t *parent);
+// values are oldest first; only the last SPARKLINE_MAX_POINTS are kept
+void sparkline_set_values(lv_obj_t *spark, const float *values, uint16_t count);
+void sparkline_set_color(lv_obj_t *spark, lv_color_t color);
+
+#endif
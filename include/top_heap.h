@@ -0,0 +1,102 @@
+#ifndef TOP_HEAP_H
+#define TOP_HEAP_H
+
+#include <stddef.h>
+
+// Fixed-capacity min-heap that keeps the N heaviest entries pushed into it.
+// The lightest kept entry sits at the root, so each new entry is compared
+// against that one only. Lighter(a, b) is true when a ranks below b.
+template <typename Entry, size_t N, bool (*Lighter)(const Entry &, const Entry &)>
+class TopHeap
+{
+public:
+    void clear()
+    {
+        used = 0;
+    }
+
+    size_t count() const
+    {
+        return used;
+    }
+
+    const Entry *data() const
+    {
+        return entries;
+    }
+
+    // True when push() would keep candidate, so callers can skip filling in
+    // the rest of an entry that is about to be dropped
+    bool keeps(const Entry &candidate) const
+    {
+        return used < N || Lighter(entries[0], candidate);
+    }
+
+    void push(const Entry &candidate)
+    {
+        if (used < N)
+        {
+            entries[used] = candidate;
+            siftUp(used++);
+        }
+        else if (Lighter(entries[0], candidate))
+        {
+            entries[0] = candidate;
+            siftDown(0, used);
+        }
+    }
+
+    // Heap sort: repeatedly move the lightest entry to the end, leaving the
+    // array ordered heaviest first. The heap is no longer valid afterwards.
+    void sortHeaviestFirst()
+    {
+        for (size_t n = used; n > 1; n--)
+        {
+            swap(entries[0], entries[n - 1]);
+            siftDown(0, n - 1);
+        }
+    }
+
+private:
+    Entry entries[N];
+    size_t used = 0;
+
+    static void swap(Entry &a, Entry &b)
+    {
+        Entry tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    void siftDown(size_t i, size_t count)
+    {
+        while (true)
+        {
+            size_t smallest = i;
+            size_t left = 2 * i + 1;
+            size_t right = left + 1;
+            if (left < count && Lighter(entries[left], entries[smallest]))
+                smallest = left;
+            if (right < count && Lighter(entries[right], entries[smallest]))
+                smallest = right;
+            if (smallest == i)
+                return;
+            swap(entries[i], entries[smallest]);
+            i = smallest;
+        }
+    }
+
+    void siftUp(size_t i)
+    {
+        while (i > 0)
+        {
+            size_t parent = (i - 1) / 2;
+            if (!Lighter(entries[i], entries[parent]))
+                return;
+            swap(entries[parent], entries[i]);
+            i = parent;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef TOUCH_H
+#define TOUCH_H
+
+#include <lvgl.h>
+
+// XPT2046 on the CYD sits on its own SPI bus, separate from the display
+#define TOUCH_SCLK 25
+#define TOUCH_MISO 39
+#define TOUCH_MOSI 32
+#define TOUCH_CS 33
+#define TOUCH_IRQ 36
+#define TOUCH_SPI_FREQUENCY 2000000
+
+// Default raw ADC range of the panel edges, used to map to screen pixels
+#define TOUCH_X_MIN 200
+#define TOUCH_X_MAX 3700
+#define TOUCH_Y_MIN 240
+#define TOUCH_Y_MAX 3800
+// Smallest raw span accepted for a calibrated axis
+#define TOUCH_MIN_SPAN 1000
+
+#define TOUCH_Z_THRESHOLD 400   // pressure below this is not a touch
+#define TOUCH_RELEASE_READS 2   // empty reads in a row before reporting a release
+#define TOUCH_JITTER_PX 2       // moves this small are ignored while held
+#define TOUCH_READ_PERIOD_MS 10 // read period while the screen is touched
+// A response later than this is not attributed to the touch
+#define TOUCH_RESPONSE_TIMEOUT_US 500000
+
+// Raw values of the left/right and top/bottom screen edges. A min larger
+// than its max flips the axis.
+struct TouchCalibration
+{
+    uint16_t xMin;
+    uint16_t xMax;
+    uint16_t yMin;
+    uint16_t yMax;
+};
+
+struct TouchStats
+{
+    uint32_t presses;
+    uint32_t wakeups;  // PENIRQ edges that restarted reading
+    uint32_t spiReads; // controller reads since boot
+    int16_t rawX;      // last pressed point before calibration
+    int16_t rawY;
+    uint32_t inputUs;  // PENIRQ to the first LVGL read of the last press
+    uint32_t inputMaxUs;
+    uint32_t responseUs; // PENIRQ to the next display refresh
+    uint32_t responseAvgUs;
+    uint32_t responseMaxUs;
+};
+
+// Registers the touch panel as an LVGL pointer input device. The panel is
+// only read over SPI while its PENIRQ line reports a touch; the LVGL read
+// timer is paused the rest of the time.
+void init_touch();
+// Call from loop() before lv_timer_handler()
+void touch_service();
+void touch_set_calibration(const TouchCalibration &calibration);
+const TouchCalibration &touch_default_calibration();
+bool touch_calibration_valid(const TouchCalibration &calibration);
+const TouchStats &touch_stats();
+
+#endif
@@ -5,6 +5,7 @@
 
 void setupWebServer();
 void handleWebServer();
+void updateDeviceHistory();
 void updateDisplayTheme(bool isDark);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <stdint.h>
+
+// A join on the remembered channel and BSSID that has not connected by then
+// falls back to a full scan
+#define WIFI_HINT_TIMEOUT_MS 3000
+#define WIFI_CONNECT_TIMEOUT_MS 10000 // one attempt with a full scan
+#define WIFI_BACKOFF_MIN_MS 1000
+#define WIFI_BACKOFF_MAX_MS 30000
+#define WIFI_RSSI_SAMPLE_MS 1000
+
+enum WifiState : uint8_t
+{
+    WIFI_STATE_IDLE,
+    WIFI_STATE_CONNECTING,
+    WIFI_STATE_CONNECTED,
+    WIFI_STATE_BACKOFF // waiting to retry after a failed attempt
+};
+
+struct WifiStats
+{
+    WifiState state;
+    uint32_t connects;
+    uint32_t disconnects;
+    uint32_t attempts;        // connection attempts since boot
+    uint8_t lastReason;       // 802.11 reason code of the last disconnect
+    uint32_t lastReconnectMs; // from losing the link to having an address again
+    uint32_t maxReconnectMs;
+    uint32_t connectedMs;     // millis() when the current link came up
+    int8_t rssi;              // sampled while connected; 0 before the first sample
+    int8_t rssiMin;           // of the current link
+    int8_t rssiMax;
+};
+
+// Keeps the station connected without ever blocking the caller. Each
+// attempt first joins the access point remembered from the last connection
+// by channel and BSSID, which skips the scan, then falls back to a full
+// scan; failed attempts are retried with exponential backoff. Link loss is
+// picked up from the WiFi driver's events. Define WIFI_STATIC_IP (and
+// WIFI_GATEWAY, WIFI_SUBNET, WIFI_DNS) in credentials.h to skip DHCP too.
+class WifiManager
+{
+public:
+    static void begin();
+    // Call from loop(); only ever reads state and starts driver requests
+    static void service();
+    static bool connected();
+    static const WifiStats &stats();
+    static const char *stateName(WifiState state);
+};
+
+#endif
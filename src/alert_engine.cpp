@@ -0,0 +1,387 @@
+#include "alert_engine.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char default_rules[] =
+    "temp=host_temp>85/80@30+banner+flash+notify;"
+    "cpu=host_cpu>95/85@120;"
+    "heap=device_heap>90/85@30";
+
+static AlertRule rules[ALERT_MAX_RULES];
+static AlertState states[ALERT_MAX_RULES];
+static size_t rule_count = 0;
+static bool rules_loaded = false;
+
+// First rule watching each metric, then the next rule on the same metric
+static int8_t metric_head[METRIC_COUNT];
+static int8_t next_rule[ALERT_MAX_RULES];
+
+// Previous sample per metric, for rate rules
+static float last_value[METRIC_COUNT];
+static uint64_t last_ms[METRIC_COUNT];
+static bool has_last[METRIC_COUNT];
+
+static AlertEvent events[ALERT_EVENT_QUEUE];
+static uint8_t event_head = 0;
+static uint8_t event_count = 0;
+static uint32_t dropped = 0;
+static uint32_t evaluations = 0;
+static uint64_t last_observe_ms = 0;
+
+static uint64_t last_notify_ms[ALERT_MAX_RULES];
+static bool notified_once[ALERT_MAX_RULES];
+static uint64_t window_start_ms = 0;
+static uint8_t window_count = 0;
+
+static void trim(const char *&start, const char *&stop)
+{
+    while (start < stop && (*start == ' ' || *start == '\r' || *start == '\n'))
+        start++;
+    while (stop > start && (stop[-1] == ' ' || stop[-1] == '\r' || stop[-1] == '\n'))
+        stop--;
+}
+
+static bool parseNumber(const char *&p, const char *stop, float &value)
+{
+    char buf[24];
+    size_t len = 0;
+    while (p + len < stop && len < sizeof(buf) - 1 && p[len] && strchr("0123456789.-", p[len]))
+        len++;
+    if (len == 0)
+        return false;
+    memcpy(buf, p, len);
+    buf[len] = '\0';
+
+    char *end;
+    value = strtof(buf, &end);
+    if (end != buf + len)
+        return false;
+    p += len;
+    return true;
+}
+
+static bool parseActions(const char *p, const char *stop, uint8_t &actions)
+{
+    static const char *const names[] = {"banner", "flash", "notify"};
+    actions = 0;
+    while (p < stop)
+    {
+        if (*p++ != '+')
+            return false;
+        const char *end = p;
+        while (end < stop && *end != '+')
+            end++;
+
+        bool known = false;
+        for (int i = 0; i < 3; i++)
+        {
+            if ((size_t)(end - p) == strlen(names[i]) && memcmp(p, names[i], end - p) == 0)
+            {
+                actions |= 1 << i;
+                known = true;
+            }
+        }
+        if (!known)
+            return false;
+        p = end;
+    }
+    return true;
+}
+
+static bool parseEntry(const char *start, const char *stop, AlertRule &rule)
+{
+    const char *equals = (const char *)memchr(start, '=', stop - start);
+    if (!equals)
+        return false;
+
+    const char *nameStart = start;
+    const char *nameStop = equals;
+    trim(nameStart, nameStop);
+    if (nameStop == nameStart || nameStop - nameStart >= ALERT_NAME_LENGTH)
+        return false;
+    // Names become MQTT topic levels and JSON strings
+    for (const char *c = nameStart; c < nameStop; c++)
+    {
+        if (!isalnum((unsigned char)*c) && *c != '_' && *c != '-')
+            return false;
+    }
+    memcpy(rule.name, nameStart, nameStop - nameStart);
+    rule.name[nameStop - nameStart] = '\0';
+
+    const char *p = equals + 1;
+    rule.rate = stop - p > 5 && memcmp(p, "rate:", 5) == 0;
+    if (rule.rate)
+        p += 5;
+
+    const char *metricStop = p;
+    while (metricStop < stop && *metricStop != '>' && *metricStop != '<')
+        metricStop++;
+    char metric[20];
+    if (metricStop == stop || metricStop == p || metricStop - p >= (int)sizeof(metric))
+        return false;
+    memcpy(metric, p, metricStop - p);
+    metric[metricStop - p] = '\0';
+    if (!MetricsHistory::findMetric(metric, rule.metric))
+        return false;
+
+    rule.above = *metricStop == '>';
+    p = metricStop + 1;
+    if (!parseNumber(p, stop, rule.limit))
+        return false;
+
+    rule.clear = rule.limit;
+    if (p < stop && *p == '/')
+    {
+        p++;
+        if (!parseNumber(p, stop, rule.clear))
+            return false;
+        // The clear level has to sit on the safe side of the limit
+        if (rule.above ? rule.clear > rule.limit : rule.clear < rule.limit)
+            return false;
+    }
+
+    rule.forMs = 0;
+    if (p < stop && *p == '@')
+    {
+        p++;
+        float seconds;
+        if (!parseNumber(p, stop, seconds) || seconds < 0)
+            return false;
+        rule.forMs = (uint32_t)(seconds * 1000);
+    }
+
+    if (p == stop)
+    {
+        rule.actions = ALERT_ACTION_BANNER | ALERT_ACTION_NOTIFY;
+        return true;
+    }
+    return parseActions(p, stop, rule.actions) && rule.actions != 0;
+}
+
+static void pushEvent(size_t index, bool active, bool notify, float value, uint64_t nowMs)
+{
+    if (event_count == ALERT_EVENT_QUEUE)
+    {
+        // Keep the newest transitions
+        event_head = (event_head + 1) % ALERT_EVENT_QUEUE;
+        event_count--;
+        dropped++;
+    }
+    AlertEvent &event = events[(event_head + event_count) % ALERT_EVENT_QUEUE];
+    event.rule = rules[index];
+    event.active = active;
+    event.notify = notify;
+    event.value = value;
+    event.atMs = nowMs;
+    event_count++;
+}
+
+const char *AlertEngine::defaultRules()
+{
+    return default_rules;
+}
+
+static bool parseRules(const char *text, AlertRule *compiled, size_t &count, char *error, size_t errorSize)
+{
+    count = 0;
+    if (!text || text[0] == '\0')
+        text = default_rules;
+
+    const char *entry = text;
+    while (*entry)
+    {
+        const char *end = entry;
+        while (*end && *end != ';')
+            end++;
+
+        const char *start = entry;
+        const char *stop = end;
+        trim(start, stop);
+
+        if (stop > start)
+        {
+            if (count == ALERT_MAX_RULES)
+            {
+                snprintf(error, errorSize, "More than %d alerts", ALERT_MAX_RULES);
+                return false;
+            }
+            if (!parseEntry(start, stop, compiled[count]))
+            {
+                snprintf(error, errorSize, "Invalid alert '%.*s'", (int)(stop - start), start);
+                return false;
+            }
+            count++;
+        }
+
+        entry = *end ? end + 1 : end;
+    }
+    return true;
+}
+
+bool AlertEngine::validate(const char *text, char *error, size_t errorSize)
+{
+    AlertRule compiled[ALERT_MAX_RULES];
+    size_t count;
+    return parseRules(text, compiled, count, error, errorSize);
+}
+
+bool AlertEngine::compile(const char *text, char *error, size_t errorSize)
+{
+    AlertRule compiled[ALERT_MAX_RULES];
+    size_t count;
+    if (!parseRules(text, compiled, count, error, errorSize))
+        return false;
+
+    // The old rules' alerts end here; their clear events update the banner,
+    // the retained MQTT topics and the webhook like any other clear
+    for (size_t i = 0; i < rule_count; i++)
+    {
+        if (states[i].active)
+            pushEvent(i, false, states[i].notified, states[i].value, last_observe_ms);
+    }
+
+    memcpy(rules, compiled, sizeof(AlertRule) * count);
+    rule_count = count;
+    rules_loaded = true;
+    memset(states, 0, sizeof(states));
+    memset(notified_once, 0, sizeof(notified_once));
+
+    // Chain in reverse so each metric's rules are evaluated in text order
+    memset(metric_head, -1, sizeof(metric_head));
+    for (int i = (int)count - 1; i >= 0; i--)
+    {
+        next_rule[i] = metric_head[rules[i].metric];
+        metric_head[rules[i].metric] = i;
+    }
+    return true;
+}
+
+size_t AlertEngine::ruleCount()
+{
+    return rule_count;
+}
+
+const AlertRule &AlertEngine::rule(size_t index)
+{
+    return rules[index < rule_count ? index : 0];
+}
+
+const AlertState &AlertEngine::state(size_t index)
+{
+    return states[index < rule_count ? index : 0];
+}
+
+size_t AlertEngine::activeCount()
+{
+    size_t active = 0;
+    for (size_t i = 0; i < rule_count; i++)
+    {
+        if (states[i].active)
+            active++;
+    }
+    return active;
+}
+
+// Per-rule interval plus a shared budget, so a flapping metric or many
+// rules firing together cannot flood the broker or webhook
+static bool allowNotify(size_t index, uint64_t nowMs)
+{
+    if (notified_once[index] && nowMs - last_notify_ms[index] < ALERT_NOTIFY_INTERVAL_MS)
+        return false;
+    if (nowMs - window_start_ms >= ALERT_NOTIFY_WINDOW_MS)
+    {
+        window_start_ms = nowMs;
+        window_count = 0;
+    }
+    if (window_count >= ALERT_NOTIFY_BURST)
+        return false;
+
+    window_count++;
+    notified_once[index] = true;
+    last_notify_ms[index] = nowMs;
+    return true;
+}
+
+void AlertEngine::observe(MetricId metric, float value, uint64_t nowMs)
+{
+    if (metric >= METRIC_COUNT || isnan(value))
+        return;
+
+    float rate = NAN;
+    if (has_last[metric] && nowMs > last_ms[metric])
+        rate = (value - last_value[metric]) * 1000.0f / (float)(nowMs - last_ms[metric]);
+    last_value[metric] = value;
+    last_ms[metric] = nowMs;
+    last_observe_ms = nowMs;
+    has_last[metric] = true;
+    if (!rules_loaded)
+        return;
+
+    for (int8_t i = metric_head[metric]; i >= 0; i = next_rule[i])
+    {
+        const AlertRule &r = rules[i];
+        AlertState &s = states[i];
+        float v = r.rate ? rate : value;
+        if (isnan(v))
+            continue;
+
+        evaluations++;
+        s.value = v;
+        if (s.active)
+        {
+            if (r.above ? v <= r.clear : v >= r.clear)
+            {
+                s.active = false;
+                s.pending = false;
+                s.sinceMs = nowMs;
+                pushEvent(i, false, s.notified, v, nowMs);
+                s.notified = false;
+            }
+            continue;
+        }
+
+        bool tripped = r.above ? v > r.limit : v < r.limit;
+        if (!tripped)
+        {
+            s.pending = false;
+            continue;
+        }
+        if (!s.pending)
+        {
+            s.pending = true;
+            s.sinceMs = nowMs;
+        }
+        if (nowMs - s.sinceMs >= r.forMs)
+        {
+            s.active = true;
+            s.pending = false;
+            s.sinceMs = nowMs;
+            s.fireCount++;
+            s.notified = (r.actions & ALERT_ACTION_NOTIFY) && allowNotify(i, nowMs);
+            pushEvent(i, true, s.notified, v, nowMs);
+        }
+    }
+}
+
+bool AlertEngine::pollEvent(AlertEvent &event)
+{
+    if (event_count == 0)
+        return false;
+    event = events[event_head];
+    event_head = (event_head + 1) % ALERT_EVENT_QUEUE;
+    event_count--;
+    return true;
+}
+
+uint32_t AlertEngine::evalCount()
+{
+    return evaluations;
+}
+
+uint32_t AlertEngine::droppedEvents()
+{
+    return dropped;
+}
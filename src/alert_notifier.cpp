@@ -0,0 +1,161 @@
+#include "alert_notifier.h"
+#include "alert_engine.h"
+#include "settings_manager.h"
+#include "mqtt_publisher.h"
+#include "display.h"
+#include "gui.h"
+#include "config.h"
+#include "log_ring.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+
+struct WebhookPost
+{
+    char url[ALERT_WEBHOOK_MAX_LENGTH];
+    char payload[ALERT_PAYLOAD_SIZE];
+};
+
+static QueueHandle_t webhook_queue = nullptr;
+
+static void formatPayload(char *buf, size_t size, const AlertEvent &event)
+{
+    const AlertRule &rule = event.rule;
+    snprintf(buf, size, "{\"alert\":\"%s\",\"state\":\"%s\",\"metric\":\"%s\",\"rate\":%s,\"value\":%.2f,\"limit\":%.2f}",
+             rule.name, event.active ? "firing" : "clear", MetricsHistory::metricName(rule.metric),
+             rule.rate ? "true" : "false", event.value, rule.limit);
+}
+
+static void postWebhook(const WebhookPost &post)
+{
+    if (WiFi.status() != WL_CONNECTED)
+        return;
+
+    HTTPClient http;
+    http.setTimeout(ALERT_WEBHOOK_TIMEOUT_MS);
+    http.setConnectTimeout(ALERT_WEBHOOK_TIMEOUT_MS);
+    if (!http.begin(post.url))
+    {
+        LOG_E(LOG_MOD_ALERT, "Alert webhook URL rejected: %s", post.url);
+        return;
+    }
+    http.addHeader("Content-Type", "application/json");
+    int code = http.POST((uint8_t *)post.payload, strlen(post.payload));
+    if (code < 200 || code >= 300)
+    {
+        LOG_W(LOG_MOD_ALERT, "Alert webhook failed: %d", code);
+    }
+    http.end();
+}
+
+// Sends queued posts one at a time, in the order the alerts happened
+static void webhookTask(void *)
+{
+    static WebhookPost post;
+    while (true)
+    {
+        if (xQueueReceive(webhook_queue, &post, portMAX_DELAY) == pdTRUE)
+            postWebhook(post);
+    }
+}
+
+// The task is started with the first post, so devices without a webhook
+// never pay for its stack. The URL is copied, since settings may change
+// before the post goes out.
+static void queueWebhook(const char *payload)
+{
+    const char *url = SettingsManager::getAlertWebhook();
+    if (!url[0])
+        return;
+
+    if (!webhook_queue)
+    {
+        webhook_queue = xQueueCreate(ALERT_WEBHOOK_QUEUE, sizeof(WebhookPost));
+        if (!webhook_queue)
+        {
+            LOG_E(LOG_MOD_ALERT, "No memory for the alert webhook queue");
+            return;
+        }
+        if (xTaskCreatePinnedToCore(webhookTask, "webhook", ALERT_WEBHOOK_STACK, NULL, 1, NULL, 0) != pdPASS)
+        {
+            LOG_E(LOG_MOD_ALERT, "No memory for the alert webhook task");
+            vQueueDelete(webhook_queue);
+            webhook_queue = nullptr;
+            return;
+        }
+    }
+
+    static WebhookPost post;
+    strlcpy(post.url, url, sizeof(post.url));
+    strlcpy(post.payload, payload, sizeof(post.payload));
+    if (xQueueSend(webhook_queue, &post, 0) != pdTRUE)
+    {
+        LOG_W(LOG_MOD_ALERT, "Alert webhook busy, dropped %s", payload);
+    }
+}
+
+static void notify(const AlertEvent &event)
+{
+    char payload[ALERT_PAYLOAD_SIZE];
+    formatPayload(payload, sizeof(payload), event);
+
+    char subtopic[8 + ALERT_NAME_LENGTH];
+    snprintf(subtopic, sizeof(subtopic), "alert/%s", event.rule.name);
+    MqttPublisher::publish(subtopic, payload, true);
+    queueWebhook(payload);
+}
+
+// The newest active banner alert is shown, with a count of the others
+static void refreshBanner(bool reveal)
+{
+    int newest = -1;
+    size_t others = 0;
+    for (size_t i = 0; i < AlertEngine::ruleCount(); i++)
+    {
+        const AlertState &state = AlertEngine::state(i);
+        if (!state.active || !(AlertEngine::rule(i).actions & ALERT_ACTION_BANNER))
+            continue;
+        if (newest >= 0)
+            others++;
+        if (newest < 0 || state.sinceMs >= AlertEngine::state(newest).sinceMs)
+            newest = i;
+    }
+
+    if (newest < 0)
+    {
+        gui_hide_alert();
+        return;
+    }
+
+    const AlertRule &rule = AlertEngine::rule(newest);
+    char text[48];
+    int len = snprintf(text, sizeof(text), LV_SYMBOL_WARNING " %s %s%.1f", rule.name, rule.rate ? "d/s " : "",
+                       AlertEngine::state(newest).value);
+    if (others > 0 && len > 0 && len < (int)sizeof(text))
+        snprintf(text + len, sizeof(text) - len, "  +%u", (unsigned)others);
+    gui_show_alert(text, reveal);
+}
+
+void handleAlerts()
+{
+    AlertEvent event;
+    bool changed = false;
+    bool activated = false;
+    while (AlertEngine::pollEvent(event))
+    {
+        const AlertRule &rule = event.rule;
+        LOG_D(LOG_MOD_ALERT, "Alert %s %s at %.2f", rule.name, event.active ? "firing" : "cleared", event.value);
+        changed = true;
+
+        if (event.active && (rule.actions & ALERT_ACTION_BANNER))
+            activated = true;
+        if (event.active && (rule.actions & ALERT_ACTION_FLASH))
+            display_flash(ALERT_FLASH_COUNT);
+        if (event.notify)
+            notify(event);
+    }
+
+    // A new alert brings back a banner the user dismissed
+    if (changed)
+        refreshBanner(activated);
+}
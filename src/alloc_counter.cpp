@@ -0,0 +1,48 @@
+#include "alloc_counter.h"
+#include <stddef.h>
+
+static uint32_t allocations = 0;
+
+#ifdef ALLOC_COUNTER
+extern "C"
+{
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t count, size_t size);
+    void *__real_realloc(void *ptr, size_t size);
+
+    // Called from both cores and from ISRs, hence the atomic add
+    void *__wrap_malloc(size_t size)
+    {
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+        return __real_malloc(size);
+    }
+
+    void *__wrap_calloc(size_t count, size_t size)
+    {
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+        return __real_calloc(count, size);
+    }
+
+    void *__wrap_realloc(void *ptr, size_t size)
+    {
+        void *block = __real_realloc(ptr, size);
+        if (block && block != ptr)
+            __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+        return block;
+    }
+}
+#endif
+
+bool AllocCounter::enabled()
+{
+#ifdef ALLOC_COUNTER
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t AllocCounter::count()
+{
+    return __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+}
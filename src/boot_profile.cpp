@@ -0,0 +1,45 @@
+#include "boot_profile.h"
+#include <Arduino.h>
+#include "esp_timer.h"
+
+static const char *const phase_names[BOOT_PHASE_COUNT] = {"display", "firstPaint", "settings", "storage",
+                                                          "wifi",    "web",        "firstData"};
+
+// 0 until reached; a phase reached at 0 ms is stored as 1
+static volatile uint32_t phase_ms[BOOT_PHASE_COUNT];
+
+void BootProfile::mark(BootPhase phase)
+{
+    if (phase >= BOOT_PHASE_COUNT || phase_ms[phase])
+        return;
+    uint32_t ms = esp_timer_get_time() / 1000;
+    phase_ms[phase] = ms ? ms : 1;
+}
+
+bool BootProfile::reached(BootPhase phase)
+{
+    return phase < BOOT_PHASE_COUNT && phase_ms[phase] != 0;
+}
+
+uint32_t BootProfile::phaseMs(BootPhase phase)
+{
+    return phase < BOOT_PHASE_COUNT ? phase_ms[phase] : 0;
+}
+
+const char *BootProfile::phaseName(BootPhase phase)
+{
+    return phase < BOOT_PHASE_COUNT ? phase_names[phase] : "";
+}
+
+void BootProfile::print()
+{
+    Serial.print("Boot profile (ms):");
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++)
+    {
+        if (phase_ms[i])
+            Serial.printf(" %s %u", phase_names[i], phase_ms[i]);
+        else
+            Serial.printf(" %s -", phase_names[i]);
+    }
+    Serial.println();
+}
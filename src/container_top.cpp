@@ -0,0 +1,130 @@
+#include "container_top.h"
+#include "top_heap.h"
+#include <stdio.h>
+#include <string.h>
+
+static ProcessSort sort_key = PROCESS_SORT_CPU;
+
+static ContainerSummary counting;
+
+// Ordered result of the last complete pass
+static ContainerEntry top[CONTAINER_TOP_N];
+static size_t top_count = 0;
+static ContainerSummary top_summary;
+static uint32_t top_parse_us = 0;
+
+static bool needsAttention(const ContainerEntry &entry)
+{
+    return entry.state >= CONTAINER_RESTARTING;
+}
+
+// True when a ranks below b
+static bool lighter(const ContainerEntry &a, const ContainerEntry &b)
+{
+    if (needsAttention(a) != needsAttention(b))
+        return needsAttention(b);
+    return sort_key == PROCESS_SORT_MEM ? a.memMb < b.memMb : a.cpu < b.cpu;
+}
+
+// Heap being filled by the current pass
+static TopHeap<ContainerEntry, CONTAINER_TOP_N, lighter> heap;
+
+void ContainerTop::setSort(ProcessSort sort)
+{
+    sort_key = sort;
+}
+
+ProcessSort ContainerTop::sort()
+{
+    return sort_key;
+}
+
+// Docker reports health inside the status text on some versions, e.g.
+// "Up 2 hours (unhealthy)"
+ContainerState ContainerTop::parseState(const char *status, const char *health)
+{
+    if (!status)
+        status = "";
+    if ((health && strcmp(health, "unhealthy") == 0) || strstr(status, "unhealthy"))
+        return CONTAINER_UNHEALTHY;
+    if (strncmp(status, "restarting", 10) == 0 || strncmp(status, "Restarting", 10) == 0)
+        return CONTAINER_RESTARTING;
+    if (strncmp(status, "running", 7) == 0 || strncmp(status, "Up", 2) == 0 || strcmp(status, "healthy") == 0)
+        return CONTAINER_RUNNING;
+    if (strncmp(status, "paused", 6) == 0)
+        return CONTAINER_PAUSED;
+    return CONTAINER_STOPPED;
+}
+
+const char *ContainerTop::stateName(ContainerState state)
+{
+    switch (state)
+    {
+    case CONTAINER_RUNNING:
+        return "running";
+    case CONTAINER_PAUSED:
+        return "paused";
+    case CONTAINER_RESTARTING:
+        return "restarting";
+    case CONTAINER_UNHEALTHY:
+        return "unhealthy";
+    default:
+        return "stopped";
+    }
+}
+
+void ContainerTop::beginPass()
+{
+    heap.clear();
+    memset(&counting, 0, sizeof(counting));
+}
+
+void ContainerTop::add(const char *name, ContainerState state, float cpu, float memMb)
+{
+    counting.total++;
+    if (state == CONTAINER_RUNNING || state == CONTAINER_UNHEALTHY)
+        counting.running++;
+    if (state == CONTAINER_RESTARTING)
+        counting.restarting++;
+    if (state == CONTAINER_UNHEALTHY)
+        counting.unhealthy++;
+
+    ContainerEntry candidate;
+    candidate.state = state;
+    candidate.cpu = cpu;
+    candidate.memMb = memMb;
+
+    if (!heap.keeps(candidate))
+        return;
+    snprintf(candidate.name, sizeof(candidate.name), "%s", name ? name : "?");
+    heap.push(candidate);
+}
+
+void ContainerTop::endPass(uint32_t parseUs)
+{
+    heap.sortHeaviestFirst();
+    memcpy(top, heap.data(), sizeof(ContainerEntry) * heap.count());
+    top_count = heap.count();
+    top_summary = counting;
+    top_parse_us = parseUs;
+}
+
+size_t ContainerTop::count()
+{
+    return top_count;
+}
+
+const ContainerEntry &ContainerTop::entry(size_t index)
+{
+    return top[index < top_count ? index : 0];
+}
+
+const ContainerSummary &ContainerTop::summary()
+{
+    return top_summary;
+}
+
+uint32_t ContainerTop::parseUs()
+{
+    return top_parse_us;
+}
@@ -0,0 +1,163 @@
+#include "core_heatmap.h"
+#include <Arduino.h>
+
+static lv_obj_t *heatmap = NULL;
+static uint8_t buckets[HEATMAP_MAX_CORES];
+static lv_color_t palette[HEATMAP_BUCKETS];
+static uint16_t core_count = 0;
+static uint16_t columns = 1;
+static lv_coord_t cell_w = 0;
+static lv_coord_t cell_h = 0;
+static lv_coord_t layout_w = -1;
+static lv_coord_t layout_h = -1;
+static HeatmapStats stats;
+
+// Picks the column count that gives the largest square-ish cells
+static void relayout()
+{
+    lv_coord_t w = lv_obj_get_content_width(heatmap);
+    lv_coord_t h = lv_obj_get_content_height(heatmap);
+    layout_w = w;
+    layout_h = h;
+    if (core_count == 0 || w <= 0 || h <= 0)
+    {
+        cell_w = cell_h = 0;
+        return;
+    }
+
+    lv_coord_t best = -1;
+    for (uint16_t cols = 1; cols <= core_count; cols++)
+    {
+        uint16_t rows = (core_count + cols - 1) / cols;
+        lv_coord_t cw = (w - (cols - 1) * HEATMAP_GAP) / cols;
+        lv_coord_t ch = (h - (rows - 1) * HEATMAP_GAP) / rows;
+        lv_coord_t side = cw < ch ? cw : ch;
+        if (side > best)
+        {
+            best = side;
+            columns = cols;
+            cell_w = cw;
+            cell_h = ch;
+        }
+    }
+}
+
+static void cell_area(uint16_t index, lv_area_t &area)
+{
+    lv_area_t content;
+    lv_obj_get_content_coords(heatmap, &content);
+    uint16_t col = index % columns;
+    uint16_t row = index / columns;
+    area.x1 = content.x1 + col * (cell_w + HEATMAP_GAP);
+    area.y1 = content.y1 + row * (cell_h + HEATMAP_GAP);
+    area.x2 = area.x1 + cell_w - 1;
+    area.y2 = area.y1 + cell_h - 1;
+}
+
+static void draw_cb(lv_event_t *e)
+{
+    uint32_t start = micros();
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+
+    lv_draw_rect_dsc_t dsc;
+    lv_draw_rect_dsc_init(&dsc);
+    dsc.radius = cell_w > 8 && cell_h > 8 ? 2 : 0;
+
+    for (uint16_t i = 0; i < core_count; i++)
+    {
+        lv_area_t area;
+        lv_area_t clipped;
+        cell_area(i, area);
+        // Only cells inside the invalidated region are painted
+        if (!_lv_area_intersect(&clipped, &area, draw_ctx->clip_area))
+            continue;
+        dsc.bg_color = palette[buckets[i]];
+        lv_draw_rect(draw_ctx, &dsc, &area);
+    }
+    stats.drawUs = micros() - start;
+}
+
+static void size_cb(lv_event_t *e)
+{
+    relayout();
+    lv_obj_invalidate(heatmap);
+}
+
+// The page holding the heatmap may be freed while hidden
+static void delete_cb(lv_event_t *e)
+{
+    heatmap = NULL;
+}
+
+lv_obj_t *core_heatmap_create(lv_obj_t *parent)
+{
+    heatmap = lv_obj_create(parent);
+    lv_obj_set_style_bg_opa(heatmap, LV_OPA_0, 0);
+    lv_obj_set_style_border_width(heatmap, 0, 0);
+    lv_obj_set_style_pad_all(heatmap, 0, 0);
+    lv_obj_clear_flag(heatmap, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_event_cb(heatmap, draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(heatmap, size_cb, LV_EVENT_SIZE_CHANGED, NULL);
+    lv_obj_add_event_cb(heatmap, delete_cb, LV_EVENT_DELETE, NULL);
+
+    core_count = 0;
+    layout_w = layout_h = -1;
+    return heatmap;
+}
+
+void core_heatmap_set_colors(lv_color_t idle, lv_color_t busy, lv_color_t hot)
+{
+    palette[0] = idle;
+    for (int b = 1; b < HEATMAP_BUCKETS; b++)
+    {
+        palette[b] = lv_color_mix(hot, busy, (b - 1) * 255 / (HEATMAP_BUCKETS - 2));
+    }
+    if (heatmap)
+        lv_obj_invalidate(heatmap);
+}
+
+void core_heatmap_set_loads(const float *loads, uint16_t count)
+{
+    if (!heatmap)
+        return;
+
+    uint32_t start = micros();
+    if (count > HEATMAP_MAX_CORES)
+        count = HEATMAP_MAX_CORES;
+
+    bool full = count != core_count ||
+                lv_obj_get_content_width(heatmap) != layout_w ||
+                lv_obj_get_content_height(heatmap) != layout_h;
+    core_count = count;
+    if (full)
+        relayout();
+
+    uint16_t changed = 0;
+    for (uint16_t i = 0; i < count; i++)
+    {
+        float load = loads[i] < 0 ? 0 : loads[i];
+        uint8_t bucket = load >= 100 ? HEATMAP_BUCKETS - 1 : (uint8_t)(load * HEATMAP_BUCKETS / 100);
+        if (bucket == buckets[i] && !full)
+            continue;
+
+        buckets[i] = bucket;
+        changed++;
+        if (!full)
+        {
+            lv_area_t area;
+            cell_area(i, area);
+            lv_obj_invalidate_area(heatmap, &area);
+        }
+    }
+    if (full)
+        lv_obj_invalidate(heatmap);
+
+    stats.cores = count;
+    stats.changedCells = changed;
+    stats.updateUs = micros() - start;
+}
+
+const HeatmapStats &core_heatmap_stats()
+{
+    return stats;
+}
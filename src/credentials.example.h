@@ -7,4 +7,11 @@
 const char* const WIFI_SSID = "your_ssid_here"; // Change this to your WiFi SSID
 const char* const WIFI_PASSWORD = "your_password_here"; // Change this to your WiFi Password
 
+// Optional static address, which saves the DHCP exchange on every connect.
+// WIFI_DNS defaults to the gateway.
+// #define WIFI_STATIC_IP "192.168.1.50"
+// #define WIFI_GATEWAY "192.168.1.1"
+// #define WIFI_SUBNET "255.255.255.0"
+// #define WIFI_DNS "192.168.1.1"
+
 #endif
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "device_stats.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_freertos_hooks.h"
+#include "esp_idf_version.h"
+#include "esp_timer.h"
+#include <string.h>
+
+#define HAVE_TASK_STATUS (configUSE_TRACE_FACILITY == 1)
+#define HAVE_RUN_TIME_STATS (HAVE_TASK_STATUS && configGENERATE_RUN_TIME_STATS == 1)
+
+static const char *const stage_names[STAGE_COUNT] = {"lvgl", "glances", "web", "mqtt", "other"};
+
+static float core_usage[portNUM_PROCESSORS];
+static uint32_t stage_us[STAGE_COUNT];
+static float stage_share[STAGE_COUNT];
+static TaskStat tasks[DEVICE_STATS_MAX_TASKS];
+static size_t task_count = 0;
+static int64_t last_sample_us = 0;
+
+#if HAVE_TASK_STATUS
+static TaskStatus_t status_buf[DEVICE_STATS_MAX_TASKS];
+#endif
+
+static TaskHandle_t idleTaskFor(int core)
+{
+#if ESP_IDF_VERSION_MAJOR >= 5
+    return xTaskGetIdleTaskHandleForCore(core);
+#else
+    return xTaskGetIdleTaskHandleForCPU(core);
+#endif
+}
+
+#if HAVE_RUN_TIME_STATS
+struct PrevRunTime
+{
+    TaskHandle_t handle;
+    uint32_t runTime;
+};
+static PrevRunTime prev_run_time[DEVICE_STATS_MAX_TASKS];
+static size_t prev_count = 0;
+static uint32_t prev_total = 0;
+
+static uint32_t previousRunTime(TaskHandle_t handle, uint32_t current)
+{
+    for (size_t i = 0; i < prev_count; i++)
+    {
+        if (prev_run_time[i].handle == handle)
+            return prev_run_time[i].runTime;
+    }
+    // New task: count it from now on
+    return current;
+}
+#else
+// Without run-time counters, each core's tick interrupt samples whether that
+// core's idle task is the one running. Nothing hooks the idle task itself,
+// so it still sleeps in WFI between interrupts. Tasks that wake on a tick
+// and block again within the same millisecond go unseen.
+static TaskHandle_t idle_task[portNUM_PROCESSORS];
+static volatile uint32_t tick_samples[portNUM_PROCESSORS];
+static volatile uint32_t idle_samples[portNUM_PROCESSORS];
+static uint32_t last_tick_samples[portNUM_PROCESSORS];
+static uint32_t last_idle_samples[portNUM_PROCESSORS];
+
+static inline void IRAM_ATTR sampleTick(int core)
+{
+    tick_samples[core]++;
+    if (xTaskGetCurrentTaskHandle() == idle_task[core])
+        idle_samples[core]++;
+}
+
+static void IRAM_ATTR tickHookCore0()
+{
+    sampleTick(0);
+}
+
+#if portNUM_PROCESSORS > 1
+static void IRAM_ATTR tickHookCore1()
+{
+    sampleTick(1);
+}
+#endif
+#endif
+
+void DeviceStats::begin()
+{
+#if !HAVE_RUN_TIME_STATS
+    for (int c = 0; c < portNUM_PROCESSORS; c++)
+        idle_task[c] = idleTaskFor(c);
+    esp_register_freertos_tick_hook_for_cpu(tickHookCore0, 0);
+#if portNUM_PROCESSORS > 1
+    esp_register_freertos_tick_hook_for_cpu(tickHookCore1, 1);
+#endif
+#endif
+    last_sample_us = esp_timer_get_time();
+}
+
+void DeviceStats::addStageTime(LoopStage stage, uint32_t us)
+{
+    if (stage < STAGE_COUNT)
+        stage_us[stage] += us;
+}
+
+void DeviceStats::update()
+{
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = now - last_sample_us;
+    if (elapsed < DEVICE_STATS_INTERVAL_MS * 1000LL)
+        return;
+    last_sample_us = now;
+
+    for (int i = 0; i < STAGE_COUNT; i++)
+    {
+        stage_share[i] = stage_us[i] * 100.0f / elapsed;
+        stage_us[i] = 0;
+    }
+
+#if HAVE_TASK_STATUS
+    uint32_t total = 0;
+    UBaseType_t n = uxTaskGetSystemState(status_buf, DEVICE_STATS_MAX_TASKS, &total);
+    if (n == 0)
+    {
+        // More tasks than slots; keep the previous sample
+        return;
+    }
+
+#if HAVE_RUN_TIME_STATS
+    uint32_t total_delta = total - prev_total;
+    for (int c = 0; c < portNUM_PROCESSORS; c++)
+        core_usage[c] = 0;
+#endif
+
+    task_count = n;
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        const TaskStatus_t &status = status_buf[i];
+        TaskStat &stat = tasks[i];
+        strlcpy(stat.name, status.pcTaskName, sizeof(stat.name));
+        stat.stackHighWater = status.usStackHighWaterMark;
+        stat.priority = status.uxCurrentPriority;
+#if configTASKLIST_INCLUDE_COREID
+        stat.core = status.xCoreID == tskNO_AFFINITY ? -1 : status.xCoreID;
+#else
+        stat.core = -1;
+#endif
+
+#if HAVE_RUN_TIME_STATS
+        uint32_t delta = status.ulRunTimeCounter - previousRunTime(status.xHandle, status.ulRunTimeCounter);
+        stat.cpuPercent = total_delta ? delta * 100.0f / total_delta : 0;
+        for (int c = 0; c < portNUM_PROCESSORS; c++)
+        {
+            if (status.xHandle == idleTaskFor(c))
+                core_usage[c] = 100.0f - stat.cpuPercent;
+        }
+#else
+        stat.cpuPercent = -1;
+#endif
+    }
+
+#if HAVE_RUN_TIME_STATS
+    for (UBaseType_t i = 0; i < n; i++)
+    {
+        prev_run_time[i].handle = status_buf[i].xHandle;
+        prev_run_time[i].runTime = status_buf[i].ulRunTimeCounter;
+    }
+    prev_count = n;
+    prev_total = total;
+#endif
+#endif
+
+#if !HAVE_RUN_TIME_STATS
+    for (int c = 0; c < portNUM_PROCESSORS; c++)
+    {
+        uint32_t ticks = tick_samples[c];
+        uint32_t idle = idle_samples[c];
+        uint32_t sampled = ticks - last_tick_samples[c];
+        uint32_t idled = idle - last_idle_samples[c];
+        last_tick_samples[c] = ticks;
+        last_idle_samples[c] = idle;
+        core_usage[c] = sampled ? 100.0f * (sampled - idled) / sampled : 0;
+    }
+#endif
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++)
+    {
+        if (core_usage[c] < 0)
+            core_usage[c] = 0;
+        if (core_usage[c] > 100)
+            core_usage[c] = 100;
+    }
+}
+
+float DeviceStats::stageShare(LoopStage stage)
+{
+    return stage < STAGE_COUNT ? stage_share[stage] : 0;
+}
+
+const char *DeviceStats::stageName(LoopStage stage)
+{
+    return stage < STAGE_COUNT ? stage_names[stage] : "";
+}
+
+float DeviceStats::coreUsage(int core)
+{
+    return core >= 0 && core < portNUM_PROCESSORS ? core_usage[core] : 0;
+}
+
+float DeviceStats::totalUsage()
+{
+    float sum = 0;
+    for (int c = 0; c < portNUM_PROCESSORS; c++)
+        sum += core_usage[c];
+    return sum / portNUM_PROCESSORS;
+}
+
+size_t DeviceStats::taskCount()
+{
+    return task_count;
+}
+
+const TaskStat &DeviceStats::task(size_t index)
+{
+    return tasks[index < task_count ? index : 0];
+}
+
+bool DeviceStats::hasRunTimeStats()
+{
+    return HAVE_RUN_TIME_STATS;
+}
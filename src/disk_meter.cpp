@@ -0,0 +1,253 @@
+#include "disk_meter.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+struct DiskCounters
+{
+    uint64_t readBytes;
+    uint64_t writeBytes;
+    uint64_t readCount;
+    uint64_t writeCount;
+};
+
+// Position map: name and hash of each array entry and the disk it feeds
+static char entry_name[DISKIO_MAX_ENTRIES][DISKIO_NAME_LENGTH];
+static uint32_t entry_hash[DISKIO_MAX_ENTRIES];
+static int8_t entry_disk[DISKIO_MAX_ENTRIES];
+static uint16_t mapped_entries = 0;
+static bool map_dirty = true;
+static uint32_t rebuild_count = 0;
+
+// Counters of the payload being parsed, by position
+static DiskCounters pass_counters[DISKIO_MAX_ENTRIES];
+static uint16_t pass_entries = 0;
+static uint64_t pass_stamp_us = 0;
+
+static DiskRate disks[DISKIO_MAX_DISKS];
+static DiskCounters disk_counters[DISKIO_MAX_DISKS];
+static uint64_t disk_stamp_us[DISKIO_MAX_DISKS];
+static bool disk_seen[DISKIO_MAX_DISKS];
+static size_t disk_count = 0;
+
+static DiskTotals disk_totals;
+static float history_ring[DISKIO_HISTORY];
+static size_t history_head = 0;
+static size_t history_count = 0;
+
+static uint32_t nameHash(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name)
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool hasPrefix(const char *name, const char *prefix)
+{
+    return strncmp(name, prefix, strlen(prefix)) == 0;
+}
+
+// sda1 of sda, nvme0n1p2 of nvme0n1, mmcblk0p1 of mmcblk0
+static bool isPartition(uint16_t position, uint16_t entries)
+{
+    const char *name = entry_name[position];
+    size_t len = strlen(name);
+    size_t base = len;
+    while (base > 0 && isdigit((unsigned char)name[base - 1]))
+        base--;
+    if (base == len || base == 0)
+        return false;
+    if (name[base - 1] == 'p' && base > 1 && isdigit((unsigned char)name[base - 2]))
+        base--;
+
+    for (uint16_t i = 0; i < entries; i++)
+    {
+        if (i != position && strlen(entry_name[i]) == base && strncmp(entry_name[i], name, base) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Disks keep their index, and so their previous counters, across rebuilds
+// as long as they are still present
+static void rebuildMap(uint16_t entries)
+{
+    DiskRate previous[DISKIO_MAX_DISKS];
+    DiskCounters previousCounters[DISKIO_MAX_DISKS];
+    uint64_t previousStamp[DISKIO_MAX_DISKS];
+    bool previousSeen[DISKIO_MAX_DISKS];
+    size_t previousCount = disk_count;
+    memcpy(previous, disks, sizeof(DiskRate) * previousCount);
+    memcpy(previousCounters, disk_counters, sizeof(DiskCounters) * previousCount);
+    memcpy(previousStamp, disk_stamp_us, sizeof(uint64_t) * previousCount);
+    memcpy(previousSeen, disk_seen, sizeof(bool) * previousCount);
+
+    disk_count = 0;
+    for (uint16_t p = 0; p < entries; p++)
+    {
+        const char *name = entry_name[p];
+        entry_disk[p] = -1;
+        if (hasPrefix(name, "loop") || hasPrefix(name, "ram") || isPartition(p, entries) ||
+            disk_count == DISKIO_MAX_DISKS)
+            continue;
+
+        DiskRate &disk = disks[disk_count];
+        memset(&disk, 0, sizeof(disk));
+        snprintf(disk.name, sizeof(disk.name), "%s", name);
+        disk.stacked = hasPrefix(name, "md") || hasPrefix(name, "dm-");
+        disk_seen[disk_count] = false;
+        for (size_t i = 0; i < previousCount; i++)
+        {
+            if (strcmp(previous[i].name, name) == 0)
+            {
+                disk = previous[i];
+                disk_counters[disk_count] = previousCounters[i];
+                disk_stamp_us[disk_count] = previousStamp[i];
+                disk_seen[disk_count] = previousSeen[i];
+                break;
+            }
+        }
+        entry_disk[p] = disk_count++;
+    }
+
+    mapped_entries = entries;
+    map_dirty = false;
+    rebuild_count++;
+}
+
+void DiskMeter::beginPass(uint64_t nowUs)
+{
+    pass_stamp_us = nowUs;
+    pass_entries = 0;
+}
+
+void DiskMeter::addEntry(const char *name, uint64_t readBytes, uint64_t writeBytes, uint64_t readCount,
+                         uint64_t writeCount)
+{
+    if (!name || pass_entries == DISKIO_MAX_ENTRIES)
+        return;
+
+    uint16_t p = pass_entries++;
+    uint32_t hash = nameHash(name);
+    if (p >= mapped_entries || map_dirty || hash != entry_hash[p])
+    {
+        snprintf(entry_name[p], DISKIO_NAME_LENGTH, "%s", name);
+        entry_hash[p] = hash;
+        map_dirty = true;
+    }
+
+    DiskCounters &counters = pass_counters[p];
+    counters.readBytes = readBytes;
+    counters.writeBytes = writeBytes;
+    counters.readCount = readCount;
+    counters.writeCount = writeCount;
+}
+
+bool DiskMeter::endPass()
+{
+    if (map_dirty || pass_entries != mapped_entries)
+        rebuildMap(pass_entries);
+
+    DiskTotals totals = {false, 0, 0, 0, 0, -1};
+    float busiest = 0;
+
+    for (uint16_t p = 0; p < pass_entries; p++)
+    {
+        int8_t d = entry_disk[p];
+        if (d < 0)
+            continue;
+
+        DiskRate &disk = disks[d];
+        DiskCounters &prev = disk_counters[d];
+        const DiskCounters &now = pass_counters[p];
+
+        // Counters going backwards mean the host or Glances restarted; the
+        // next payload starts a fresh interval
+        disk.valid = disk_seen[d] && pass_stamp_us > disk_stamp_us[d] && now.readBytes >= prev.readBytes &&
+                     now.writeBytes >= prev.writeBytes && now.readCount >= prev.readCount &&
+                     now.writeCount >= prev.writeCount;
+        if (disk.valid)
+        {
+            float seconds = (pass_stamp_us - disk_stamp_us[d]) / 1000000.0f;
+            disk.readRate = (now.readBytes - prev.readBytes) / seconds;
+            disk.writeRate = (now.writeBytes - prev.writeBytes) / seconds;
+            disk.readIops = (now.readCount - prev.readCount) / seconds;
+            disk.writeIops = (now.writeCount - prev.writeCount) / seconds;
+
+            if (!disk.stacked)
+            {
+                totals.valid = true;
+                totals.readRate += disk.readRate;
+                totals.writeRate += disk.writeRate;
+                totals.readIops += disk.readIops;
+                totals.writeIops += disk.writeIops;
+                float moved = disk.readRate + disk.writeRate;
+                if (moved > busiest)
+                {
+                    busiest = moved;
+                    totals.busiest = d;
+                }
+            }
+        }
+
+        prev = now;
+        disk_stamp_us[d] = pass_stamp_us;
+        disk_seen[d] = true;
+    }
+
+    disk_totals = totals;
+    if (totals.valid)
+    {
+        history_ring[history_head] = totals.readRate + totals.writeRate;
+        history_head = (history_head + 1) % DISKIO_HISTORY;
+        if (history_count < DISKIO_HISTORY)
+            history_count++;
+    }
+    return totals.valid;
+}
+
+size_t DiskMeter::diskCount()
+{
+    return disk_count;
+}
+
+const DiskRate &DiskMeter::disk(size_t index)
+{
+    return disks[index < disk_count ? index : 0];
+}
+
+const DiskTotals &DiskMeter::totals()
+{
+    return disk_totals;
+}
+
+size_t DiskMeter::history(float *out, size_t maxCount)
+{
+    size_t count = history_count < maxCount ? history_count : maxCount;
+    size_t start = (history_head + DISKIO_HISTORY - count) % DISKIO_HISTORY;
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = history_ring[(start + i) % DISKIO_HISTORY];
+    }
+    return count;
+}
+
+uint32_t DiskMeter::rebuildCount()
+{
+    return rebuild_count;
+}
+
+void DiskMeter::reset()
+{
+    mapped_entries = 0;
+    map_dirty = true;
+    disk_count = 0;
+    history_count = 0;
+    history_head = 0;
+    memset(&disk_totals, 0, sizeof(disk_totals));
+    disk_totals.busiest = -1;
+}
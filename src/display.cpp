@@ -1,4 +1,5 @@
 #include "display.h"
+#include "log_ring.h"
 #include <Arduino.h>
 
 #define TFT_BL 21  // Correct backlight pin for CYD
@@ -8,16 +9,25 @@ TFT_eSPI tft = TFT_eSPI();
 lv_disp_draw_buf_t draw_buf;
 lv_color_t *buf1;
 lv_color_t *buf2;
+static bool display_awake = true;
+static uint32_t last_refresh_us = 0;
+
+static void refresh_done(lv_disp_drv_t *disp, uint32_t time, uint32_t px)
+{
+    last_refresh_us = micros();
+}
 
 void init_display()
 {
     pinMode(TFT_BL, OUTPUT);
-    digitalWrite(TFT_BL, TFT_BACKLIGHT_ON);
+    digitalWrite(TFT_BL, !TFT_BACKLIGHT_ON);
 
     tft.begin();
     tft.setRotation(3);  // Landscape orientation
     tft.initDMA();
     tft.fillScreen(TFT_BLACK);
+    // Lit only once cleared, so power-up shows no noise from the panel RAM
+    digitalWrite(TFT_BL, TFT_BACKLIGHT_ON);
 
     // Allocate display buffers - fix the width/height issue
     extern const uint16_t screenHeight;
@@ -33,7 +43,7 @@ void init_display()
     buf2 = (lv_color_t *)heap_caps_malloc(sizeof(lv_color_t) * buffer_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
     
     if (buf1 == NULL || buf2 == NULL) {
-        Serial.println("Failed to allocate display buffers!");
+        LOG_E(LOG_MOD_SYSTEM, "Failed to allocate display buffers");
         return;
     }
     
@@ -46,13 +56,15 @@ void init_display()
     disp_drv.ver_res = screenHeight;  // 320
     disp_drv.flush_cb = my_disp_flush;
     disp_drv.draw_buf = &draw_buf;
+    disp_drv.monitor_cb = refresh_done;
     lv_disp_drv_register(&disp_drv);
     
-    Serial.println("Display initialized successfully");
+    LOG_I(LOG_MOD_SYSTEM, "Display initialized");
 }
 
 void display_sleep(bool sleep)
 {
+    display_awake = !sleep;
     if (sleep)
     {
         digitalWrite(TFT_BL, !TFT_BACKLIGHT_ON);
@@ -70,6 +82,34 @@ void display_sleep(bool sleep)
     }
 }
 
+bool display_is_awake()
+{
+    return display_awake;
+}
+
+// Each step toggles the backlight; an even count ends with it back on
+static void flash_step(lv_timer_t *timer)
+{
+    uint32_t step = (uint32_t)(uintptr_t)timer->user_data;
+    digitalWrite(TFT_BL, step % 2 ? TFT_BACKLIGHT_ON : !TFT_BACKLIGHT_ON);
+    timer->user_data = (void *)(uintptr_t)(step + 1);
+}
+
+void display_flash(uint8_t times)
+{
+    // A sleeping display stays dark
+    if (!display_awake || times == 0)
+        return;
+
+    lv_timer_t *timer = lv_timer_create(flash_step, DISPLAY_FLASH_STEP_MS, (void *)(uintptr_t)0);
+    lv_timer_set_repeat_count(timer, times * 2);
+}
+
+uint32_t display_last_refresh_us()
+{
+    return last_refresh_us;
+}
+
 void my_disp_flush(lv_disp_drv_t *disp, const lv_area_t *area, lv_color_t *color_p)
 {
     uint32_t w = (area->x2 - area->x1 + 1);
@@ -0,0 +1,141 @@
+#include "fetch_stats.h"
+#include "log_ring.h"
+#include <Arduino.h>
+#include <string.h>
+
+static const uint32_t bucket_limits_us[FETCH_HIST_BUCKETS] = {
+    1000, 2000, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, UINT32_MAX};
+
+static const char *const phase_names[PHASE_COUNT] = {"dns", "connect", "ttfb", "body", "parse", "total"};
+static const char *const error_names[FETCH_ERR_COUNT] = {"wifi", "dns", "connect", "timeout", "http", "parse"};
+
+static EndpointStats endpoints[FETCH_STATS_MAX_ENDPOINTS];
+static size_t endpoint_count = 0;
+
+EndpointStats *FetchStats::find(const char *endpoint)
+{
+    for (size_t i = 0; i < endpoint_count; i++)
+    {
+        if (strcmp(endpoints[i].endpoint, endpoint) == 0)
+            return &endpoints[i];
+    }
+    if (endpoint_count == FETCH_STATS_MAX_ENDPOINTS)
+        return nullptr;
+
+    EndpointStats &stats = endpoints[endpoint_count++];
+    memset(&stats, 0, sizeof(stats));
+    strlcpy(stats.endpoint, endpoint, sizeof(stats.endpoint));
+    return &stats;
+}
+
+static size_t bucketFor(uint32_t us)
+{
+    size_t bucket = 0;
+    while (us > bucket_limits_us[bucket])
+        bucket++;
+    return bucket;
+}
+
+void FetchStats::record(const char *endpoint, const FetchTrace &trace)
+{
+    EndpointStats *stats = find(endpoint);
+    if (!stats)
+        return;
+
+    stats->count++;
+    stats->bytesTotal += trace.bytes;
+    stats->last = trace;
+    for (int p = 0; p < PHASE_COUNT; p++)
+    {
+        uint32_t us = trace.phaseUs[p];
+        stats->histogram[p][bucketFor(us)]++;
+        stats->phaseSumUs[p] += us;
+        if (us > stats->phaseMaxUs[p])
+            stats->phaseMaxUs[p] = us;
+    }
+}
+
+void FetchStats::recordError(const char *endpoint, FetchError error, const FetchTrace &trace)
+{
+    EndpointStats *stats = find(endpoint);
+    if (!stats || error >= FETCH_ERR_COUNT)
+        return;
+
+    stats->errors[error]++;
+    stats->last = trace;
+}
+
+size_t FetchStats::endpointCount()
+{
+    return endpoint_count;
+}
+
+const EndpointStats &FetchStats::endpoint(size_t index)
+{
+    return endpoints[index < endpoint_count ? index : 0];
+}
+
+uint32_t FetchStats::errorCount()
+{
+    uint32_t errors = 0;
+    for (size_t i = 0; i < endpoint_count; i++)
+    {
+        for (int e = 0; e < FETCH_ERR_COUNT; e++)
+            errors += endpoints[i].errors[e];
+    }
+    return errors;
+}
+
+uint32_t FetchStats::bucketLimitUs(size_t bucket)
+{
+    return bucket < FETCH_HIST_BUCKETS ? bucket_limits_us[bucket] : UINT32_MAX;
+}
+
+const char *FetchStats::phaseName(FetchPhase phase)
+{
+    return phase < PHASE_COUNT ? phase_names[phase] : "";
+}
+
+const char *FetchStats::errorName(FetchError error)
+{
+    return error < FETCH_ERR_COUNT ? error_names[error] : "";
+}
+
+void FetchStats::printTrace(const char *endpoint, const FetchTrace &trace)
+{
+    // Whole microseconds keep the arguments small enough for one log entry
+    LOG_D(LOG_MOD_GLANCES, "Fetch %s: dns %u connect %u ttfb %u body %u parse %u total %u us, %u bytes",
+          endpoint,
+          trace.phaseUs[PHASE_DNS],
+          trace.phaseUs[PHASE_CONNECT],
+          trace.phaseUs[PHASE_TTFB],
+          trace.phaseUs[PHASE_BODY],
+          trace.phaseUs[PHASE_PARSE],
+          trace.phaseUs[PHASE_TOTAL],
+          trace.bytes);
+}
+
+void FetchStats::printSummary()
+{
+    Serial.println("Glances fetch statistics (avg/max ms):");
+    for (size_t i = 0; i < endpoint_count; i++)
+    {
+        const EndpointStats &stats = endpoints[i];
+        uint32_t errors = 0;
+        for (int e = 0; e < FETCH_ERR_COUNT; e++)
+            errors += stats.errors[e];
+
+        Serial.printf("  %-20s n=%u err=%u", stats.endpoint, stats.count, errors);
+        for (int p = 0; p < PHASE_COUNT; p++)
+        {
+            float avg = stats.count ? stats.phaseSumUs[p] / 1000.0f / stats.count : 0;
+            Serial.printf(" %s %.1f/%.1f", phase_names[p], avg, stats.phaseMaxUs[p] / 1000.0f);
+        }
+        Serial.printf(" avg %u B\n", stats.count ? (uint32_t)(stats.bytesTotal / stats.count) : 0);
+    }
+}
+
+void FetchStats::reset()
+{
+    endpoint_count = 0;
+}
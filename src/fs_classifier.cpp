@@ -0,0 +1,232 @@
+#include "fs_classifier.h"
+#include <string.h>
+#include <stdio.h>
+
+// Mirrors the original hard-coded checks: read-write Windows fixed drives,
+// unRAID array disks and any non-system Linux mount count towards the array,
+// anything with "cache" in its mount point is reported as cache.
+static const char default_rules[] =
+    "cache:mnt=*cache*;"
+    "array:opt=*fixed*&opt=*rw*;"
+    "array:mnt=/rootfs/mnt/disk*;"
+    "ignore:mnt=/;"
+    "ignore:mnt=*/boot*;"
+    "ignore:mnt=*/snap*;"
+    "ignore:mnt=*/sys*;"
+    "ignore:mnt=*/proc*;"
+    "ignore:mnt=*/dev*;"
+    "array:mnt=/*";
+
+static FsRule rules[FS_MAX_RULES];
+static size_t rule_count = 0;
+static bool rules_loaded = false;
+
+static bool parseGroup(const char *text, size_t len, FsGroup &group)
+{
+    if (len == 5 && strncmp(text, "array", 5) == 0)
+        group = FS_GROUP_ARRAY;
+    else if (len == 5 && strncmp(text, "cache", 5) == 0)
+        group = FS_GROUP_CACHE;
+    else if (len == 6 && strncmp(text, "ignore", 6) == 0)
+        group = FS_GROUP_IGNORE;
+    else
+        return false;
+    return true;
+}
+
+static bool parseField(const char *text, size_t len, FsField &field)
+{
+    if (len == 3 && strncmp(text, "mnt", 3) == 0)
+        field = FS_FIELD_MNT;
+    else if (len == 3 && strncmp(text, "opt", 3) == 0)
+        field = FS_FIELD_OPTIONS;
+    else if (len == 3 && strncmp(text, "dev", 3) == 0)
+        field = FS_FIELD_DEVICE;
+    else if (len == 4 && strncmp(text, "type", 4) == 0)
+        field = FS_FIELD_TYPE;
+    else
+        return false;
+    return true;
+}
+
+// One "field=pattern" condition
+static bool parseCondition(const char *text, size_t len, FsCondition &condition)
+{
+    const char *equals = (const char *)memchr(text, '=', len);
+    return equals && parseField(text, equals - text, condition.field) &&
+           condition.pattern.compile(equals + 1, text + len - equals - 1);
+}
+
+const char *FsClassifier::defaultRules()
+{
+    return default_rules;
+}
+
+static bool parseRules(const char *text, FsRule *compiled, size_t &count, char *error, size_t errorSize)
+{
+    count = 0;
+    if (!text || text[0] == '\0')
+        text = default_rules;
+
+    const char *entry = text;
+    while (*entry)
+    {
+        const char *end = entry;
+        while (*end && *end != ';' && *end != '\n')
+            end++;
+
+        // Trim surrounding spaces
+        const char *start = entry;
+        const char *stop = end;
+        while (start < stop && (*start == ' ' || *start == '\r'))
+            start++;
+        while (stop > start && (stop[-1] == ' ' || stop[-1] == '\r'))
+            stop--;
+
+        if (stop > start)
+        {
+            const char *colon = (const char *)memchr(start, ':', stop - start);
+            FsRule rule;
+            rule.conditionCount = 0;
+
+            if (count == FS_MAX_RULES)
+            {
+                snprintf(error, errorSize, "More than %d rules", FS_MAX_RULES);
+                return false;
+            }
+            bool valid = colon && parseGroup(start, colon - start, rule.group);
+            const char *condition = colon ? colon + 1 : stop;
+            while (valid && condition <= stop)
+            {
+                const char *next = (const char *)memchr(condition, '&', stop - condition);
+                if (!next)
+                    next = stop;
+                valid = rule.conditionCount < FS_MAX_CONDITIONS &&
+                        parseCondition(condition, next - condition, rule.conditions[rule.conditionCount++]);
+                condition = next + 1;
+            }
+            if (!valid)
+            {
+                snprintf(error, errorSize, "Invalid rule '%.*s'", (int)(stop - start), start);
+                return false;
+            }
+            compiled[count++] = rule;
+        }
+
+        entry = *end ? end + 1 : end;
+    }
+    return true;
+}
+
+bool FsClassifier::validate(const char *text, char *error, size_t errorSize)
+{
+    FsRule compiled[FS_MAX_RULES];
+    size_t count;
+    return parseRules(text, compiled, count, error, errorSize);
+}
+
+bool FsClassifier::compile(const char *text, char *error, size_t errorSize)
+{
+    FsRule compiled[FS_MAX_RULES];
+    size_t count;
+    if (!parseRules(text, compiled, count, error, errorSize))
+        return false;
+
+    memcpy(rules, compiled, sizeof(FsRule) * count);
+    rule_count = count;
+    rules_loaded = true;
+    return true;
+}
+
+size_t FsClassifier::ruleCount()
+{
+    return rule_count;
+}
+
+FsGroup FsClassifier::classify(const char *mnt, const char *options, const char *device, const char *type)
+{
+    if (!rules_loaded)
+    {
+        char error[8];
+        compile(default_rules, error, sizeof(error));
+    }
+
+    const char *fields[] = {mnt, options, device, type};
+    for (size_t i = 0; i < rule_count; i++)
+    {
+        const FsRule &rule = rules[i];
+        bool matched = true;
+        for (uint8_t c = 0; c < rule.conditionCount && matched; c++)
+            matched = rule.conditions[c].pattern.matches(fields[rule.conditions[c].field]);
+        if (matched)
+            return rule.group;
+    }
+    return FS_GROUP_IGNORE;
+}
+
+void FsClassifier::beginPass(FsSummary &summary)
+{
+    summary.arraySize = 0;
+    summary.arrayUsed = 0;
+    summary.cacheSize = 0;
+    summary.cacheUsed = 0;
+    summary.arrayCount = 0;
+    summary.cacheCount = 0;
+    summary.mountCount = 0;
+    summary.driveCount = 0;
+}
+
+// Short display name: the last path component, or the drive letter on Windows
+static void driveName(char *out, size_t size, const char *mnt)
+{
+    size_t len = strlen(mnt);
+    while (len > 1 && (mnt[len - 1] == '/' || mnt[len - 1] == '\\'))
+        len--;
+    size_t start = len;
+    while (start > 0 && mnt[start - 1] != '/' && mnt[start - 1] != '\\')
+        start--;
+    if (start == len)
+        start = 0;
+    snprintf(out, size, "%.*s", (int)(len - start), mnt + start);
+}
+
+void FsClassifier::addMount(FsSummary &summary, const char *mnt, const char *options, const char *device,
+                            const char *type, uint64_t size, uint64_t used)
+{
+    summary.mountCount++;
+    if (!mnt)
+        return;
+
+    FsGroup group = classify(mnt, options, device, type);
+    if (group == FS_GROUP_ARRAY)
+    {
+        summary.arraySize += size;
+        summary.arrayUsed += used;
+        summary.arrayCount++;
+    }
+    else if (group == FS_GROUP_CACHE)
+    {
+        summary.cacheSize += size;
+        summary.cacheUsed += used;
+        summary.cacheCount++;
+    }
+    else
+    {
+        return;
+    }
+
+    if (summary.driveCount < FS_MAX_DRIVES)
+    {
+        DriveInfo &drive = summary.drives[summary.driveCount++];
+        driveName(drive.name, sizeof(drive.name), mnt);
+        drive.size = size;
+        drive.used = used;
+        drive.percent = percent(used, size);
+        drive.group = group;
+    }
+}
+
+float FsClassifier::percent(uint64_t used, uint64_t size)
+{
+    return size ? used * 100.0f / size : 0;
+}
@@ -1,111 +1,244 @@
 #include "glances_api.h"
 #include "gui.h"
 #include "config.h"
-#include <HTTPClient.h>
-#include <WiFi.h>
+#include "log_ring.h"
+#include "metrics_history.h"
+#include "metric_registry.h"
+#include "fetch_stats.h"
+#include "alloc_counter.h"
+#include "boot_profile.h"
+#include "wifi_manager.h"
+#include "loop_latency.h"
+#include "process_top.h"
+#include "container_top.h"
+#include "disk_meter.h"
+#include "esp_timer.h"
+#include <math.h>
 
-bool GlancesAPI::fetchData(const char *endpoint, StaticJsonDocument<4096> &doc)
+HostMetrics host_metrics = {NAN, NAN, NAN, NAN, NAN, NAN, NAN, NAN, NAN, NAN, NAN, NAN, "", 0};
+FsSummary fs_summary;
+PerCpuLoads percpu_loads;
+GlancesCycleStats glances_cycle;
+
+static uint64_t historyNowMs()
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static void onFsEntry(JsonObjectConst fs, void *context)
+{
+    LOG_D(LOG_MOD_GLANCES, "  Drive: %s, Type: %s, Options: %s", (const char *)fs["mnt_point"],
+          (const char *)fs["fs_type"], (const char *)fs["options"]);
+    GlancesParse::onFsEntry(fs, context);
+}
+
+bool GlancesAPI::updateFsData()
 {
-    if (WiFi.status() != WL_CONNECTED)
+    LoopLatency::feed();
+    static StaticJsonDocument<GLANCES_FS_FILTER_SIZE> filter;
+    static StaticJsonDocument<GLANCES_FS_ELEMENT_SIZE> element;
+
+    if (filter.isNull())
     {
-        Serial.println("WiFi not connected for Glances API");
-        return false;
+        GlancesParse::fsFilter(filter);
     }
 
-    if (glances_host.length() == 0) {
-        Serial.println("Glances host not configured");
+    LOG_D(LOG_MOD_GLANCES, "Processing filesystem data:");
+    FsClassifier::beginPass(fs_summary);
+    return streamArray("/api/4/fs", filter, element, onFsEntry, &fs_summary);
+}
+
+static uint64_t passNowUs()
+{
+    return esp_timer_get_time();
+}
+
+// Glances' own *_rate_per_sec fields are averaged over its refresh period;
+// the cumulative gauges let the rate window follow our poll interval.
+bool GlancesAPI::updateNetworkData()
+{
+    LoopLatency::feed();
+    static StaticJsonDocument<GLANCES_NET_FILTER_SIZE> filter;
+    static StaticJsonDocument<GLANCES_NET_ELEMENT_SIZE> element;
+
+    if (filter.isNull())
+    {
+        GlancesParse::netFilter(filter);
+    }
+
+    RatePass pass = {passNowUs, false};
+    if (!streamArray("/api/4/network", filter, element, GlancesParse::onNetEntry, &pass) || !pass.started)
+    {
         return false;
     }
+    return NetMeter::endPass();
+}
 
-    HTTPClient http;
-    String url = "http://" + glances_host + ":" + String(glances_port) + endpoint;
-    DEBUG_PRINTF("Fetching: %s\n", url.c_str());
-    
-    http.begin(url);
-    http.setTimeout(5000); // 5 second timeout
-    int httpCode = http.GET();
+// Same as the network counters: the gauges are cumulative, so rates and
+// IOPS cover exactly the time between our own polls
+bool GlancesAPI::updateDiskIoData()
+{
+    LoopLatency::feed();
+    static StaticJsonDocument<GLANCES_DISKIO_FILTER_SIZE> filter;
+    static StaticJsonDocument<GLANCES_DISKIO_ELEMENT_SIZE> element;
+
+    if (filter.isNull())
+    {
+        GlancesParse::diskIoFilter(filter);
+    }
 
-    if (httpCode != HTTP_CODE_OK)
+    RatePass pass = {passNowUs, false};
+    if (!streamArray("/api/4/diskio", filter, element, GlancesParse::onDiskIoEntry, &pass) || !pass.started)
     {
-        Serial.printf("HTTP error %d for endpoint %s\n", httpCode, endpoint);
-        http.end();
         return false;
     }
+    return DiskMeter::endPass();
+}
 
-    String payload = http.getString();
-    http.end();
+bool GlancesAPI::updateSensorData()
+{
+    LoopLatency::feed();
+    static StaticJsonDocument<GLANCES_SENSOR_FILTER_SIZE> filter;
+    static StaticJsonDocument<GLANCES_SENSOR_ELEMENT_SIZE> element;
 
-    DeserializationError error = deserializeJson(doc, payload);
-    if (error) {
-        Serial.printf("JSON parse error for %s: %s\n", endpoint, error.c_str());
+    if (filter.isNull())
+    {
+        GlancesParse::sensorFilter(filter);
+    }
+
+    SensorMap::beginPass();
+    if (!streamArray("/api/4/sensors", filter, element, GlancesParse::onSensorEntry, nullptr))
+    {
         return false;
     }
-    
+    SensorMap::endPass();
     return true;
 }
 
-void GlancesAPI::updateCPUData(StaticJsonDocument<4096> &doc)
+static void onPerCpuEntry(JsonObjectConst cpu, void *context)
 {
-    if (!fetchData("/api/4/cpu", doc)) {
-        Serial.printf("Failed to fetch CPU data");
+    uint16_t &position = *(uint16_t *)context;
+    uint16_t index = cpu["cpu_number"] | position;
+    position++;
+    if (index >= HEATMAP_MAX_CORES)
         return;
+
+    percpu_loads.total[index] = cpu["total"].as<float>();
+    if (index >= percpu_loads.count)
+        percpu_loads.count = index + 1;
+}
+
+bool GlancesAPI::updatePerCpuData()
+{
+    LoopLatency::feed();
+    static StaticJsonDocument<64> filter;
+    static StaticJsonDocument<128> element;
+
+    if (filter.isNull())
+    {
+        filter["cpu_number"] = true;
+        filter["total"] = true;
     }
 
-    float cpuPercent = doc["total"].as<float>();
-    int cpuCount = doc["cpucore"].as<int>();
-    
-    DEBUG_PRINTF("CPU: %.1f%%, Cores: %d\n", cpuPercent, cpuCount);
+    uint16_t position = 0;
+    percpu_loads.count = 0;
+    return streamArray("/api/4/percpu", filter, element, onPerCpuEntry, &position);
+}
 
-    if (cpu_arc_obj.arc && cpu_arc_obj.label)
+// The process list is hundreds of KB on busy hosts; only the filtered fields
+// of one process are ever held in memory.
+bool GlancesAPI::updateProcessData()
+{
+    LoopLatency::feed();
+    static StaticJsonDocument<GLANCES_PROCESS_FILTER_SIZE> filter;
+    static StaticJsonDocument<GLANCES_PROCESS_ELEMENT_SIZE> element;
+
+    if (filter.isNull())
     {
-        lv_obj_t **labels = (lv_obj_t **)lv_obj_get_user_data(cpu_arc_obj.arc);
-        if (labels)
-        {
-            char buf[32];
-
-            lv_label_set_text(labels[0], "CPU");
-            snprintf(buf, sizeof(buf), "%d cores", cpuCount);
-            lv_label_set_text(labels[1], buf);
-            snprintf(buf, sizeof(buf), "%d%%", (int)cpuPercent);
-            lv_label_set_text(labels[2], buf);
-            lv_obj_set_style_text_font(labels[1], &lv_font_montserrat_10, 0);
-            lv_obj_set_style_text_font(labels[2], &lv_font_montserrat_16, 0);
-            lv_obj_set_style_text_color(labels[1], lv_color_hex(0x808080), 0);
-            lv_obj_set_style_text_color(labels[2], lv_color_white(), 0);
-            
-            DEBUG_PRINTLN("Updated CPU arc labels");
-        } else {
-            DEBUG_PRINTLN("CPU arc labels not found");
-        }
-        set_arc_value_animated(cpu_arc_obj.arc, cpuPercent, 500);
-        DEBUG_PRINTF("Set CPU arc to %d%%\n", (int)cpuPercent);
-    } else {
-        DEBUG_PRINTLN("CPU arc object not initialized");
+        GlancesParse::processFilter(filter);
+    }
+
+    FetchTrace trace;
+    ProcessTop::beginPass();
+    if (!streamArray("/api/4/processlist", filter, element, GlancesParse::onProcessEntry, nullptr, &trace))
+    {
+        return false;
     }
+    ProcessTop::endPass(trace.phaseUs[PHASE_PARSE]);
+    LOG_D(LOG_MOD_GLANCES, "Process list: %u processes, %u bytes, parsed in %u us", ProcessTop::processCount(),
+          trace.bytes, trace.phaseUs[PHASE_PARSE]);
+    return true;
 }
 
-void GlancesAPI::updateMemoryData(StaticJsonDocument<4096> &doc)
+// Like the process list, a host with 100+ containers is parsed one filtered
+// entry at a time
+bool GlancesAPI::updateContainerData()
 {
-    if (!fetchData("/api/4/mem", doc))
-        return;
+    LoopLatency::feed();
+    static StaticJsonDocument<GLANCES_CONTAINER_FILTER_SIZE> filter;
+    static StaticJsonDocument<GLANCES_CONTAINER_ELEMENT_SIZE> element;
 
-    float memPercent = doc["percent"].as<float>();
-    float totalRam = doc["total"].as<float>() / (1024.0 * 1024.0 * 1024.0);
+    if (filter.isNull())
+    {
+        GlancesParse::containerFilter(filter);
+    }
 
-    if (ram_arc_obj.arc && ram_arc_obj.label)
+    FetchTrace trace;
+    ContainerTop::beginPass();
+    if (!streamArray("/api/4/containers", filter, element, GlancesParse::onContainerEntry, nullptr, &trace))
     {
-        lv_obj_t **labels = (lv_obj_t **)lv_obj_get_user_data(ram_arc_obj.arc);
-        if (labels)
+        return false;
+    }
+    ContainerTop::endPass(trace.phaseUs[PHASE_PARSE]);
+    LOG_D(LOG_MOD_GLANCES, "Containers: %u (%u running), %u bytes, parsed in %u us",
+          ContainerTop::summary().total, ContainerTop::summary().running, trace.bytes, trace.phaseUs[PHASE_PARSE]);
+    return true;
+}
+
+// Walks the fetch plan the compiler built from metric_registry: one request
+// per endpoint. ArduinoJson filters are documents, so each step's filter is
+// filled from its rows' keys on the first pass and reused after that. Like the
+// other updates it feeds the loop watchdog first, since one request can block
+// for seconds and a cycle makes many.
+void GlancesAPI::updateRegistryData(JsonDocument &doc)
+{
+    static StaticJsonDocument<JSON_OBJECT_SIZE(METRIC_MAX_KEYS_PER_ENDPOINT)> filters[metric_fetch_steps];
+
+    for (size_t i = 0; i < metric_fetch_steps; i++)
+    {
+        LoopLatency::feed();
+        const MetricFetchStep &step = metric_fetch_plan.steps[i];
+        const MetricDesc &first = metric_registry[step.rows[0]];
+        if (filters[i].isNull() && first.key)
         {
-            char buf[32];
+            for (size_t r = 0; r < step.rowCount; r++)
+                filters[i][metric_registry[step.rows[r]].key] = true;
+        }
 
-            lv_label_set_text(labels[0], "RAM");
-            snprintf(buf, sizeof(buf), "%d%%", (int)memPercent);
-            lv_label_set_text(labels[1], buf);
-            snprintf(buf, sizeof(buf), "/ %.1f GB", totalRam);
-            lv_label_set_text(labels[2], buf);
+        if (!fetchData(step.endpoint, doc, first.key ? &filters[i] : nullptr))
+        {
+            LOG_W(LOG_MOD_GLANCES, "Failed to fetch %s", step.endpoint);
+            continue;
+        }
+
+        for (size_t r = 0; r < step.rowCount; r++)
+        {
+            const MetricDesc &d = metric_registry[step.rows[r]];
+            if (d.kind == METRIC_UPTIME)
+            {
+                GlancesParse::formatUptime(doc.as<JsonVariantConst>(), host_metrics.uptime,
+                                           sizeof(host_metrics.uptime));
+                continue;
+            }
+            JsonVariantConst v = doc[d.key];
+            if (v.isNull())
+                continue;
+            float value = v.as<float>() * d.scale;
+            host_metrics.*d.value = value;
+            if (d.history != METRIC_COUNT)
+                MetricsHistory::record(d.history, value, historyNowMs());
+            LOG_D(LOG_MOD_GLANCES, "%s %s: %.1f", step.endpoint, d.key, value);
         }
-        set_arc_value_animated(ram_arc_obj.arc, memPercent);
     }
 }
 
@@ -114,177 +247,126 @@ void updateGlancesData()
     static unsigned long lastGlancesUpdate = 0;
     static bool first_run = true;
     
-    if (millis() - lastGlancesUpdate < GLANCES_UPDATE_INTERVAL)
+    // Nothing to fetch while the link is down, so an outage does not pile
+    // up fetch errors. The first cycle runs as soon as WiFi is up.
+    if (!WifiManager::connected())
+    {
+        return;
+    }
+    if (!first_run && millis() - lastGlancesUpdate < GLANCES_UPDATE_INTERVAL)
     {
         return;
     }
     
     if (first_run) {
-        Serial.println("Starting Glances data updates...");
-        Serial.printf("Glances Host: %s\n", glances_host.c_str());
-        Serial.printf("Glances Port: %d\n", glances_port);
-        Serial.printf("Debug Mode: %s\n", debug_mode ? "Enabled" : "Disabled");
+        LOG_I(LOG_MOD_GLANCES, "Starting Glances data updates from %s:%d", glances_host.c_str(), glances_port);
         first_run = false;
     }
     
     static StaticJsonDocument<4096> doc;
+    uint32_t cycleStart = millis();
+    uint32_t errorsBefore = FetchStats::errorCount();
+    uint32_t allocsBefore = AllocCounter::count();
     
-    DEBUG_PRINTLN("Updating CPU data...");
-    GlancesAPI::updateCPUData(doc);
-    
-    DEBUG_PRINTLN("Updating Memory data...");
-    GlancesAPI::updateMemoryData(doc);
+    LOG_D(LOG_MOD_GLANCES, "Updating CPU, memory, load and uptime...");
+    GlancesAPI::updateRegistryData(doc);
 
-    if (GlancesAPI::fetchData("/api/4/sensors", doc))
+    // Per-core loads, processes and containers are only needed while their
+    // page is on screen
+    if (gui_current_page() == PAGE_CORES)
+    {
+        GlancesAPI::updatePerCpuData();
+    }
+    if (gui_current_page() == PAGE_PROCESSES)
     {
-        for (JsonVariant sensor : doc.as<JsonArray>())
+        GlancesAPI::updateProcessData();
+    }
+    if (gui_current_page() == PAGE_CONTAINERS)
+    {
+        GlancesAPI::updateContainerData();
+    }
+
+    if (GlancesAPI::updateSensorData())
+    {
+        // The first mapped sensor that is present is the host temperature
+        for (size_t i = 0; i < SensorMap::slotCount(); i++)
         {
-            if (strcmp(sensor["label"], "Package id 0") == 0)
+            const SensorReading &reading = SensorMap::reading(i);
+            if (reading.present)
             {
-                int temp = (int)sensor["value"].as<float>();
-                char buf[32];
-                snprintf(buf, sizeof(buf), LV_SYMBOL_WARNING " Temp: %d°C", temp);
-                update_compact_label(temp_label, buf);
+                MetricsHistory::record(METRIC_HOST_TEMP, reading.value, historyNowMs());
+                host_metrics.temperature = reading.value;
                 break;
             }
         }
     }
 
-    DEBUG_PRINTLN("Updating disk data...");
-    if (GlancesAPI::fetchData("/api/4/fs", doc))
+    LOG_D(LOG_MOD_GLANCES, "Updating disk data...");
+    if (GlancesAPI::updateFsData())
     {
-        unsigned long long totalSize = 0;
-        unsigned long long usedSize = 0;
-        int driveCount = 0;
-
-        DEBUG_PRINTLN("Processing filesystem data:");
-        for (JsonVariant fs : doc.as<JsonArray>())
+        if (fs_summary.arraySize > 0)
         {
-            const char *mnt_point = fs["mnt_point"].as<const char *>();
-            const char *fs_type = fs["fs_type"].as<const char *>();
-            const char *options = fs["options"].as<const char *>();
-            
-            DEBUG_PRINTF("  Drive: %s, Type: %s, Options: %s\n", mnt_point, fs_type, options);
-            
-            // For Windows: Include fixed drives (C:\, D:\, etc.), exclude removable and CD-ROM
-            // For Linux: Include specific mount points or all non-system mounts
-            bool includeInArray = false;
-            
-            if (strstr(options, "fixed") != nullptr && strstr(options, "rw") != nullptr) {
-                // Windows fixed drives (C:\, D:\, etc.)
-                includeInArray = true;
-            } else if (strncmp(mnt_point, "/rootfs/mnt/disk", 15) == 0) {
-                // Linux unRAID array disks
-                includeInArray = true;
-            } else if (mnt_point[0] == '/' && 
-                      strcmp(mnt_point, "/") != 0 && 
-                      strstr(mnt_point, "/boot") == nullptr &&
-                      strstr(mnt_point, "/snap") == nullptr &&
-                      strstr(mnt_point, "/sys") == nullptr &&
-                      strstr(mnt_point, "/proc") == nullptr &&
-                      strstr(mnt_point, "/dev") == nullptr) {
-                // Linux regular mount points (excluding system mounts)
-                includeInArray = true;
-            }
-            
-            if (includeInArray) {
-                totalSize += fs["size"].as<unsigned long long>();
-                usedSize += fs["used"].as<unsigned long long>();
-                driveCount++;
-                DEBUG_PRINTF("    Added to array: %s\n", mnt_point);
-            }
+            float usagePercent = FsClassifier::percent(fs_summary.arrayUsed, fs_summary.arraySize);
+            host_metrics.disk_percent = usagePercent;
+            LOG_D(LOG_MOD_GLANCES, "Updated disk array: %.1f%% (%d drives)", usagePercent, fs_summary.arrayCount);
+        } else {
+            LOG_D(LOG_MOD_GLANCES, "No drives found for array display");
         }
 
-        if (totalSize > 0)
+        if (fs_summary.cacheSize > 0)
         {
-            float usagePercent = (usedSize * 100.0) / totalSize;
-            char buf[32];
-            snprintf(buf, sizeof(buf), LV_SYMBOL_DRIVE " Drives: %.1f%%", usagePercent);
-            update_compact_label(disk_label, buf);
-            DEBUG_PRINTF("Updated disk array: %.1f%% (%d drives)\n", usagePercent, driveCount);
+            float usage = FsClassifier::percent(fs_summary.cacheUsed, fs_summary.cacheSize);
+            host_metrics.cache_percent = usage;
+            LOG_D(LOG_MOD_GLANCES, "Updated cache: %.1f%% (%d mounts)", usage, fs_summary.cacheCount);
         } else {
-            DEBUG_PRINTLN("No drives found for array display");
+            LOG_D(LOG_MOD_GLANCES, "No cache or suitable drive found");
         }
     }
 
-    DEBUG_PRINTLN("Updating cache data...");
-    if (GlancesAPI::fetchData("/api/4/fs", doc))
+    if (GlancesAPI::updateNetworkData())
     {
-        bool cacheFound = false;
-        for (JsonVariant fs : doc.as<JsonArray>())
-        {
-            const char *mnt_point = fs["mnt_point"].as<const char *>();
-            
-            // Check for various cache mount points
-            if (strcmp(mnt_point, "/rootfs/mnt/cache") == 0 ||  // unRAID cache
-                strcmp(mnt_point, "/cache") == 0 ||             // Generic cache
-                strcmp(mnt_point, "/var/cache") == 0 ||         // System cache
-                strstr(mnt_point, "cache") != nullptr) {        // Any mount containing "cache"
-                
-                float usage = fs["percent"].as<float>();
-                char buf[32];
-                snprintf(buf, sizeof(buf), LV_SYMBOL_SAVE " Cache: %.1f%%", usage);
-                update_compact_label(cache_label, buf);
-                DEBUG_PRINTF("Updated cache: %.1f%% (%s)\n", usage, mnt_point);
-                cacheFound = true;
-                break;
-            }
-        }
-        
-        if (!cacheFound) {
-            DEBUG_PRINTLN("No cache or suitable drive found");
-        }
+        const NetRates &net = NetMeter::rates();
+        MetricsHistory::record(METRIC_HOST_NET_RX, net.rxRate, historyNowMs());
+        MetricsHistory::record(METRIC_HOST_NET_TX, net.txRate, historyNowMs());
+        host_metrics.net_rx_rate = net.rxRate;
+        host_metrics.net_tx_rate = net.txRate;
+        host_metrics.net_rx_peak = net.rxPeak;
+        host_metrics.net_tx_peak = net.txPeak;
+        LOG_D(LOG_MOD_GLANCES, "Network %s: rx %.0f B/s (peak %.0f), tx %.0f B/s (peak %.0f)", net.name,
+              net.rxRate, net.rxPeak, net.txRate, net.txPeak);
     }
 
-    if (GlancesAPI::fetchData("/api/4/uptime", doc))
+    // Fetched every cycle so the throughput history keeps filling while
+    // the page is off screen
+    if (GlancesAPI::updateDiskIoData())
     {
-        String payload = doc.as<String>();
-        payload.replace("\"", "");
-        char buf[32];
-        snprintf(buf, sizeof(buf), LV_SYMBOL_POWER "  %s", payload.c_str());
-        update_compact_label(uptime_label, buf);
+        const DiskTotals &io = DiskMeter::totals();
+        LOG_D(LOG_MOD_GLANCES, "Disk I/O: read %.0f B/s, write %.0f B/s, %.0f IOPS", io.readRate, io.writeRate,
+              io.readIops + io.writeIops);
     }
 
-    if (GlancesAPI::fetchData("/api/4/network", doc))
-    {
-        for (JsonVariant interface : doc.as<JsonArray>())
-        {
-            const char *interface_name = interface["interface_name"].as<const char *>();
+    lastGlancesUpdate = millis();
+    host_metrics.updated_ms = lastGlancesUpdate;
+    gui_refresh();
 
-            if (strcmp(interface_name, "eth0") == 0)
-            {
-                float recv_rate = interface["bytes_recv_rate_per_sec"].as<float>();
-                float sent_rate = interface["bytes_sent_rate_per_sec"].as<float>();
-
-                char down_str[16], up_str[16];
-                auto formatSpeed = [](float bytes_per_sec, char *buffer)
-                {
-                    if (bytes_per_sec > 1024 * 1024)
-                        sprintf(buffer, "%.1fM", bytes_per_sec / (1024.0 * 1024.0));
-                    else if (bytes_per_sec > 1024)
-                        sprintf(buffer, "%.1fK", bytes_per_sec / 1024.0);
-                    else
-                        sprintf(buffer, "%.0fB", bytes_per_sec);
-                };
-
-                formatSpeed(recv_rate, down_str);
-                formatSpeed(sent_rate, up_str);
-
-                char buf[64];
-                snprintf(buf, sizeof(buf), LV_SYMBOL_DOWNLOAD " %s    " LV_SYMBOL_UPLOAD " %s", down_str, up_str);
-                update_compact_label(network_label, buf);
-                break;
-            }
-        }
+    glances_cycle.cycles++;
+    glances_cycle.lastCycleMs = millis() - cycleStart;
+    if (glances_cycle.lastCycleMs > glances_cycle.maxCycleMs)
+        glances_cycle.maxCycleMs = glances_cycle.lastCycleMs;
+    glances_cycle.lastAllocs = AllocCounter::count() - allocsBefore;
+    if (glances_cycle.lastAllocs > glances_cycle.maxAllocs)
+        glances_cycle.maxAllocs = glances_cycle.lastAllocs;
+    glances_cycle.lastOk = FetchStats::errorCount() == errorsBefore;
+    if (glances_cycle.lastOk)
+    {
+        glances_cycle.lastOkMs = millis();
+        BootProfile::mark(BOOT_FIRST_DATA);
     }
+    else
+        glances_cycle.failedCycles++;
 
-    if (GlancesAPI::fetchData("/api/4/load", doc))
+    if (glances_cycle.cycles % FETCH_SUMMARY_EVERY_CYCLES == 0 && LogRing::enabled(LOG_LEVEL_DEBUG, LOG_MOD_GLANCES))
     {
-        float load1 = doc["min1"].as<float>();
-        char buf[32];
-        snprintf(buf, sizeof(buf), LV_SYMBOL_CHARGE " Load: %.1f", load1);
-        update_compact_label(load_label, buf);
+        FetchStats::printSummary();
     }
-
-    lastGlancesUpdate = millis();
 }
\ No newline at end of file
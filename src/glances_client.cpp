@@ -0,0 +1,345 @@
+#include "glances_api.h"
+#include "config.h"
+#include "log_ring.h"
+#include "fetch_stats.h"
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <lwip/dns.h>
+
+static bool expired(unsigned long deadline)
+{
+    return (long)(millis() - deadline) >= 0;
+}
+
+static unsigned long earliest(unsigned long a, unsigned long b)
+{
+    return (long)(a - b) < 0 ? a : b;
+}
+
+// Answer to the lookup in flight. A lookup that gave up at its deadline can
+// still be answered later; its generation no longer matches and the answer
+// is dropped.
+static volatile uint32_t dns_generation = 0;
+static volatile bool dns_done = false;
+static volatile uint32_t dns_address = 0;
+
+static void onDnsFound(const char *, const ip_addr_t *addr, void *arg)
+{
+    if ((uint32_t)(uintptr_t)arg != dns_generation)
+        return;
+    dns_address = addr ? ip4_addr_get_u32(ip_2_ip4(addr)) : 0;
+    dns_done = true;
+}
+
+// WiFi.hostByName() waits up to 15 s for lwIP, as long as the loop
+// watchdog, so the lookup is started here and given up at the deadline
+static bool resolveHost(const char *host, IPAddress &ip, unsigned long deadline)
+{
+    if (ip.fromString(host))
+        return true;
+
+    ip_addr_t addr;
+    dns_done = false;
+    uint32_t generation = ++dns_generation;
+    err_t err = dns_gethostbyname(host, &addr, onDnsFound, (void *)(uintptr_t)generation);
+    if (err == ERR_OK)
+    {
+        ip = IPAddress(ip4_addr_get_u32(ip_2_ip4(&addr)));
+        return true;
+    }
+    if (err != ERR_INPROGRESS)
+        return false;
+
+    while (!dns_done)
+    {
+        if (expired(deadline))
+            return false;
+        delay(1);
+    }
+    if (dns_address == 0)
+        return false;
+    ip = IPAddress((uint32_t)dns_address);
+    return true;
+}
+
+// Sends a GET for endpoint and reads the response headers, leaving client
+// positioned at the start of the body. Fills the DNS, connect and TTFB phases.
+// Each phase keeps its own limit, and none runs past deadline.
+bool GlancesAPI::openRequest(const char *endpoint, WiFiClient &client, FetchTrace &trace, int &contentLength,
+                             unsigned long deadline)
+{
+    memset(&trace, 0, sizeof(trace));
+    contentLength = -1;
+
+    if (WiFi.status() != WL_CONNECTED)
+    {
+        LOG_W(LOG_MOD_GLANCES, "WiFi not connected for Glances API");
+        FetchStats::recordError(endpoint, FETCH_ERR_WIFI, trace);
+        return false;
+    }
+
+    if (glances_host.length() == 0) {
+        LOG_W(LOG_MOD_GLANCES, "Glances host not configured");
+        return false;
+    }
+
+    uint32_t start = micros();
+    IPAddress ip;
+    if (!resolveHost(glances_host.c_str(), ip, deadline))
+    {
+        LOG_W(LOG_MOD_GLANCES, "DNS lookup failed for %s", glances_host.c_str());
+        FetchStats::recordError(endpoint, FETCH_ERR_DNS, trace);
+        return false;
+    }
+    uint32_t mark = micros();
+    trace.phaseUs[PHASE_DNS] = mark - start;
+
+    LOG_D(LOG_MOD_GLANCES, "Fetching: http://%s:%d%s", glances_host.c_str(), glances_port, endpoint);
+    long remaining = (long)(deadline - millis());
+    int32_t connectMs = remaining < GLANCES_CONNECT_TIMEOUT_MS ? remaining : GLANCES_CONNECT_TIMEOUT_MS;
+    if (connectMs <= 0 || !client.connect(ip, glances_port, connectMs))
+    {
+        LOG_W(LOG_MOD_GLANCES, "Connect failed for endpoint %s", endpoint);
+        FetchStats::recordError(endpoint, FETCH_ERR_CONNECT, trace);
+        return false;
+    }
+    trace.phaseUs[PHASE_CONNECT] = micros() - mark;
+    mark = micros();
+
+    // HTTP/1.0 keeps Glances from answering with a chunked body. The request
+    // is built on the stack and sent in one write; Print::printf would
+    // allocate for anything this long.
+    char request[GLANCES_REQUEST_SIZE];
+    int requestLength = snprintf(request, sizeof(request),
+                                 "GET %s HTTP/1.0\r\nHost: %s\r\nAccept: application/json\r\nConnection: close\r\n\r\n",
+                                 endpoint, glances_host.c_str());
+    if (requestLength <= 0 || requestLength >= (int)sizeof(request))
+    {
+        LOG_E(LOG_MOD_GLANCES, "Request too long for endpoint %s", endpoint);
+        FetchStats::recordError(endpoint, FETCH_ERR_CONNECT, trace);
+        client.stop();
+        return false;
+    }
+    client.write((const uint8_t *)request, requestLength);
+
+    unsigned long firstByte = earliest(millis() + GLANCES_RESPONSE_TIMEOUT_MS, deadline);
+    while (!client.available())
+    {
+        if (!client.connected() || expired(firstByte))
+        {
+            LOG_W(LOG_MOD_GLANCES, "Timeout waiting for endpoint %s", endpoint);
+            FetchStats::recordError(endpoint, FETCH_ERR_TIMEOUT, trace);
+            client.stop();
+            return false;
+        }
+        delay(1);
+    }
+    trace.phaseUs[PHASE_TTFB] = micros() - mark;
+
+    char line[128];
+    size_t len = client.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[len] = '\0';
+    if (sscanf(line, "HTTP/%*d.%*d %d", &trace.status) != 1)
+    {
+        trace.status = -1;
+    }
+
+    // Skip the headers, noting Content-Length on the way
+    while (client.connected() || client.available())
+    {
+        if (expired(deadline))
+        {
+            LOG_W(LOG_MOD_GLANCES, "Timeout reading headers for endpoint %s", endpoint);
+            FetchStats::recordError(endpoint, FETCH_ERR_TIMEOUT, trace);
+            client.stop();
+            return false;
+        }
+        len = client.readBytesUntil('\n', line, sizeof(line) - 1);
+        line[len] = '\0';
+        if (len == 0 || line[0] == '\r')
+            break;
+        if (strncasecmp(line, "Content-Length:", 15) == 0)
+            contentLength = atoi(line + 15);
+    }
+
+    if (trace.status != HTTP_CODE_OK)
+    {
+        LOG_W(LOG_MOD_GLANCES, "HTTP error %d for endpoint %s", trace.status, endpoint);
+        FetchStats::recordError(endpoint, FETCH_ERR_HTTP, trace);
+        client.stop();
+        return false;
+    }
+    return true;
+}
+
+// Small endpoints are read whole into one static buffer, so a fetch does
+// not touch the heap. Only one request runs at a time. A filter keeps only
+// the members the caller reads.
+bool GlancesAPI::fetchData(const char *endpoint, JsonDocument &doc, const JsonDocument *filter)
+{
+    static char payload[GLANCES_PAYLOAD_SIZE];
+    WiFiClient client;
+    FetchTrace trace;
+    int contentLength;
+    uint32_t start = micros();
+    unsigned long deadline = millis() + GLANCES_REQUEST_TIMEOUT_MS;
+
+    if (!openRequest(endpoint, client, trace, contentLength, deadline))
+    {
+        return false;
+    }
+
+    uint32_t mark = micros();
+    if (contentLength >= (int)sizeof(payload))
+    {
+        LOG_E(LOG_MOD_GLANCES, "Response too large for %s: %d bytes", endpoint, contentLength);
+        FetchStats::recordError(endpoint, FETCH_ERR_PARSE, trace);
+        client.stop();
+        return false;
+    }
+
+    size_t length = 0;
+    size_t limit = contentLength >= 0 ? contentLength : sizeof(payload) - 1;
+    unsigned long bodyDeadline = earliest(millis() + GLANCES_RESPONSE_TIMEOUT_MS, deadline);
+    while (length < limit && (client.connected() || client.available()))
+    {
+        int n = client.read((uint8_t *)payload + length, limit - length);
+        if (n > 0)
+        {
+            length += n;
+        }
+        else if (expired(bodyDeadline))
+        {
+            break;
+        }
+        else
+        {
+            delay(1);
+        }
+    }
+    bool overflow = contentLength < 0 && length == limit && (client.connected() || client.available());
+    bool late = length < limit && client.connected() && expired(bodyDeadline);
+    client.stop();
+    payload[length] = '\0';
+    trace.bytes = length;
+    trace.phaseUs[PHASE_BODY] = micros() - mark;
+
+    if (late && contentLength < 0)
+    {
+        LOG_W(LOG_MOD_GLANCES, "Timeout reading body for endpoint %s", endpoint);
+        FetchStats::recordError(endpoint, FETCH_ERR_TIMEOUT, trace);
+        return false;
+    }
+    if (contentLength > 0 && (int)trace.bytes < contentLength)
+    {
+        LOG_W(LOG_MOD_GLANCES, "Truncated body for %s: %u of %d bytes", endpoint, trace.bytes, contentLength);
+        FetchStats::recordError(endpoint, FETCH_ERR_TIMEOUT, trace);
+        return false;
+    }
+    if (overflow)
+    {
+        LOG_E(LOG_MOD_GLANCES, "Response too large for %s", endpoint);
+        FetchStats::recordError(endpoint, FETCH_ERR_PARSE, trace);
+        return false;
+    }
+
+    // Passed as const so the document copies the strings it keeps instead
+    // of pointing into a buffer the next fetch overwrites
+    mark = micros();
+    DeserializationError error = filter ? deserializeJson(doc, (const char *)payload, length,
+                                                          DeserializationOption::Filter(*filter))
+                                        : deserializeJson(doc, (const char *)payload, length);
+    trace.phaseUs[PHASE_PARSE] = micros() - mark;
+    trace.phaseUs[PHASE_TOTAL] = micros() - start;
+
+    if (error) {
+        LOG_E(LOG_MOD_GLANCES, "JSON parse error for %s: %s", endpoint, error.c_str());
+        FetchStats::recordError(endpoint, FETCH_ERR_PARSE, trace);
+        return false;
+    }
+
+    FetchStats::record(endpoint, trace);
+    FetchStats::printTrace(endpoint, trace);
+    return true;
+}
+
+// Counts the bytes ArduinoJson pulls from the underlying client, and hands
+// out none after the request's deadline. A body that drips one byte at a
+// time would otherwise restart the stream's timeout with every byte. The
+// read in progress at the deadline still waits out that timeout, a second.
+class CountingStream : public Stream
+{
+public:
+    CountingStream(Stream &source, unsigned long deadline) : source(source), deadline(deadline) {}
+
+    int available() override { return expired(deadline) ? 0 : source.available(); }
+    int peek() override { return expired(deadline) ? -1 : source.peek(); }
+    int read() override
+    {
+        if (expired(deadline))
+            return -1;
+        int c = source.read();
+        if (c >= 0)
+            count++;
+        return c;
+    }
+    size_t write(uint8_t) override { return 0; }
+    void flush() override {}
+
+    uint32_t count = 0;
+
+private:
+    Stream &source;
+    unsigned long deadline;
+};
+
+// Parses a JSON array response one element at a time with
+// GlancesParse::walkArray, the same walk the native tests run on the corpus.
+bool GlancesAPI::streamArray(const char *endpoint, JsonDocument &filter, JsonDocument &element,
+                             ArrayElementCallback callback, void *context, FetchTrace *traceOut)
+{
+    WiFiClient client;
+    FetchTrace trace;
+    int contentLength;
+    uint32_t start = micros();
+    unsigned long deadline = millis() + GLANCES_REQUEST_TIMEOUT_MS;
+
+    if (!openRequest(endpoint, client, trace, contentLength, deadline))
+    {
+        return false;
+    }
+
+    CountingStream stream(client, deadline);
+    ArrayPass pass;
+    uint32_t mark = micros();
+    bool ok = GlancesParse::walkArray(stream, filter, element, callback, context, deadline, pass);
+    bool late = !ok && expired(deadline);
+    if (late)
+    {
+        LOG_W(LOG_MOD_GLANCES, "Timeout reading body for endpoint %s", endpoint);
+    }
+    else if (pass.error)
+    {
+        LOG_E(LOG_MOD_GLANCES, "JSON parse error for %s: %s", endpoint, pass.error.c_str());
+    }
+    client.stop();
+
+    trace.bytes = stream.count;
+    trace.phaseUs[PHASE_PARSE] = pass.parseUs;
+    trace.phaseUs[PHASE_BODY] = micros() - mark - pass.parseUs;
+    trace.phaseUs[PHASE_TOTAL] = micros() - start;
+
+    if (!ok)
+    {
+        FetchStats::recordError(endpoint, late ? FETCH_ERR_TIMEOUT : FETCH_ERR_PARSE, trace);
+        return false;
+    }
+
+    FetchStats::record(endpoint, trace);
+    FetchStats::printTrace(endpoint, trace);
+    if (traceOut)
+    {
+        *traceOut = trace;
+    }
+    return true;
+}
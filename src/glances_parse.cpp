@@ -0,0 +1,195 @@
+#include "glances_parse.h"
+#include "fs_classifier.h"
+#include "net_meter.h"
+#include "disk_meter.h"
+#include "sensor_map.h"
+#include "process_top.h"
+#include "container_top.h"
+#include "metric_format.h"
+#include <Arduino.h>
+
+static int peekNonSpace(Stream &stream, unsigned long deadline)
+{
+    while (true)
+    {
+        int c = stream.peek();
+        if (c >= 0)
+        {
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+                return c;
+            stream.read();
+            continue;
+        }
+        if ((long)(millis() - deadline) >= 0)
+            return -1;
+        delay(1);
+    }
+}
+
+bool GlancesParse::walkArray(Stream &stream, JsonDocument &filter, JsonDocument &element,
+                             ArrayElementCallback callback, void *context, unsigned long deadline, ArrayPass &pass)
+{
+    pass = ArrayPass();
+    if (!stream.find("["))
+        return false;
+
+    int next = peekNonSpace(stream, deadline);
+    while (next != ']')
+    {
+        if (next < 0)
+            return false;
+        uint32_t start = micros();
+        pass.error = deserializeJson(element, stream, DeserializationOption::Filter(filter));
+        pass.parseUs += micros() - start;
+        if (pass.error)
+            return false;
+
+        pass.elements++;
+        if (element.memoryUsage() > pass.peakElementBytes)
+            pass.peakElementBytes = element.memoryUsage();
+        pass.overflowed |= element.overflowed();
+        callback(element.as<JsonObjectConst>(), context);
+
+        next = peekNonSpace(stream, deadline);
+        if (next == ',')
+            stream.read();
+        else if (next != ']')
+            return false;
+    }
+    return true;
+}
+
+void GlancesParse::fsFilter(JsonDocument &filter)
+{
+    filter["mnt_point"] = true;
+    filter["device_name"] = true;
+    filter["fs_type"] = true;
+    filter["options"] = true;
+    filter["size"] = true;
+    filter["used"] = true;
+}
+
+void GlancesParse::onFsEntry(JsonObjectConst fs, void *context)
+{
+    FsSummary &summary = *(FsSummary *)context;
+    FsClassifier::addMount(summary, fs["mnt_point"], fs["options"], fs["device_name"], fs["fs_type"],
+                           fs["size"].as<uint64_t>(), fs["used"].as<uint64_t>());
+}
+
+static void stampPass(RatePass &pass, void (*beginPass)(uint64_t))
+{
+    if (!pass.started)
+    {
+        beginPass(pass.nowUs());
+        pass.started = true;
+    }
+}
+
+// Glances 4 has cumulative *_gauge counters; Glances 3 calls them
+// cumulative_rx/cumulative_tx
+void GlancesParse::netFilter(JsonDocument &filter)
+{
+    filter["interface_name"] = true;
+    filter["bytes_recv_gauge"] = true;
+    filter["bytes_sent_gauge"] = true;
+    filter["cumulative_rx"] = true;
+    filter["cumulative_tx"] = true;
+}
+
+void GlancesParse::onNetEntry(JsonObjectConst iface, void *context)
+{
+    stampPass(*(RatePass *)context, NetMeter::beginPass);
+
+    JsonVariantConst rx = iface["bytes_recv_gauge"];
+    JsonVariantConst tx = iface["bytes_sent_gauge"];
+    if (rx.isNull())
+    {
+        rx = iface["cumulative_rx"];
+        tx = iface["cumulative_tx"];
+    }
+    NetMeter::addInterface(iface["interface_name"], rx.as<uint64_t>(), tx.as<uint64_t>());
+}
+
+void GlancesParse::diskIoFilter(JsonDocument &filter)
+{
+    filter["disk_name"] = true;
+    filter["read_bytes_gauge"] = true;
+    filter["write_bytes_gauge"] = true;
+    filter["read_count_gauge"] = true;
+    filter["write_count_gauge"] = true;
+}
+
+void GlancesParse::onDiskIoEntry(JsonObjectConst disk, void *context)
+{
+    stampPass(*(RatePass *)context, DiskMeter::beginPass);
+    DiskMeter::addEntry(disk["disk_name"], disk["read_bytes_gauge"].as<uint64_t>(),
+                        disk["write_bytes_gauge"].as<uint64_t>(), disk["read_count_gauge"].as<uint64_t>(),
+                        disk["write_count_gauge"].as<uint64_t>());
+}
+
+void GlancesParse::sensorFilter(JsonDocument &filter)
+{
+    filter["label"] = true;
+    filter["type"] = true;
+    filter["value"] = true;
+}
+
+void GlancesParse::onSensorEntry(JsonObjectConst sensor, void *context)
+{
+    SensorMap::addSensor(sensor["label"], sensor["type"], sensor["value"].as<float>());
+}
+
+void GlancesParse::processFilter(JsonDocument &filter)
+{
+    filter["name"] = true;
+    filter["pid"] = true;
+    filter["cpu_percent"] = true;
+    filter["memory_percent"] = true;
+}
+
+void GlancesParse::onProcessEntry(JsonObjectConst process, void *context)
+{
+    ProcessTop::add(process["name"], process["pid"], process["cpu_percent"] | 0.0f,
+                    process["memory_percent"] | 0.0f);
+}
+
+void GlancesParse::containerFilter(JsonDocument &filter)
+{
+    filter["name"] = true;
+    filter["status"] = true;
+    filter["health"] = true;
+    filter["cpu_percent"] = true;
+    filter["memory_usage"] = true;
+    filter["cpu"]["total"] = true;
+    filter["memory"]["usage"] = true;
+}
+
+void GlancesParse::onContainerEntry(JsonObjectConst container, void *context)
+{
+    // Glances 4 flattens the engine stats; older releases nest them
+    float cpu = container["cpu_percent"] | (container["cpu"]["total"] | 0.0f);
+    float mem = container["memory_usage"] | (container["memory"]["usage"] | 0.0f);
+    ContainerTop::add(container["name"], ContainerTop::parseState(container["status"], container["health"]), cpu,
+                      mem / (1024.0f * 1024.0f));
+}
+
+void GlancesParse::formatUptime(JsonVariantConst uptime, char *out, size_t size)
+{
+    if (size == 0)
+        return;
+    out[0] = '\0';
+
+    uint32_t seconds;
+    if (uptime.is<const char *>())
+    {
+        // Reformatted when it parses, so both sources print the same way
+        if (MetricFormat::parseDuration(uptime.as<const char *>(), seconds))
+            MetricFormat::duration(out, size, seconds);
+        else
+            MetricFormat::text(out, size, uptime.as<const char *>());
+    }
+    else if (uptime.is<double>() && uptime.as<double>() >= 0)
+    {
+        MetricFormat::duration(out, size, (uint32_t)uptime.as<double>());
+    }
+}
@@ -0,0 +1,56 @@
+#include "glob_pattern.h"
+#include <string.h>
+
+bool GlobPattern::compile(const char *pattern, size_t patternLength)
+{
+    bool leading = patternLength > 0 && pattern[0] == '*';
+    bool trailing = patternLength > (leading ? 1u : 0u) && pattern[patternLength - 1] == '*';
+
+    const char *start = pattern + (leading ? 1 : 0);
+    size_t len = patternLength - (leading ? 1 : 0) - (trailing ? 1 : 0);
+
+    if (patternLength == 0 || len >= GLOB_PATTERN_MAX || memchr(start, '*', len) != nullptr)
+    {
+        return false;
+    }
+
+    memcpy(literal, start, len);
+    literal[len] = '\0';
+    length = len;
+
+    if (len == 0)
+        kind = ANY;
+    else if (leading && trailing)
+        kind = CONTAINS;
+    else if (leading)
+        kind = SUFFIX;
+    else if (trailing)
+        kind = PREFIX;
+    else
+        kind = EXACT;
+    return true;
+}
+
+bool GlobPattern::matches(const char *text) const
+{
+    if (!text)
+        return false;
+
+    switch (kind)
+    {
+    case EXACT:
+        return strcmp(text, literal) == 0;
+    case PREFIX:
+        return strncmp(text, literal, length) == 0;
+    case SUFFIX:
+    {
+        size_t textLength = strlen(text);
+        return textLength >= length && memcmp(text + textLength - length, literal, length) == 0;
+    }
+    case CONTAINS:
+        return strstr(text, literal) != nullptr;
+    case ANY:
+        return true;
+    }
+    return false;
+}
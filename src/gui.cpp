@@ -1,20 +1,91 @@
 #include "gui.h"
 #include "settings_manager.h"
+#include "glances_api.h"
+#include "metric_format.h"
+#include "metric_registry.h"
+#include "core_heatmap.h"
+#include "process_top.h"
+#include "container_top.h"
+#include "net_meter.h"
+#include "disk_meter.h"
+#include "sparkline.h"
+#include "log_ring.h"
 #include <Arduino.h>
 #include <stdio.h>
+#include <math.h>
 
-lv_obj_t *cpu_label = NULL;
-lv_obj_t *ram_label = NULL;
-lv_obj_t *disk_label = NULL;
-lv_obj_t *uptime_label = NULL;
-lv_obj_t *network_label = NULL;
-lv_obj_t *cores_label = NULL;
-lv_obj_t *total_ram_label = NULL;
-lv_obj_t *temp_label = NULL;
-lv_obj_t *load_label = NULL;
-lv_obj_t *cache_label = NULL;
-ArcWithLabel cpu_arc_obj = {NULL, NULL};
-ArcWithLabel ram_arc_obj = {NULL, NULL};
+#define LIST_ROW_HEIGHT 26
+
+// A row on one of the list pages: name, usage bar and value text
+struct ListRow
+{
+    lv_obj_t *row;
+    lv_obj_t *name;
+    lv_obj_t *bar;
+    lv_obj_t *value;
+    uint32_t shown; // hash of what the row displays, for set_row_if_changed()
+};
+
+// Secondary screens are created on first use and keep their rows around;
+// rows beyond the current item count are hidden rather than deleted.
+struct ListPage
+{
+    lv_obj_t *screen;
+    lv_obj_t *header;
+    lv_obj_t *list;
+    ListRow *rows;
+    uint16_t capacity;
+    uint16_t rowCount;
+};
+
+static const char *const page_names[PAGE_COUNT] = {"overview", "drives", "diskio",    "network",
+                                                   "sensors",  "cores",  "processes", "containers"};
+static GuiPage current_page = PAGE_OVERVIEW;
+static lv_obj_t *overview_screen = NULL;
+static ListRow drive_rows[FS_MAX_DRIVES];
+static ListRow diskio_rows[DISKIO_MAX_DISKS];
+static ListRow network_rows[NET_MAX_INTERFACES];
+static ListRow sensor_rows[SENSOR_MAX_SLOTS];
+static ListPage drives_page = {NULL, NULL, NULL, drive_rows, FS_MAX_DRIVES, 0};
+static ListPage diskio_page = {NULL, NULL, NULL, diskio_rows, DISKIO_MAX_DISKS, 0};
+static lv_obj_t *diskio_spark = NULL;
+static ListPage network_page = {NULL, NULL, NULL, network_rows, NET_MAX_INTERFACES, 0};
+static ListPage sensors_page = {NULL, NULL, NULL, sensor_rows, SENSOR_MAX_SLOTS, 0};
+static ListPage cores_page = {NULL, NULL, NULL, NULL, 0, 0};
+static ListRow process_rows[PROCESS_TOP_N];
+static ListPage processes_page = {NULL, NULL, NULL, process_rows, PROCESS_TOP_N, 0};
+static ListRow container_rows[CONTAINER_TOP_N];
+static ListPage containers_page = {NULL, NULL, NULL, container_rows, CONTAINER_TOP_N, 0};
+
+static const uint32_t sensor_level_colors[] = {0x00FF44, 0xFFAA00, 0xFF4444};
+
+static lv_obj_t *alert_banner = NULL;
+static bool alert_dismissed = false;
+static lv_obj_t *status_line = NULL;
+
+// Overview widget of each metric_registry row: the arc, or the card whose
+// user data is its value label. NULL for rows without a widget.
+static lv_obj_t *metric_widgets[metric_count];
+static int8_t shown_level[metric_count]; // -1 until a level colors the value
+
+// lv_label_set_text() frees and allocates the label text on every call,
+// churning the LVGL pool. Unchanged text is skipped and text of the same
+// length is copied over the old, so steady updates allocate nothing. Dot
+// mode writes into the text, so those labels take the slow path.
+static void set_label_text(lv_obj_t *label, const char *text)
+{
+    char *shown = lv_label_get_text(label);
+    if (shown && strcmp(shown, text) == 0)
+        return;
+    size_t length = strlen(text);
+    if (shown && strlen(shown) == length && lv_label_get_long_mode(label) != LV_LABEL_LONG_DOT)
+    {
+        memcpy(shown, text, length);
+        lv_label_set_text(label, NULL);
+        return;
+    }
+    lv_label_set_text(label, text);
+}
 
 ArcWithLabel create_arc(lv_obj_t *parent, const char *text, lv_color_t color)
 {
@@ -97,7 +168,9 @@ lv_obj_t *create_button_label(lv_obj_t *parent, const char *text, const ThemeCol
     return label;
 }
 
-lv_obj_t *create_compact_label(lv_obj_t *parent, const char *text, const ThemeColors *theme)
+// Card with the row's icon on the left and its value on the right; a row
+// without an icon gets a single centered label instead
+static lv_obj_t *create_metric_card(lv_obj_t *parent, const MetricDesc &desc, const ThemeColors *theme)
 {
     lv_obj_t *btn = lv_obj_create(parent);
     lv_obj_set_size(btn, 154, LV_SIZE_CONTENT);
@@ -110,215 +183,792 @@ lv_obj_t *create_compact_label(lv_obj_t *parent, const char *text, const ThemeCo
     lv_obj_set_style_shadow_color(btn, lv_color_darken(theme->bg_color, LV_OPA_30), 0);
     lv_obj_set_style_pad_all(btn, 5, 0);
 
-    if (strstr(text, LV_SYMBOL_DOWNLOAD) && strstr(text, LV_SYMBOL_UPLOAD))
+    if (desc.title)
+    {
+        lv_obj_set_flex_flow(btn, LV_FLEX_FLOW_ROW);
+        lv_obj_set_flex_align(btn, LV_FLEX_ALIGN_SPACE_BETWEEN, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+        lv_obj_t *icon_label = lv_label_create(btn);
+        lv_label_set_text(icon_label, desc.title);
+        lv_obj_set_style_text_font(icon_label, &lv_font_montserrat_14, 0);
+        lv_obj_set_style_text_color(icon_label, theme->text_color, 0);
+    }
+
+    lv_obj_t *text_label = lv_label_create(btn);
+    lv_label_set_text(text_label, desc.placeholder);
+    lv_obj_set_style_text_font(text_label, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_text_color(text_label, theme->text_color, 0);
+    if (!desc.title)
     {
-        lv_obj_t *text_label = lv_label_create(btn);
-        lv_label_set_text(text_label, text);
-        lv_obj_set_style_text_font(text_label, &lv_font_montserrat_14, 0);
-        lv_obj_set_style_text_color(text_label, theme->text_color, 0);
         lv_obj_set_width(text_label, 140);
         lv_obj_set_style_text_align(text_label, LV_TEXT_ALIGN_CENTER, 0);
         lv_obj_align(text_label, LV_ALIGN_CENTER, 0, 0);
-        lv_obj_set_user_data(btn, text_label);
-        return btn;
     }
+    lv_obj_set_user_data(btn, text_label);
+
+    return btn;
+}
+
+void set_arc_value_animated(lv_obj_t *arc, int32_t value, uint32_t duration)
+{
+    if (!arc)
+        return;
+
+    value = (value < 0) ? 0 : (value > 100) ? 100
+                                            : value;
+    // Every animation is allocated; an arc at rest on the value needs none
+    if (lv_arc_get_value(arc) == value && !lv_anim_get(arc, (lv_anim_exec_xcb_t)lv_arc_set_value))
+        return;
+
+    static lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, arc);
+    lv_anim_set_exec_cb(&a, (lv_anim_exec_xcb_t)lv_arc_set_value);
+    lv_anim_set_values(&a, lv_arc_get_value(arc), value);
+    lv_anim_set_time(&a, duration);
+    lv_anim_set_path_cb(&a, lv_anim_path_ease_out);
+    lv_anim_set_ready_cb(&a, NULL);
+    lv_anim_start(&a);
+}
+
+void update_arc_label(lv_obj_t *label, const char *text)
+{
+    if (!label || !text)
+        return;
+    set_label_text(label, text);
+}
+
+static void style_list_row(ListRow &row, const ThemeColors &theme)
+{
+    lv_obj_set_style_bg_color(row.row, theme.card_bg_color, 0);
+    lv_obj_set_style_border_color(row.row, theme.border_color, 0);
+    lv_obj_set_style_text_color(row.name, theme.text_color, 0);
+    lv_obj_set_style_text_color(row.value, theme.text_color, 0);
+    lv_obj_set_style_bg_color(row.bar, theme.border_color, LV_PART_MAIN);
+    row.shown = 0;
+}
+
+static void style_list_page(ListPage &page, const ThemeColors &theme)
+{
+    if (!page.screen)
+        return;
 
-    if (!strstr(text, LV_SYMBOL_DOWNLOAD) || !strstr(text, LV_SYMBOL_UPLOAD))
+    lv_obj_set_style_bg_color(page.screen, theme.bg_color, 0);
+    lv_obj_set_style_text_color(page.header, theme.text_color, 0);
+    for (uint16_t i = 0; i < page.rowCount; i++)
     {
-        lv_obj_set_flex_flow(btn, LV_FLEX_FLOW_ROW);
-        lv_obj_set_flex_align(btn, LV_FLEX_ALIGN_SPACE_BETWEEN, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+        style_list_row(page.rows[i], theme);
     }
+}
+
+static void create_list_page(ListPage &page, const char *title)
+{
+    const ThemeColors &theme = SettingsManager::getCurrentTheme();
+
+    page.screen = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(page.screen, theme.bg_color, 0);
+    lv_obj_set_style_pad_all(page.screen, 4, 0);
+    lv_obj_set_style_pad_row(page.screen, 4, 0);
+    lv_obj_set_flex_flow(page.screen, LV_FLEX_FLOW_COLUMN);
+    lv_obj_clear_flag(page.screen, LV_OBJ_FLAG_SCROLLABLE);
+
+    page.header = lv_label_create(page.screen);
+    lv_obj_set_style_text_font(page.header, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_text_color(page.header, theme.text_color, 0);
+    lv_label_set_text(page.header, title);
 
-    bool is_temp = strstr(text, "Temp:") != NULL;
+    page.list = lv_obj_create(page.screen);
+    lv_obj_set_width(page.list, lv_pct(100));
+    lv_obj_set_flex_grow(page.list, 1);
+    lv_obj_set_style_bg_opa(page.list, LV_OPA_0, 0);
+    lv_obj_set_style_border_width(page.list, 0, 0);
+    lv_obj_set_style_pad_all(page.list, 0, 0);
+    lv_obj_set_style_pad_row(page.list, 3, 0);
+    lv_obj_set_flex_flow(page.list, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_scroll_dir(page.list, LV_DIR_VER);
+
+    page.rowCount = 0;
+}
 
-    lv_obj_t *icon_label = lv_label_create(btn);
-    char icon[32];
-    const char *space_pos = strchr(text, ' ');
-    if (space_pos)
+static ListRow &list_row(ListPage &page, uint16_t index, const ThemeColors &theme)
+{
+    while (page.rowCount <= index)
     {
-        size_t icon_len = space_pos - text;
-        strncpy(icon, text, icon_len);
-        icon[icon_len] = '\0';
+        ListRow &row = page.rows[page.rowCount++];
+
+        row.row = lv_obj_create(page.list);
+        lv_obj_set_size(row.row, lv_pct(100), LIST_ROW_HEIGHT);
+        lv_obj_set_style_radius(row.row, 5, 0);
+        lv_obj_set_style_bg_opa(row.row, LV_OPA_50, 0);
+        lv_obj_set_style_border_width(row.row, 1, 0);
+        lv_obj_set_style_pad_hor(row.row, 6, 0);
+        lv_obj_set_style_pad_ver(row.row, 0, 0);
+        lv_obj_clear_flag(row.row, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_set_flex_flow(row.row, LV_FLEX_FLOW_ROW);
+        lv_obj_set_flex_align(row.row, LV_FLEX_ALIGN_SPACE_BETWEEN, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+
+        row.name = lv_label_create(row.row);
+        lv_obj_set_width(row.name, 80);
+        lv_label_set_long_mode(row.name, LV_LABEL_LONG_DOT);
+        lv_obj_set_style_text_font(row.name, &lv_font_montserrat_14, 0);
+
+        row.bar = lv_bar_create(row.row);
+        lv_obj_set_size(row.bar, 110, 8);
+        lv_bar_set_range(row.bar, 0, 100);
+
+        row.value = lv_label_create(row.row);
+        lv_obj_set_width(row.value, 90);
+        lv_obj_set_style_text_align(row.value, LV_TEXT_ALIGN_RIGHT, 0);
+        lv_obj_set_style_text_font(row.value, &lv_font_montserrat_14, 0);
+
+        style_list_row(row, theme);
     }
-    else
+    return page.rows[index];
+}
+
+static void hide_rows_from(ListPage &page, uint16_t first)
+{
+    for (uint16_t i = first; i < page.rowCount; i++)
     {
-        strcpy(icon, "");
+        lv_obj_add_flag(page.rows[i].row, LV_OBJ_FLAG_HIDDEN);
     }
-    lv_label_set_text(icon_label, icon);
-    lv_obj_set_style_text_font(icon_label, &lv_font_montserrat_14, 0);
-    lv_obj_set_style_text_color(icon_label, theme->text_color, 0);
+}
 
-    lv_obj_t *text_label = lv_label_create(btn);
-    if (space_pos)
+static uint32_t hash_text(uint32_t hash, const char *text)
+{
+    while (*text)
     {
-        const char *text_start = space_pos + 1;
-        lv_label_set_text(text_label, text_start);
+        hash ^= (uint8_t)*text++;
+        hash *= 16777619u;
     }
-    else
+    return hash;
+}
+
+// Skips every LVGL call, and so the invalidation and redraw, when the row
+// would show the same thing again
+static void set_row_if_changed(ListRow &row, const char *name, int32_t percent, lv_color_t barColor,
+                               lv_color_t nameColor, const char *value)
+{
+    uint32_t hash = hash_text(hash_text(2166136261u, name), value);
+    hash = (hash ^ (uint32_t)percent) * 16777619u;
+    hash = (hash ^ lv_color_to32(barColor)) * 16777619u;
+    hash = (hash ^ lv_color_to32(nameColor)) * 16777619u;
+    if (hash == row.shown)
+        return;
+
+    row.shown = hash;
+    set_label_text(row.name, name);
+    lv_obj_set_style_text_color(row.name, nameColor, 0);
+    lv_bar_set_value(row.bar, percent, LV_ANIM_OFF);
+    lv_obj_set_style_bg_color(row.bar, barColor, LV_PART_INDICATOR);
+    set_label_text(row.value, value);
+}
+
+lv_color_t sensor_level_color(SensorLevel level)
+{
+    return lv_color_hex(sensor_level_colors[level <= SENSOR_LEVEL_CRIT ? level : SENSOR_LEVEL_CRIT]);
+}
+
+static bool metric_ready(const MetricDesc &desc)
+{
+    return desc.kind == METRIC_UPTIME ? host_metrics.uptime[0] != '\0' : !isnan(host_metrics.*desc.value);
+}
+
+static void refresh_overview()
+{
+    char buf[64];
+
+    for (size_t row = 0; row < metric_count; row++)
     {
-        lv_label_set_text(text_label, "");
+        const MetricDesc &desc = metric_registry[row];
+        lv_obj_t *widget = metric_widgets[row];
+        if (!widget || !metric_ready(desc))
+            continue;
+
+        lv_obj_t *value_label;
+        if (desc.widget == WIDGET_ARC)
+        {
+            lv_obj_t **labels = (lv_obj_t **)lv_obj_get_user_data(widget);
+            value_label = labels[1];
+            desc.format(buf, sizeof(buf), host_metrics);
+            set_label_text(labels[1], buf);
+            desc.detail(buf, sizeof(buf), host_metrics);
+            set_label_text(labels[2], buf);
+            set_arc_value_animated(widget, host_metrics.*desc.value);
+        }
+        else
+        {
+            value_label = (lv_obj_t *)lv_obj_get_user_data(widget);
+            desc.format(buf, sizeof(buf), host_metrics);
+            set_label_text(value_label, buf);
+        }
+
+        // Restyling invalidates the label, so only a new level is applied
+        if (desc.level)
+        {
+            SensorLevel level = desc.level(host_metrics);
+            if (shown_level[row] != level)
+            {
+                lv_obj_set_style_text_color(value_label, sensor_level_color(level), 0);
+                shown_level[row] = level;
+            }
+        }
     }
-    lv_obj_set_style_text_font(text_label, &lv_font_montserrat_14, 0);
-    if (!strstr(text, "Temp:"))
+}
+
+static void update_drive_list()
+{
+    const FsSummary &summary = fs_summary;
+    const ThemeColors &theme = SettingsManager::getCurrentTheme();
+    char buf[80];
+    snprintf(buf, sizeof(buf), LV_SYMBOL_DRIVE " Array %.1f%% (%u)   " LV_SYMBOL_SAVE " Cache %.1f%% (%u)",
+             FsClassifier::percent(summary.arrayUsed, summary.arraySize), summary.arrayCount,
+             FsClassifier::percent(summary.cacheUsed, summary.cacheSize), summary.cacheCount);
+    set_label_text(drives_page.header, buf);
+
+    for (uint16_t i = 0; i < summary.driveCount; i++)
     {
-        lv_obj_set_style_text_color(text_label, theme->text_color, 0);
+        const DriveInfo &drive = summary.drives[i];
+        ListRow &row = list_row(drives_page, i, theme);
+
+        lv_obj_clear_flag(row.row, LV_OBJ_FLAG_HIDDEN);
+        set_label_text(row.name, drive.name);
+        lv_bar_set_value(row.bar, (int32_t)drive.percent, LV_ANIM_OFF);
+        lv_obj_set_style_bg_color(row.bar, drive.group == FS_GROUP_CACHE ? theme.ram_color : theme.cpu_color,
+                                  LV_PART_INDICATOR);
+        size_t len = MetricFormat::percent(buf, sizeof(buf), drive.percent, 0);
+        len += MetricFormat::text(buf + len, sizeof(buf) - len, " / ");
+        MetricFormat::bytes(buf + len, sizeof(buf) - len, drive.size);
+        set_label_text(row.value, buf);
     }
-    lv_obj_set_user_data(btn, text_label);
+    hide_rows_from(drives_page, summary.driveCount);
+}
 
-    return btn;
+static void create_diskio_page()
+{
+    create_list_page(diskio_page, LV_SYMBOL_DRIVE " Disk I/O");
+    diskio_spark = sparkline_create(diskio_page.screen);
+    lv_obj_set_size(diskio_spark, lv_pct(100), 44);
+    lv_obj_move_to_index(diskio_spark, 1);
+    sparkline_set_color(diskio_spark, SettingsManager::getCurrentTheme().cpu_color);
 }
 
-void update_compact_label(lv_obj_t *btn, const char *text)
+// Bars are relative to the busiest disk; it is named in the accent color
+static void update_diskio_page()
 {
-    lv_obj_t *text_label = (lv_obj_t *)lv_obj_get_user_data(btn);
+    const ThemeColors &theme = SettingsManager::getCurrentTheme();
+    const DiskTotals &totals = DiskMeter::totals();
+    char rd[16], wr[16], buf[64];
 
-    if (strstr(text, LV_SYMBOL_DOWNLOAD) && strstr(text, LV_SYMBOL_UPLOAD))
+    float scale = 0;
+    if (totals.busiest >= 0)
     {
-        lv_label_set_text(text_label, text);
-        return;
+        const DiskRate &busiest = DiskMeter::disk(totals.busiest);
+        scale = busiest.readRate + busiest.writeRate;
     }
 
-    if (strstr(text, "Temp:"))
+    uint16_t shown = 0;
+    for (size_t i = 0; i < DiskMeter::diskCount() && shown < DISKIO_MAX_DISKS; i++)
     {
-        const char *temp_start = strstr(text, "Temp:") + 5;
-        int temperature = 0;
+        const DiskRate &disk = DiskMeter::disk(i);
+        ListRow &row = list_row(diskio_page, shown++, theme);
+        float total = disk.readRate + disk.writeRate;
 
-        if (sscanf(temp_start, "%d", &temperature) == 1)
+        lv_obj_clear_flag(row.row, LV_OBJ_FLAG_HIDDEN);
+        if (disk.valid)
         {
-            lv_color_t temp_color;
-            if (temperature < 40)
-            {
-                temp_color = lv_color_hex(0x00FF44);
-            }
-            else if (temperature < 50)
-            {
-                temp_color = lv_color_hex(0xFFAA00);
-            }
-            else
-            {
-                temp_color = lv_color_hex(0xFF4444);
-            }
+            MetricFormat::rate(rd, sizeof(rd), disk.readRate);
+            MetricFormat::rate(wr, sizeof(wr), disk.writeRate);
+            snprintf(buf, sizeof(buf), "%s/%s %.0f", rd, wr, disk.readIops + disk.writeIops);
+        }
+        else
+        {
+            snprintf(buf, sizeof(buf), "--");
+        }
+        set_row_if_changed(row, disk.name, disk.valid && scale > 0 ? (int32_t)(total * 100 / scale) : 0,
+                           disk.stacked ? theme.ram_color : theme.cpu_color,
+                           (int8_t)i == totals.busiest ? theme.cpu_color : theme.text_color, buf);
+    }
+    hide_rows_from(diskio_page, shown);
+
+    if (totals.valid)
+    {
+        MetricFormat::rate(rd, sizeof(rd), totals.readRate);
+        MetricFormat::rate(wr, sizeof(wr), totals.writeRate);
+        snprintf(buf, sizeof(buf), LV_SYMBOL_DRIVE " R %s W %s  %.0f IOPS  %s", rd, wr,
+                 totals.readIops + totals.writeIops,
+                 totals.busiest >= 0 ? DiskMeter::disk(totals.busiest).name : "idle");
+    }
+    else
+    {
+        snprintf(buf, sizeof(buf), LV_SYMBOL_DRIVE " Disk I/O  --");
+    }
+    set_label_text(diskio_page.header, buf);
 
-            lv_obj_set_style_text_color(text_label, temp_color, 0);
+    if (diskio_spark)
+    {
+        float history[DISKIO_HISTORY];
+        size_t count = DiskMeter::history(history, DISKIO_HISTORY);
+        sparkline_set_values(diskio_spark, history, count);
+    }
+}
+
+// Bars are relative to the held download peak of the selected interfaces
+static void update_network_page()
+{
+    const ThemeColors &theme = SettingsManager::getCurrentTheme();
+    const NetRates &net = NetMeter::rates();
+    float scale = net.rxPeak > net.txPeak ? net.rxPeak : net.txPeak;
+    char rx[16], tx[16], buf[64];
+
+    MetricFormat::rate(rx, sizeof(rx), net.rxPeak);
+    MetricFormat::rate(tx, sizeof(tx), net.txPeak);
+    snprintf(buf, sizeof(buf), LV_SYMBOL_WIFI " %s  peak " LV_SYMBOL_DOWNLOAD "%s " LV_SYMBOL_UPLOAD "%s",
+             net.valid ? net.name : "--", rx, tx);
+    set_label_text(network_page.header, buf);
+
+    uint16_t shown = 0;
+    for (size_t i = 0; i < NetMeter::interfaceCount() && shown < NET_MAX_INTERFACES; i++)
+    {
+        NetInterfaceRate rate = NetMeter::interfaceRate(i);
+        ListRow &row = list_row(network_page, shown++, theme);
+        float total = rate.rxRate + rate.txRate;
+
+        lv_obj_clear_flag(row.row, LV_OBJ_FLAG_HIDDEN);
+        set_label_text(row.name, rate.name);
+        lv_bar_set_value(row.bar, rate.valid && scale > 0 ? (int32_t)(total * 100 / scale) : 0, LV_ANIM_OFF);
+        lv_obj_set_style_bg_color(row.bar, theme.cpu_color, LV_PART_INDICATOR);
+        if (rate.valid)
+        {
+            MetricFormat::rate(rx, sizeof(rx), rate.rxRate);
+            MetricFormat::rate(tx, sizeof(tx), rate.txRate);
+            snprintf(buf, sizeof(buf), "%s / %s", rx, tx);
         }
         else
         {
-            Serial.println("Failed to parse temperature!");
+            snprintf(buf, sizeof(buf), "--");
         }
+        set_label_text(row.value, buf);
+    }
+    hide_rows_from(network_page, shown);
+}
+
+// Bars span 0 °C to each sensor's critical threshold
+static void update_sensor_panel()
+{
+    const ThemeColors &theme = SettingsManager::getCurrentTheme();
+    uint16_t shown = 0;
+    char buf[40];
+
+    for (size_t i = 0; i < SensorMap::slotCount(); i++)
+    {
+        const SensorReading &reading = SensorMap::reading(i);
+        if (!reading.present)
+            continue;
 
-        lv_label_set_text(text_label, temp_start);
+        const SensorSlot &slot = SensorMap::slot(i);
+        ListRow &row = list_row(sensors_page, shown++, theme);
+        int32_t percent = slot.crit > 0 ? (int32_t)(reading.value * 100 / slot.crit) : 0;
+
+        lv_obj_clear_flag(row.row, LV_OBJ_FLAG_HIDDEN);
+        set_label_text(row.name, slot.name);
+        lv_bar_set_value(row.bar, percent > 100 ? 100 : percent, LV_ANIM_OFF);
+        lv_obj_set_style_bg_color(row.bar, sensor_level_color(reading.level), LV_PART_INDICATOR);
+        snprintf(buf, sizeof(buf), "%.0f° (%.0f-%.0f)", reading.value, reading.min, reading.max);
+        set_label_text(row.value, buf);
+    }
+    hide_rows_from(sensors_page, shown);
+
+    snprintf(buf, sizeof(buf), LV_SYMBOL_WARNING " Temperatures (%u)", shown);
+    set_label_text(sensors_page.header, buf);
+}
+
+static void style_core_heatmap(const ThemeColors &theme)
+{
+    core_heatmap_set_colors(lv_color_darken(theme.card_bg_color, LV_OPA_10), theme.cpu_color,
+                            lv_color_hex(sensor_level_colors[SENSOR_LEVEL_CRIT]));
+}
+
+static void create_cores_page()
+{
+    create_list_page(cores_page, LV_SYMBOL_LIST " CPU cores");
+    lv_obj_t *map = core_heatmap_create(cores_page.list);
+    lv_obj_set_width(map, lv_pct(100));
+    lv_obj_set_flex_grow(map, 1);
+    style_core_heatmap(SettingsManager::getCurrentTheme());
+}
+
+static void update_core_heatmap()
+{
+    const PerCpuLoads &loads = percpu_loads;
+    if (loads.count == 0)
         return;
+
+    float sum = 0;
+    float peak = 0;
+    for (uint16_t i = 0; i < loads.count; i++)
+    {
+        sum += loads.total[i];
+        if (loads.total[i] > peak)
+            peak = loads.total[i];
     }
 
-    const char *space_pos = strchr(text, ' ');
-    if (space_pos)
+    char buf[64];
+    snprintf(buf, sizeof(buf), LV_SYMBOL_LIST " %u cores   avg %.0f%%   max %.0f%%", loads.count,
+             sum / loads.count, peak);
+    set_label_text(cores_page.header, buf);
+    core_heatmap_set_loads(loads.total, loads.count);
+}
+
+// Bars show the sort key; the value column has CPU and memory share
+static void update_process_list()
+{
+    const ThemeColors &theme = SettingsManager::getCurrentTheme();
+    bool byMem = ProcessTop::sort() == PROCESS_SORT_MEM;
+    char buf[64];
+
+    for (size_t i = 0; i < ProcessTop::count(); i++)
     {
-        const char *text_start = space_pos + 1;
-        lv_label_set_text(text_label, text_start);
+        const ProcessEntry &process = ProcessTop::entry(i);
+        ListRow &row = list_row(processes_page, i, theme);
+        float key = byMem ? process.mem : process.cpu;
+
+        lv_obj_clear_flag(row.row, LV_OBJ_FLAG_HIDDEN);
+        set_label_text(row.name, process.name);
+        lv_bar_set_value(row.bar, key > 100 ? 100 : (int32_t)key, LV_ANIM_OFF);
+        lv_obj_set_style_bg_color(row.bar, byMem ? theme.ram_color : theme.cpu_color, LV_PART_INDICATOR);
+        snprintf(buf, sizeof(buf), "%.1f%% %.1f%%", process.cpu, process.mem);
+        set_label_text(row.value, buf);
     }
+    hide_rows_from(processes_page, ProcessTop::count());
+
+    snprintf(buf, sizeof(buf), LV_SYMBOL_SHUFFLE " Top %s  %u procs  %.1f ms", byMem ? "memory" : "CPU",
+             ProcessTop::processCount(), ProcessTop::parseUs() / 1000.0f);
+    set_label_text(processes_page.header, buf);
 }
 
-void set_arc_value_animated(lv_obj_t *arc, int32_t value, uint32_t duration)
+// Problem containers are named in the critical color. Bars show the sort key,
+// CPU relative to one core and memory relative to the largest listed one.
+static void update_container_list()
 {
-    if (!arc)
+    const ThemeColors &theme = SettingsManager::getCurrentTheme();
+    const ContainerSummary &summary = ContainerTop::summary();
+    bool byMem = ContainerTop::sort() == PROCESS_SORT_MEM;
+    float memScale = 0;
+    char buf[64];
+
+    for (size_t i = 0; i < ContainerTop::count(); i++)
+    {
+        if (ContainerTop::entry(i).memMb > memScale)
+            memScale = ContainerTop::entry(i).memMb;
+    }
+
+    for (size_t i = 0; i < ContainerTop::count(); i++)
+    {
+        const ContainerEntry &container = ContainerTop::entry(i);
+        ListRow &row = list_row(containers_page, i, theme);
+        bool problem = container.state >= CONTAINER_RESTARTING;
+        float key = byMem ? (memScale > 0 ? container.memMb * 100 / memScale : 0) : container.cpu;
+
+        lv_obj_clear_flag(row.row, LV_OBJ_FLAG_HIDDEN);
+        if (problem)
+            snprintf(buf, sizeof(buf), "%s", ContainerTop::stateName(container.state));
+        else
+            snprintf(buf, sizeof(buf), "%.1f%% %.0fM", container.cpu, container.memMb);
+        set_row_if_changed(row, container.name, key > 100 ? 100 : (int32_t)key,
+                           byMem ? theme.ram_color : theme.cpu_color,
+                           problem ? sensor_level_color(SENSOR_LEVEL_CRIT) : theme.text_color, buf);
+    }
+    hide_rows_from(containers_page, ContainerTop::count());
+
+    int len = snprintf(buf, sizeof(buf), LV_SYMBOL_LIST " %u/%u running", summary.running, summary.total);
+    if (summary.restarting + summary.unhealthy > 0 && len > 0 && len < (int)sizeof(buf))
+        snprintf(buf + len, sizeof(buf) - len, "  " LV_SYMBOL_WARNING " %u restarting %u unhealthy",
+                 summary.restarting, summary.unhealthy);
+    set_label_text(containers_page.header, buf);
+}
+
+// Detail pages in swipe order; the overview is not a list page and is never
+// freed
+static ListPage *const list_pages[PAGE_COUNT] = {
+    NULL,          &drives_page, &diskio_page,    &network_page,
+    &sensors_page, &cores_page,  &processes_page, &containers_page};
+static const char *const page_titles[PAGE_COUNT] = {
+    "",
+    LV_SYMBOL_DRIVE " Drives",
+    LV_SYMBOL_DRIVE " Disk I/O",
+    LV_SYMBOL_WIFI " Network",
+    LV_SYMBOL_WARNING " Temperatures",
+    LV_SYMBOL_LIST " CPU cores",
+    LV_SYMBOL_SHUFFLE " Processes",
+    LV_SYMBOL_LIST " Containers"};
+static uint32_t page_hidden_ms[PAGE_COUNT];
+
+static void show_page_cb(lv_event_t *e)
+{
+    gui_show_page((GuiPage)(uintptr_t)lv_event_get_user_data(e));
+}
+
+static void gesture_cb(lv_event_t *e)
+{
+    lv_dir_t dir = lv_indev_get_gesture_dir(lv_indev_get_act());
+    int step = dir == LV_DIR_LEFT ? 1 : dir == LV_DIR_RIGHT ? -1 : 0;
+    if (step == 0)
         return;
 
-    value = (value < 0) ? 0 : (value > 100) ? 100
-                                            : value;
+    lv_indev_wait_release(lv_indev_get_act());
+    gui_show_page((GuiPage)((current_page + step + PAGE_COUNT) % PAGE_COUNT));
+}
 
-    static lv_anim_t a;
-    lv_anim_init(&a);
-    lv_anim_set_var(&a, arc);
-    lv_anim_set_exec_cb(&a, (lv_anim_exec_xcb_t)lv_arc_set_value);
-    lv_anim_set_values(&a, lv_arc_get_value(arc), value);
-    lv_anim_set_time(&a, duration);
-    lv_anim_set_path_cb(&a, lv_anim_path_ease_out);
-    lv_anim_set_ready_cb(&a, NULL);
-    lv_anim_start(&a);
+static void make_page_link(lv_obj_t *obj, GuiPage target)
+{
+    if (!obj)
+        return;
+    lv_obj_add_flag(obj, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(obj, show_page_cb, LV_EVENT_CLICKED, (void *)(uintptr_t)target);
 }
 
-void update_arc_label(lv_obj_t *label, const char *text)
+static lv_obj_t *page_screen(GuiPage page)
 {
-    if (!label || !text)
+    return page == PAGE_OVERVIEW ? overview_screen : list_pages[page]->screen;
+}
+
+static void create_page(GuiPage page)
+{
+    if (page == PAGE_CORES)
+        create_cores_page();
+    else if (page == PAGE_DISKIO)
+        create_diskio_page();
+    else
+        create_list_page(*list_pages[page], page_titles[page]);
+
+    ListPage &created = *list_pages[page];
+    lv_obj_add_event_cb(created.screen, gesture_cb, LV_EVENT_GESTURE, NULL);
+    // Tapping the title goes back to the overview
+    make_page_link(created.header, PAGE_OVERVIEW);
+}
+
+static void free_page(GuiPage page)
+{
+    ListPage &freed = *list_pages[page];
+    lv_obj_del(freed.screen);
+    freed.screen = NULL;
+    freed.header = NULL;
+    freed.list = NULL;
+    freed.rowCount = 0;
+    if (page == PAGE_DISKIO)
+        diskio_spark = NULL;
+    LOG_D(LOG_MOD_SYSTEM, "Freed page %s", page_names[page]);
+}
+
+static void refresh_page(GuiPage page)
+{
+    switch (page)
+    {
+    case PAGE_OVERVIEW:
+        refresh_overview();
+        break;
+    case PAGE_DRIVES:
+        update_drive_list();
+        break;
+    case PAGE_DISKIO:
+        update_diskio_page();
+        break;
+    case PAGE_NETWORK:
+        update_network_page();
+        break;
+    case PAGE_SENSORS:
+        update_sensor_panel();
+        break;
+    case PAGE_CORES:
+        update_core_heatmap();
+        break;
+    case PAGE_PROCESSES:
+        update_process_list();
+        break;
+    case PAGE_CONTAINERS:
+        update_container_list();
+        break;
+    default:
+        break;
+    }
+}
+
+void gui_show_page(GuiPage page)
+{
+    if (page >= PAGE_COUNT || page == current_page || !overview_screen)
         return;
-    lv_label_set_text(label, text);
+
+    if (!page_screen(page))
+    {
+        create_page(page);
+    }
+    refresh_page(page);
+    lv_scr_load(page_screen(page));
+
+    page_hidden_ms[current_page] = millis();
+    current_page = page;
 }
 
-void applyTheme(bool darkMode)
+GuiPage gui_current_page()
 {
-    const ThemeColors &theme = SettingsManager::getCurrentTheme();
-    lv_obj_set_style_bg_color(lv_scr_act(), theme.bg_color, 0);
+    return current_page;
+}
 
-    if (cpu_arc_obj.arc)
+bool gui_find_page(const char *name, GuiPage &page)
+{
+    for (int i = 0; i < PAGE_COUNT; i++)
     {
-        lv_obj_set_style_arc_color(cpu_arc_obj.arc, theme.cpu_color, LV_PART_INDICATOR);
-        lv_obj_set_style_arc_color(cpu_arc_obj.arc, lv_color_darken(theme.cpu_color, LV_OPA_30), LV_PART_MAIN);
-        lv_obj_t **labels = (lv_obj_t **)lv_obj_get_user_data(cpu_arc_obj.arc);
-        if (labels)
+        if (strcmp(name, page_names[i]) == 0)
         {
-            lv_obj_set_style_text_color(labels[0], theme.text_color, 0);
-            lv_obj_set_style_text_color(labels[1], theme.text_color, 0);
-            lv_obj_set_style_text_color(labels[2], lv_color_hex(0x808080), 0);
+            page = (GuiPage)i;
+            return true;
         }
     }
+    return false;
+}
 
-    if (ram_arc_obj.arc)
-    {
-        lv_obj_set_style_arc_color(ram_arc_obj.arc, theme.ram_color, LV_PART_INDICATOR);
-        lv_obj_set_style_arc_color(ram_arc_obj.arc, lv_color_darken(theme.ram_color, LV_OPA_30), LV_PART_MAIN);
+void gui_refresh()
+{
+    refresh_page(current_page);
 
-        lv_obj_t **labels = (lv_obj_t **)lv_obj_get_user_data(ram_arc_obj.arc);
-        if (labels)
+#if GUI_FREE_IDLE_PAGE_MS > 0
+    for (int i = PAGE_OVERVIEW + 1; i < PAGE_COUNT; i++)
+    {
+        if (i != current_page && list_pages[i]->screen && millis() - page_hidden_ms[i] > GUI_FREE_IDLE_PAGE_MS)
         {
+            free_page((GuiPage)i);
+        }
+    }
+#endif
+}
 
-            lv_obj_set_style_text_color(labels[0], theme.text_color, 0);
-            lv_obj_set_style_text_color(labels[1], theme.text_color, 0);
+static void alert_banner_cb(lv_event_t *e)
+{
+    alert_dismissed = true;
+    lv_obj_add_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
+}
 
-            lv_obj_set_style_text_color(labels[2], lv_color_hex(0x808080), 0);
-        }
+// The banner lives on the top layer so it shows over every page
+void gui_show_alert(const char *text, bool reveal)
+{
+    if (!alert_banner)
+    {
+        alert_banner = lv_label_create(lv_layer_top());
+        lv_obj_set_width(alert_banner, lv_pct(100));
+        lv_obj_align(alert_banner, LV_ALIGN_TOP_MID, 0, 0);
+        lv_obj_set_style_bg_color(alert_banner, lv_color_hex(sensor_level_colors[SENSOR_LEVEL_CRIT]), 0);
+        lv_obj_set_style_bg_opa(alert_banner, LV_OPA_COVER, 0);
+        lv_obj_set_style_text_color(alert_banner, lv_color_white(), 0);
+        lv_obj_set_style_text_font(alert_banner, &lv_font_montserrat_14, 0);
+        lv_obj_set_style_pad_all(alert_banner, 4, 0);
+        lv_label_set_long_mode(alert_banner, LV_LABEL_LONG_DOT);
+        // Tap to dismiss until the next alert fires
+        lv_obj_add_flag(alert_banner, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_add_event_cb(alert_banner, alert_banner_cb, LV_EVENT_CLICKED, NULL);
+    }
+
+    lv_label_set_text(alert_banner, text);
+    if (reveal)
+        alert_dismissed = false;
+    if (alert_dismissed)
+        lv_obj_add_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
+    else
+        lv_obj_clear_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
+}
+
+void gui_hide_alert()
+{
+    alert_dismissed = false;
+    if (alert_banner)
+        lv_obj_add_flag(alert_banner, LV_OBJ_FLAG_HIDDEN);
+}
+
+void gui_set_status(const char *text)
+{
+    if (!text)
+    {
+        if (status_line)
+            lv_obj_add_flag(status_line, LV_OBJ_FLAG_HIDDEN);
+        return;
     }
 
-    lv_obj_t *compact_labels[] = {
-        temp_label,
-        load_label,
-        uptime_label,
-        disk_label,
-        cache_label,
-        network_label};
+    if (!status_line)
+    {
+        status_line = lv_label_create(lv_layer_top());
+        lv_obj_set_width(status_line, lv_pct(100));
+        lv_obj_align(status_line, LV_ALIGN_BOTTOM_MID, 0, 0);
+        lv_obj_set_style_bg_color(status_line, lv_color_black(), 0);
+        lv_obj_set_style_bg_opa(status_line, LV_OPA_70, 0);
+        lv_obj_set_style_text_color(status_line, lv_color_white(), 0);
+        lv_obj_set_style_text_font(status_line, &lv_font_montserrat_14, 0);
+        lv_obj_set_style_text_align(status_line, LV_TEXT_ALIGN_CENTER, 0);
+        lv_obj_set_style_pad_all(status_line, 4, 0);
+        lv_label_set_long_mode(status_line, LV_LABEL_LONG_DOT);
+    }
+    set_label_text(status_line, text);
+    lv_obj_clear_flag(status_line, LV_OBJ_FLAG_HIDDEN);
+}
 
-    for (lv_obj_t *label : compact_labels)
+void applyTheme(bool darkMode)
+{
+    const ThemeColors &theme = SettingsManager::getCurrentTheme();
+    lv_obj_set_style_bg_color(overview_screen ? overview_screen : lv_scr_act(), theme.bg_color, 0);
+    for (ListPage *page : list_pages)
+    {
+        if (page)
+            style_list_page(*page, theme);
+    }
+    if (cores_page.screen)
+    {
+        style_core_heatmap(theme);
+    }
+    if (diskio_spark)
     {
-        if (label)
+        sparkline_set_color(diskio_spark, theme.cpu_color);
+    }
+
+    for (size_t row = 0; row < metric_count; row++)
+    {
+        const MetricDesc &desc = metric_registry[row];
+        lv_obj_t *widget = metric_widgets[row];
+        if (!widget)
+            continue;
+
+        if (desc.widget == WIDGET_ARC)
         {
-            lv_obj_set_style_border_color(label, theme.border_color, 0);
-            lv_obj_set_style_bg_color(label, theme.card_bg_color, 0);
-            lv_obj_t *icon_label = lv_obj_get_child(label, 0);
-            if (icon_label)
-            {
-                lv_obj_set_style_text_color(icon_label, theme.text_color, 0);
-            }
-            lv_obj_t *text_label = (lv_obj_t *)lv_obj_get_user_data(label);
-            if (text_label)
-            {
-                if (!strstr(lv_label_get_text(text_label), "°C"))
-                {
-                    lv_obj_set_style_text_color(text_label, theme.text_color, 0);
-                }
-            }
+            lv_color_t color = theme.*desc.color;
+            lv_obj_set_style_arc_color(widget, color, LV_PART_INDICATOR);
+            lv_obj_set_style_arc_color(widget, lv_color_darken(color, LV_OPA_30), LV_PART_MAIN);
+            lv_obj_t **labels = (lv_obj_t **)lv_obj_get_user_data(widget);
+            lv_obj_set_style_text_color(labels[0], theme.text_color, 0);
+            lv_obj_set_style_text_color(labels[1], theme.text_color, 0);
+            lv_obj_set_style_text_color(labels[2], lv_color_hex(0x808080), 0);
+            continue;
         }
+
+        lv_obj_set_style_border_color(widget, theme.border_color, 0);
+        lv_obj_set_style_bg_color(widget, theme.card_bg_color, 0);
+        lv_obj_t *text_label = (lv_obj_t *)lv_obj_get_user_data(widget);
+        if (desc.title)
+            lv_obj_set_style_text_color(lv_obj_get_child(widget, 0), theme.text_color, 0);
+        // A value colored by its level keeps that color
+        if (shown_level[row] < 0)
+            lv_obj_set_style_text_color(text_label, theme.text_color, 0);
     }
 }
 
 void create_system_monitor_gui()
 {
-    Serial.println("Creating system monitor GUI...");
+    LOG_I(LOG_MOD_SYSTEM, "Creating system monitor GUI");
     
     const ThemeColors *theme = DARK_MODE ? &dark_theme : &light_theme;
-    lv_obj_set_style_bg_color(lv_scr_act(), theme->bg_color, 0);
+    overview_screen = lv_scr_act();
+    lv_obj_set_style_bg_color(overview_screen, theme->bg_color, 0);
 
     lv_obj_t *main_cont = lv_obj_create(lv_scr_act());
     if (!main_cont) {
-        Serial.println("Failed to create main container");
+        LOG_E(LOG_MOD_SYSTEM, "Failed to create main container");
         return;
     }
 
@@ -332,13 +982,13 @@ void create_system_monitor_gui()
 
     lv_obj_t *left_col = lv_obj_create(main_cont);
     if (!left_col) {
-        Serial.println("Failed to create left column");
+        LOG_E(LOG_MOD_SYSTEM, "Failed to create left column");
         return;
     }
 
     lv_obj_t *right_col = lv_obj_create(main_cont);
     if (!right_col) {
-        Serial.println("Failed to create right column");
+        LOG_E(LOG_MOD_SYSTEM, "Failed to create right column");
         return;
     }
 
@@ -356,58 +1006,37 @@ void create_system_monitor_gui()
     lv_obj_set_flex_flow(right_col, LV_FLEX_FLOW_COLUMN);
     lv_obj_set_flex_align(right_col, LV_FLEX_ALIGN_SPACE_EVENLY, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
 
-    Serial.println("Creating CPU arc...");
-    cpu_arc_obj = create_arc(left_col, "CPU", theme->cpu_color);
-    if (!cpu_arc_obj.arc || !cpu_arc_obj.label) {
-        Serial.println("Failed to create CPU arc");
-        return;
-    }
-
-    Serial.println("Creating RAM arc...");
-    ram_arc_obj = create_arc(right_col, "RAM", theme->ram_color);
-    if (!ram_arc_obj.arc || !ram_arc_obj.label) {
-        Serial.println("Failed to create RAM arc");
-        return;
-    }
-
-    temp_label = create_compact_label(left_col, LV_SYMBOL_WARNING " Temp: -- °C", theme);
-    if (!temp_label) {
-        Serial.println("Failed to create temp label");
-        return;
-    }
-
-    load_label = create_compact_label(left_col, LV_SYMBOL_CHARGE " Load: -.-", theme);
-    if (!load_label) {
-        Serial.println("Failed to create load label");
-        return;
-    }
-
-    uptime_label = create_compact_label(left_col, LV_SYMBOL_POWER "  ---", theme);
-    if (!uptime_label) {
-        Serial.println("Failed to create uptime label");
-        return;
-    }
-
-    disk_label = create_compact_label(right_col, LV_SYMBOL_DRIVE " Array: ---%", theme);
-    if (!disk_label) {
-        Serial.println("Failed to create disk label");
-        return;
-    }
-
-    cache_label = create_compact_label(right_col, LV_SYMBOL_SAVE " Cache: ---%", theme);
-    if (!cache_label) {
-        Serial.println("Failed to create cache label");
-        return;
-    }
-
-    network_label = create_compact_label(right_col, LV_SYMBOL_DOWNLOAD " --- " LV_SYMBOL_UPLOAD " ---", theme);
-    if (!network_label) {
-        Serial.println("Failed to create network label");
-        return;
+    // One widget per registry row, in table order within each column.
+    // Tapping a widget opens its detail page; swiping pages through all.
+    memset(shown_level, -1, sizeof(shown_level));
+    for (size_t row = 0; row < metric_count; row++)
+    {
+        const MetricDesc &desc = metric_registry[row];
+        lv_obj_t *column = desc.column == COLUMN_LEFT ? left_col : right_col;
+        if (desc.widget == WIDGET_ARC)
+        {
+            ArcWithLabel arc = create_arc(column, desc.title, theme->*desc.color);
+            if (!arc.arc || !arc.label) {
+                LOG_E(LOG_MOD_SYSTEM, "Failed to create %s arc", desc.title);
+                return;
+            }
+            metric_widgets[row] = arc.arc;
+            make_page_link(arc.label, desc.page);
+        }
+        else if (desc.widget == WIDGET_CARD)
+        {
+            metric_widgets[row] = create_metric_card(column, desc, theme);
+            if (!metric_widgets[row]) {
+                LOG_E(LOG_MOD_SYSTEM, "Failed to create card for row %u", (unsigned)row);
+                return;
+            }
+            make_page_link(metric_widgets[row], desc.page);
+        }
     }
+    lv_obj_add_event_cb(overview_screen, gesture_cb, LV_EVENT_GESTURE, NULL);
 
     SettingsManager::setThemeChangeCallback(applyTheme);
     applyTheme(SettingsManager::getDarkMode());
     
-    Serial.println("GUI creation completed successfully!");
+    LOG_I(LOG_MOD_SYSTEM, "GUI created");
 }
\ No newline at end of file
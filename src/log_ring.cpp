@@ -0,0 +1,423 @@
+#include "log_ring.h"
+#include <Arduino.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+struct LogSlot
+{
+    uint32_t seq; // 0 while being written
+    uint32_t ms;
+    const char *format;
+    LogLevel level;
+    LogModule module;
+    uint8_t argBytes;
+    bool truncated; // arguments after argBytes did not fit
+    uint8_t args[LOG_ARG_BYTES];
+};
+
+enum ArgKind : uint8_t
+{
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_DOUBLE,
+    ARG_STRING,
+    ARG_POINTER,
+    ARG_UNKNOWN
+};
+
+static const char *const level_names[LOG_LEVEL_COUNT] = {"error", "warn", "info", "debug"};
+static const char *const module_names[LOG_MOD_COUNT] = {"system", "wifi", "glances", "web", "mqtt", "alert"};
+
+static LogSlot slots[LOG_RING_SLOTS];
+static uint32_t head_seq = 0;
+static LogLevel levels[LOG_MOD_COUNT] = {LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO,
+                                         LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO};
+static uint32_t drain_seq = 1;
+static uint32_t drain_dropped = 0;
+
+// Finds the next conversion from p on. Returns its conversion character and
+// sets spec to the '%' that starts it, or returns NULL when there is none.
+static const char *findSpec(const char *p, const char *&spec)
+{
+    for (; *p; p++)
+    {
+        if (*p != '%')
+            continue;
+        if (p[1] == '%')
+        {
+            p++;
+            continue;
+        }
+        spec = p++;
+        while (*p && strchr("-+ #0123456789.hlzjt", *p))
+            p++;
+        return *p ? p : NULL;
+    }
+    return NULL;
+}
+
+static ArgKind argKind(const char *spec, const char *conv)
+{
+    int longs = 0;
+    for (const char *c = spec; c < conv; c++)
+    {
+        if (*c == 'l' || *c == 'z' || *c == 't')
+            longs++;
+        else if (*c == 'j')
+            longs += 2;
+    }
+    switch (*conv)
+    {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    case 'c':
+        return longs >= 2 ? ARG_LLONG : longs ? ARG_LONG : ARG_INT;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+        return ARG_DOUBLE;
+    case 's':
+        return ARG_STRING;
+    case 'p':
+        return ARG_POINTER;
+    default:
+        return ARG_UNKNOWN;
+    }
+}
+
+template <typename T>
+static bool putArg(LogSlot &slot, T value)
+{
+    if (slot.argBytes + sizeof(T) > LOG_ARG_BYTES)
+        return false;
+    memcpy(slot.args + slot.argBytes, &value, sizeof(T));
+    slot.argBytes += sizeof(T);
+    return true;
+}
+
+template <typename T>
+static bool getArg(const LogSlot &slot, size_t &used, T &value)
+{
+    if (used + sizeof(T) > slot.argBytes)
+        return false;
+    memcpy(&value, slot.args + used, sizeof(T));
+    used += sizeof(T);
+    return true;
+}
+
+static bool captureArg(LogSlot &slot, ArgKind kind, va_list &args)
+{
+    switch (kind)
+    {
+    case ARG_INT:
+        return putArg(slot, va_arg(args, int));
+    case ARG_LONG:
+        return putArg(slot, va_arg(args, long));
+    case ARG_LLONG:
+        return putArg(slot, va_arg(args, long long));
+    case ARG_DOUBLE:
+        return putArg(slot, va_arg(args, double));
+    case ARG_POINTER:
+        return putArg(slot, va_arg(args, void *));
+    case ARG_STRING:
+    {
+        const char *s = va_arg(args, const char *);
+        if (!s)
+            s = "(null)";
+        size_t room = LOG_ARG_BYTES - slot.argBytes;
+        if (room == 0)
+            return false;
+        size_t len = strnlen(s, room - 1);
+        memcpy(slot.args + slot.argBytes, s, len);
+        slot.args[slot.argBytes + len] = '\0';
+        slot.argBytes += len + 1;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool LogRing::enabled(LogLevel level, LogModule module)
+{
+    return module < LOG_MOD_COUNT && level <= levels[module];
+}
+
+void LogRing::write(LogLevel level, LogModule module, const char *format, ...)
+{
+    uint32_t seq = __atomic_add_fetch(&head_seq, 1, __ATOMIC_RELAXED);
+    LogSlot &slot = slots[seq % LOG_RING_SLOTS];
+
+    // Readers that copy the slot from here on see the sequence change
+    __atomic_store_n(&slot.seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot.ms = millis();
+    slot.format = format;
+    slot.level = level;
+    slot.module = module;
+    slot.argBytes = 0;
+    slot.truncated = false;
+
+    va_list args;
+    va_start(args, format);
+    const char *spec;
+    const char *conv = format;
+    while ((conv = findSpec(conv, spec)) != NULL)
+    {
+        if (!captureArg(slot, argKind(spec, conv), args))
+        {
+            slot.truncated = true;
+            break;
+        }
+        conv++;
+    }
+    va_end(args);
+
+    __atomic_store_n(&slot.seq, seq, __ATOMIC_RELEASE);
+}
+
+static void appendLiteral(char *out, size_t size, size_t &len, const char *p, const char *stop)
+{
+    while (p < stop && len + 1 < size)
+    {
+        if (*p == '%' && p + 1 < stop && p[1] == '%')
+            p++;
+        out[len++] = *p++;
+    }
+}
+
+static void appendArg(size_t size, size_t &len, int n)
+{
+    if (n > 0)
+        len += (size_t)n < size - len ? (size_t)n : size - len - 1;
+}
+
+static void formatSlot(const LogSlot &slot, char *out, size_t size)
+{
+    size_t len = 0;
+    size_t used = 0;
+    const char *p = slot.format;
+    const char *spec;
+    const char *conv;
+    bool complete = true;
+
+    while ((conv = findSpec(p, spec)) != NULL)
+    {
+        appendLiteral(out, size, len, p, spec);
+        char piece[16];
+        if (conv - spec + 2 > (int)sizeof(piece))
+        {
+            complete = false;
+            break;
+        }
+        memcpy(piece, spec, conv - spec + 1);
+        piece[conv - spec + 1] = '\0';
+
+        bool ok = false;
+        switch (argKind(spec, conv))
+        {
+        case ARG_INT:
+        {
+            int v;
+            if ((ok = getArg(slot, used, v)))
+                appendArg(size, len, snprintf(out + len, size - len, piece, v));
+            break;
+        }
+        case ARG_LONG:
+        {
+            long v;
+            if ((ok = getArg(slot, used, v)))
+                appendArg(size, len, snprintf(out + len, size - len, piece, v));
+            break;
+        }
+        case ARG_LLONG:
+        {
+            long long v;
+            if ((ok = getArg(slot, used, v)))
+                appendArg(size, len, snprintf(out + len, size - len, piece, v));
+            break;
+        }
+        case ARG_DOUBLE:
+        {
+            double v;
+            if ((ok = getArg(slot, used, v)))
+                appendArg(size, len, snprintf(out + len, size - len, piece, v));
+            break;
+        }
+        case ARG_POINTER:
+        {
+            void *v;
+            if ((ok = getArg(slot, used, v)))
+                appendArg(size, len, snprintf(out + len, size - len, piece, v));
+            break;
+        }
+        case ARG_STRING:
+            if ((ok = used < slot.argBytes))
+            {
+                const char *s = (const char *)slot.args + used;
+                used += strlen(s) + 1;
+                appendArg(size, len, snprintf(out + len, size - len, piece, s));
+            }
+            break;
+        default:
+            break;
+        }
+        if (!ok)
+        {
+            complete = false;
+            break;
+        }
+        p = conv + 1;
+    }
+
+    if (complete && !slot.truncated)
+        appendLiteral(out, size, len, p, p + strlen(p));
+    else
+    {
+        static const char more[] = "...";
+        appendLiteral(out, size, len, more, more + 3);
+    }
+
+    // Formats written for Serial.printf end in a newline
+    while (len > 0 && (out[len - 1] == '\n' || out[len - 1] == '\r'))
+        len--;
+    out[len] = '\0';
+}
+
+uint32_t LogRing::head()
+{
+    return __atomic_load_n(&head_seq, __ATOMIC_ACQUIRE);
+}
+
+uint32_t LogRing::oldest()
+{
+    uint32_t newest = head();
+    return newest > LOG_RING_SLOTS ? newest - LOG_RING_SLOTS + 1 : 1;
+}
+
+bool LogRing::read(uint32_t seq, LogEntry &entry, char *text, size_t textSize)
+{
+    const LogSlot &slot = slots[seq % LOG_RING_SLOTS];
+    if (seq == 0 || __atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE) != seq)
+        return false;
+
+    LogSlot copy;
+    memcpy(&copy, &slot, sizeof(copy));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot.seq, __ATOMIC_RELAXED) != seq)
+        return false;
+
+    entry.seq = seq;
+    entry.ms = copy.ms;
+    entry.level = copy.level;
+    entry.module = copy.module;
+    if (textSize)
+        formatSlot(copy, text, textSize);
+    return true;
+}
+
+void LogRing::drain()
+{
+    for (int i = 0; i < LOG_DRAIN_PER_LOOP; i++)
+    {
+        if (drain_seq > head())
+            return;
+        uint32_t first = oldest();
+        if (drain_seq < first)
+        {
+            drain_dropped += first - drain_seq;
+            drain_seq = first;
+        }
+
+        LogEntry entry;
+        char text[LOG_LINE_LENGTH];
+        if (!read(drain_seq, entry, text, sizeof(text)))
+        {
+            // Still being written; an overwritten entry is skipped next time
+            if (drain_seq >= oldest())
+                return;
+            continue;
+        }
+
+        char line[LOG_LINE_LENGTH + 32];
+        int len = snprintf(line, sizeof(line), "%lu.%03lu %c %s: %s\n", (unsigned long)(entry.ms / 1000),
+                           (unsigned long)(entry.ms % 1000), "EWID"[entry.level],
+                           module_names[entry.module], text);
+        if (len < 0)
+            return;
+        if ((size_t)len >= sizeof(line))
+            len = sizeof(line) - 1;
+        if (Serial.availableForWrite() < len)
+            return;
+        Serial.write((const uint8_t *)line, len);
+        drain_seq++;
+    }
+}
+
+uint32_t LogRing::dropped()
+{
+    return drain_dropped;
+}
+
+LogLevel LogRing::level(LogModule module)
+{
+    return module < LOG_MOD_COUNT ? levels[module] : LOG_LEVEL_ERROR;
+}
+
+void LogRing::setLevel(LogModule module, LogLevel level)
+{
+    if (module < LOG_MOD_COUNT && level < LOG_LEVEL_COUNT)
+        levels[module] = level;
+}
+
+void LogRing::setAllLevels(LogLevel level)
+{
+    for (int m = 0; m < LOG_MOD_COUNT; m++)
+        setLevel((LogModule)m, level);
+}
+
+const char *LogRing::levelName(LogLevel level)
+{
+    return level < LOG_LEVEL_COUNT ? level_names[level] : "";
+}
+
+const char *LogRing::moduleName(LogModule module)
+{
+    return module < LOG_MOD_COUNT ? module_names[module] : "";
+}
+
+bool LogRing::parseLevel(const char *name, LogLevel &level)
+{
+    for (int l = 0; l < LOG_LEVEL_COUNT; l++)
+    {
+        if (strcmp(name, level_names[l]) == 0)
+        {
+            level = (LogLevel)l;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LogRing::parseModule(const char *name, LogModule &module)
+{
+    for (int m = 0; m < LOG_MOD_COUNT; m++)
+    {
+        if (strcmp(name, module_names[m]) == 0)
+        {
+            module = (LogModule)m;
+            return true;
+        }
+    }
+    return false;
+}
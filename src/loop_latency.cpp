@@ -0,0 +1,200 @@
+#include "loop_latency.h"
+#include "esp_idf_version.h"
+#include "esp_system.h"
+#include "esp_task_wdt.h"
+#include <string.h>
+
+// A stage running longer than this is recorded as a stall. LVGL should stay
+// well under a frame; a Glances cycle is a handful of LAN requests.
+static const uint32_t stage_budget_ms[STAGE_COUNT] = {50, 3000, 200, 200, 50};
+
+static LatencyHistogram iteration_hist;
+static LatencyHistogram stage_hist[STAGE_COUNT];
+static uint32_t stage_overruns[STAGE_COUNT];
+static LoopStall stalls[LOOP_STALL_HISTORY];
+static size_t stall_head = 0;
+static size_t stall_count = 0;
+
+static uint32_t iteration_start_us = 0;
+static uint32_t iteration_staged_us = 0;
+static bool watchdog_on = false;
+
+// Values below 4 µs have a bucket each; above that every power of two is
+// split into four
+static size_t bucketOf(uint32_t us)
+{
+    if (us < 4)
+        return us;
+    int msb = 31 - __builtin_clz(us);
+    size_t index = (msb - 1) * 4 + ((us >> (msb - 2)) & 3);
+    return index < LOOP_LATENCY_BUCKETS ? index : LOOP_LATENCY_BUCKETS - 1;
+}
+
+static uint32_t bucketLimitUs(size_t index)
+{
+    if (index < 4)
+        return index;
+    int msb = index / 4 + 1;
+    uint64_t lower = (uint64_t)(4 + index % 4) << (msb - 2);
+    uint64_t limit = lower + ((uint64_t)1 << (msb - 2)) - 1;
+    return limit > UINT32_MAX ? UINT32_MAX : (uint32_t)limit;
+}
+
+static void addSample(LatencyHistogram &histogram, uint32_t us)
+{
+    histogram.count++;
+    histogram.sumUs += us;
+    histogram.lastUs = us;
+    if (us > histogram.maxUs)
+        histogram.maxUs = us;
+    histogram.buckets[bucketOf(us)]++;
+}
+
+static void checkBudget(LoopStage stage, uint32_t us)
+{
+    if (us <= stage_budget_ms[stage] * 1000)
+        return;
+    stage_overruns[stage]++;
+    stall_head = (stall_head + LOOP_STALL_HISTORY - 1) % LOOP_STALL_HISTORY;
+    stalls[stall_head] = {millis(), us, stage};
+    if (stall_count < LOOP_STALL_HISTORY)
+        stall_count++;
+}
+
+void LoopLatency::beginWatchdog()
+{
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_task_wdt_config_t config = {LOOP_WDT_TIMEOUT_S * 1000, 1 << 0, true};
+    esp_task_wdt_reconfigure(&config);
+#else
+    // Already running for the idle tasks; this only changes timeout and panic
+    esp_task_wdt_init(LOOP_WDT_TIMEOUT_S, true);
+#endif
+    watchdog_on = esp_task_wdt_add(NULL) == ESP_OK;
+}
+
+bool LoopLatency::watchdogActive()
+{
+    return watchdog_on;
+}
+
+void LoopLatency::feed()
+{
+    if (watchdog_on)
+        esp_task_wdt_reset();
+}
+
+void LoopLatency::beginIteration()
+{
+    iteration_start_us = micros();
+    iteration_staged_us = 0;
+}
+
+void LoopLatency::endIteration()
+{
+    uint32_t total = micros() - iteration_start_us;
+    addSample(iteration_hist, total);
+
+    uint32_t other = total > iteration_staged_us ? total - iteration_staged_us : 0;
+    DeviceStats::addStageTime(STAGE_OTHER, other);
+    addSample(stage_hist[STAGE_OTHER], other);
+    checkBudget(STAGE_OTHER, other);
+    feed();
+}
+
+void LoopLatency::addStage(LoopStage stage, uint32_t us)
+{
+    if (stage >= STAGE_OTHER)
+        return;
+    DeviceStats::addStageTime(stage, us);
+    iteration_staged_us += us;
+    addSample(stage_hist[stage], us);
+    checkBudget(stage, us);
+    feed();
+}
+
+const LatencyHistogram &LoopLatency::iteration()
+{
+    return iteration_hist;
+}
+
+const LatencyHistogram &LoopLatency::stage(LoopStage stage)
+{
+    return stage_hist[stage < STAGE_COUNT ? stage : STAGE_OTHER];
+}
+
+uint32_t LoopLatency::quantileUs(const LatencyHistogram &histogram, float q)
+{
+    if (histogram.count == 0)
+        return 0;
+    uint64_t rank = (uint64_t)(q * histogram.count + 0.5f);
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < LOOP_LATENCY_BUCKETS; b++)
+    {
+        seen += histogram.buckets[b];
+        if (seen >= rank)
+        {
+            uint32_t limit = bucketLimitUs(b);
+            return limit < histogram.maxUs ? limit : histogram.maxUs;
+        }
+    }
+    return histogram.maxUs;
+}
+
+uint32_t LoopLatency::budgetUs(LoopStage stage)
+{
+    return stage < STAGE_COUNT ? stage_budget_ms[stage] * 1000 : 0;
+}
+
+uint32_t LoopLatency::overruns(LoopStage stage)
+{
+    return stage < STAGE_COUNT ? stage_overruns[stage] : 0;
+}
+
+size_t LoopLatency::stallCount()
+{
+    return stall_count;
+}
+
+const LoopStall &LoopLatency::stall(size_t index)
+{
+    return stalls[(stall_head + (index < stall_count ? index : 0)) % LOOP_STALL_HISTORY];
+}
+
+const char *LoopLatency::resetReason()
+{
+    switch (esp_reset_reason())
+    {
+    case ESP_RST_POWERON:
+        return "power_on";
+    case ESP_RST_EXT:
+        return "external";
+    case ESP_RST_SW:
+        return "software";
+    case ESP_RST_PANIC:
+        return "panic";
+    case ESP_RST_INT_WDT:
+        return "int_wdt";
+    case ESP_RST_TASK_WDT:
+        return "task_wdt";
+    case ESP_RST_WDT:
+        return "wdt";
+    case ESP_RST_DEEPSLEEP:
+        return "deep_sleep";
+    case ESP_RST_BROWNOUT:
+        return "brownout";
+    default:
+        return "unknown";
+    }
+}
+
+void LoopLatency::reset()
+{
+    memset(&iteration_hist, 0, sizeof(iteration_hist));
+    memset(stage_hist, 0, sizeof(stage_hist));
+    memset(stage_overruns, 0, sizeof(stage_overruns));
+    stall_head = 0;
+    stall_count = 0;
+}
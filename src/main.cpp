@@ -3,60 +3,110 @@
 #include "lvgl.h"
 #include "config.h"
 #include "display.h"
+#include "touch.h"
 #include "gui.h"
 #include "glances_api.h"
 #include "settings_manager.h"
 #include "web_server.h"
+#include "mqtt_publisher.h"
+#include "device_stats.h"
+#include "loop_latency.h"
+#include "fs_classifier.h"
+#include "net_meter.h"
+#include "sensor_map.h"
+#include "alert_engine.h"
+#include "alert_notifier.h"
+#include "metrics_history.h"
+#include "boot_profile.h"
+#include "wifi_manager.h"
+#include "log_ring.h"
 #include "credentials.h"
 #include "SPIFFS.h"
 
-void setup()
+static volatile bool storage_ready = false;
+static volatile bool storage_ok = false;
+
+// Mounting SPIFFS can take seconds, much longer when it has to format, so it
+// runs beside the display and WiFi bring-up
+static void storageTask(void *)
 {
-    Serial.begin(115200);
-    delay(2000);
-
-    Serial.println("\n\n======================");
-    Serial.println("Starting System Monitor");
-    Serial.println("======================");
-    Serial.println("Step 1: Serial Test");
-    delay(100);
-    Serial.println("Step 2: Setting hostname");
-    WiFi.hostname("systemmonitor");
-    delay(100);
-    Serial.print("Step 3: SSID to connect: ");
-    Serial.println(WIFI_SSID);
-    delay(100);
-    Serial.println("Step 4: Starting WiFi connection");
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20)
+    storage_ok = SPIFFS.begin(true);
+    if (!storage_ok)
+        LOG_E(LOG_MOD_SYSTEM, "SPIFFS mount failed");
+    BootProfile::mark(BOOT_STORAGE);
+    storage_ready = true;
+    vTaskDelete(NULL);
+}
+
+// Finishes the parts of the boot that wait on storage, and keeps the status
+// line current until the first Glances data arrives. After that the status
+// line only reports a lost WiFi link.
+static void serviceBoot()
+{
+    static bool done = false;
+    static bool link_down = false;
+    static uint32_t status_ms = 0;
+    if (done)
     {
-        delay(500);
-        Serial.print(".");
-        attempts++;
-        Serial.printf(" (Status: %d)", WiFi.status());
+        if (WifiManager::connected() == link_down)
+        {
+            link_down = !link_down;
+            char status[64];
+            snprintf(status, sizeof(status), LV_SYMBOL_WIFI " Reconnecting to %s...", WIFI_SSID);
+            gui_set_status(link_down ? status : NULL);
+        }
+        return;
+    }
+
+    if (storage_ready && !BootProfile::reached(BOOT_WEB))
+    {
+        if (storage_ok)
+            setupWebServer();
+        // Without SPIFFS there is no web UI, as before
+        BootProfile::mark(BOOT_WEB);
     }
 
-    Serial.println("\nStep 5: WiFi connection result:");
-    if (WiFi.status() == WL_CONNECTED)
+    if (millis() - status_ms >= 500)
     {
-        Serial.println("  - Connected successfully!");
-        Serial.print("  - Hostname: ");
-        Serial.println(WiFi.getHostname());
-        Serial.print("  - IP Address: ");
-        Serial.println(WiFi.localIP());
+        status_ms = millis();
+        char status[64];
+        if (!WifiManager::connected())
+            snprintf(status, sizeof(status), LV_SYMBOL_WIFI " Connecting to %s...", WIFI_SSID);
+        else if (glances_host.length() == 0)
+            snprintf(status, sizeof(status), LV_SYMBOL_SETTINGS " Set the Glances host at %s",
+                     WiFi.localIP().toString().c_str());
+        else
+            snprintf(status, sizeof(status), LV_SYMBOL_REFRESH " Waiting for Glances at %s", glances_host.c_str());
+        gui_set_status(status);
     }
-    else
+
+    if (BootProfile::reached(BOOT_FIRST_DATA) && BootProfile::reached(BOOT_WEB))
     {
-        Serial.println("  - Connection FAILED!");
-        Serial.print("  - Status code: ");
-        Serial.println(WiFi.status());
+        gui_set_status(NULL);
+        BootProfile::print();
+        done = true;
     }
+}
 
-    Serial.println("Step 6: Initializing display");
+// Paints the overview first and leaves WiFi and SPIFFS to come up in the
+// background; loop() finishes the boot through serviceBoot()
+void setup()
+{
+    // Room for the log drain, which only writes what fits without waiting
+    Serial.setTxBufferSize(LOG_SERIAL_BUFFER);
+    Serial.begin(115200);
+    DeviceStats::begin();
+
+    LOG_I(LOG_MOD_SYSTEM, "Starting System Monitor");
+
+    // LVGL's pool is taken here, before WiFi and SPIFFS start allocating
     lv_init();
+
+    WifiManager::begin();
+    xTaskCreatePinnedToCore(storageTask, "storage", 6144, NULL, 1, NULL, 0);
+
     init_display();
+    BootProfile::mark(BOOT_DISPLAY);
 
 #if LV_USE_LOG != 0
     lv_log_register_print_cb([](const char *buf)
@@ -66,31 +116,100 @@ void setup()
 #endif
 
     create_system_monitor_gui();
+    char status[64];
+    snprintf(status, sizeof(status), LV_SYMBOL_WIFI " Connecting to %s...", WIFI_SSID);
+    gui_set_status(status);
+    lv_refr_now(NULL);
+    BootProfile::mark(BOOT_FIRST_PAINT);
+
+    init_touch();
     SettingsManager::begin();
-    if (!SPIFFS.begin(true))
+    touch_set_calibration(SettingsManager::getTouchCalibration());
+    MqttPublisher::begin();
+
+    char ruleError[64];
+    if (!FsClassifier::compile(SettingsManager::getFsRules(), ruleError, sizeof(ruleError)))
     {
-        Serial.println("SPIFFS Mount Failed");
-        return;
+        LOG_W(LOG_MOD_SYSTEM, "Ignoring saved filesystem rules: %s", ruleError);
+        FsClassifier::compile(FsClassifier::defaultRules(), ruleError, sizeof(ruleError));
+    }
+    if (!NetMeter::compile(SettingsManager::getNetInterfaces(), (NetMode)SettingsManager::getNetMode(),
+                           ruleError, sizeof(ruleError)))
+    {
+        LOG_W(LOG_MOD_SYSTEM, "Ignoring saved network interfaces: %s", ruleError);
+        NetMeter::compile(NetMeter::defaultPatterns(), NET_MODE_FIRST, ruleError, sizeof(ruleError));
     }
+    if (!SensorMap::compile(SettingsManager::getSensorMap(), ruleError, sizeof(ruleError)))
+    {
+        LOG_W(LOG_MOD_SYSTEM, "Ignoring saved sensor map: %s", ruleError);
+        SensorMap::compile(SensorMap::defaultMap(), ruleError, sizeof(ruleError));
+    }
+    if (!AlertEngine::compile(SettingsManager::getAlertRules(), ruleError, sizeof(ruleError)))
+    {
+        LOG_W(LOG_MOD_SYSTEM, "Ignoring saved alert rules: %s", ruleError);
+        AlertEngine::compile(AlertEngine::defaultRules(), ruleError, sizeof(ruleError));
+    }
+    MetricsHistory::setObserver(AlertEngine::observe);
+    BootProfile::mark(BOOT_SETTINGS);
 
-    setupWebServer();
+    // From here on a loop stage that hangs restarts the device
+    LoopLatency::beginWatchdog();
+    LOG_I(LOG_MOD_SYSTEM, "Last reset: %s", LoopLatency::resetReason());
 
-    Serial.println("======================");
-    Serial.println("Setup complete!");
-    Serial.println("======================");
+    LOG_I(LOG_MOD_SYSTEM, "Setup complete");
 }
 
 void loop()
 {
+    LoopLatency::beginIteration();
+    uint32_t idle_ms;
+
     // Handle LVGL tasks - this should be called frequently
-    lv_timer_handler();
-    
+    {
+        StageTimer timer(STAGE_LVGL);
+        touch_service();
+        idle_ms = lv_timer_handler();
+    }
+
+    WifiManager::service();
+    serviceBoot();
+
     // Update Glances data at regular intervals
-    updateGlancesData();
-    
+    {
+        StageTimer timer(STAGE_GLANCES);
+        updateGlancesData();
+    }
+
     // Handle web server requests
-    handleWebServer();
-    
-    // Add a short delay to prevent watchdog issues
-    delay(5);
+    if (BootProfile::reached(BOOT_WEB))
+    {
+        StageTimer timer(STAGE_WEB);
+        handleWebServer();
+    }
+
+    // Sample device health into the on-device history
+    updateDeviceHistory();
+
+    // Banners, flashes and notifications for alerts raised by new samples
+    handleAlerts();
+
+    // Keep the MQTT session alive and publish changed metrics
+    {
+        StageTimer timer(STAGE_MQTT);
+        MqttPublisher::loop();
+    }
+
+    DeviceStats::update();
+
+    // Print buffered log entries
+    LogRing::drain();
+
+    LoopLatency::endIteration();
+
+    // The watchdog is fed by the loop itself; this only leaves the core idle
+    // until LVGL's next timer, and not at all while it is animating
+    if (idle_ms > LOOP_IDLE_MAX_MS)
+        idle_ms = LOOP_IDLE_MAX_MS;
+    if (idle_ms)
+        delay(idle_ms);
 }
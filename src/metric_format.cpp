@@ -0,0 +1,267 @@
+#include "metric_format.h"
+#include <math.h>
+#include <string.h>
+
+#define FORMAT_MAX_UNIT 5
+#define FORMAT_MAX_DECIMALS 3
+
+static const char iec_units[] = "BKMGTP";
+static const char si_units[] = "BkMGTP";
+static const uint32_t pow10s[FORMAT_MAX_DECIMALS + 1] = {1, 10, 100, 1000};
+
+// Appends to a caller's buffer, dropping what does not fit
+struct Writer
+{
+    char *buf;
+    size_t size;
+    size_t len;
+    bool cut;
+
+    void put(char c)
+    {
+        if (len + 1 < size)
+            buf[len++] = c;
+        else
+            cut = true;
+    }
+
+    void puts(const char *s)
+    {
+        while (*s)
+            put(*s++);
+    }
+
+    void putUint(uint64_t value, uint8_t minDigits = 1)
+    {
+        char digits[20];
+        int n = 0;
+        // 64-bit division is a library call on the ESP32, and nearly every
+        // value fits in 32 bits
+        while (value > UINT32_MAX)
+        {
+            digits[n++] = '0' + value % 10;
+            value /= 10;
+        }
+        uint32_t rest = (uint32_t)value;
+        do
+        {
+            digits[n++] = '0' + rest % 10;
+            rest /= 10;
+        } while (rest || n < minDigits);
+        while (n)
+            put(digits[--n]);
+    }
+
+    // scaled holds the value times 10^decimals
+    void putFixed(uint64_t scaled, uint8_t decimals)
+    {
+        putUint(scaled / pow10s[decimals]);
+        if (decimals == 0)
+            return;
+        put('.');
+        putUint(scaled % pow10s[decimals], decimals);
+    }
+
+    size_t finish()
+    {
+        if (size)
+            buf[len] = '\0';
+        return len;
+    }
+
+    // A number cut short reads as a different number, so one that does not
+    // fit prints "--" instead
+    size_t finishValue()
+    {
+        if (cut)
+        {
+            len = 0;
+            puts("--");
+        }
+        return finish();
+    }
+};
+
+static size_t notAvailable(char *buf, size_t size)
+{
+    Writer out = {buf, size, 0, false};
+    out.puts("--");
+    return out.finish();
+}
+
+// Rounded value times 10^decimals, saturating instead of overflowing
+static uint64_t scaleFloat(float value, uint8_t decimals)
+{
+    double scaled = fabs((double)value) * pow10s[decimals] + 0.5;
+    return scaled >= 1.8e19 ? UINT64_MAX : (uint64_t)scaled;
+}
+
+// value in hundredths of the given unit, rounded
+static uint64_t hundredths(uint64_t value, UnitBase base, uint8_t unit)
+{
+    uint64_t divisor = 1;
+    for (uint8_t u = 0; u < unit; u++)
+        divisor *= base == UNIT_SI ? 1000 : 1024;
+    uint64_t whole = value / divisor;
+    if (whole > UINT64_MAX / 100 - 100)
+        return UINT64_MAX;
+    return whole * 100 + ((value % divisor) * 100 + divisor / 2) / divisor;
+}
+
+size_t MetricFormat::bytes(char *buf, size_t size, uint64_t bytes, UnitBase base, UnitScale *scale)
+{
+    uint8_t unit = scale && scale->unit <= FORMAT_MAX_UNIT ? scale->unit : 0;
+    uint64_t h = hundredths(bytes, base, unit);
+    while (unit < FORMAT_MAX_UNIT && h >= FORMAT_SCALE_UP)
+        h = hundredths(bytes, base, ++unit);
+    if (scale)
+    {
+        while (unit > 0 && h < FORMAT_SCALE_DOWN)
+            h = hundredths(bytes, base, --unit);
+        scale->unit = unit;
+    }
+
+    Writer out = {buf, size, 0, false};
+    if (unit == 0)
+        out.putUint(bytes);
+    else if (h < 995)
+        out.putFixed(h, 2);
+    else if (h < 9995)
+        out.putFixed((h + 5) / 10, 1);
+    else
+        out.putFixed((h + 50) / 100, 0);
+    out.put((base == UNIT_SI ? si_units : iec_units)[unit]);
+    return out.finishValue();
+}
+
+size_t MetricFormat::rate(char *buf, size_t size, float bytesPerSec, UnitScale *scale)
+{
+    if (isnan(bytesPerSec))
+        return notAvailable(buf, size);
+    return bytes(buf, size, bytesPerSec > 0 ? scaleFloat(bytesPerSec, 0) : 0, UNIT_IEC, scale);
+}
+
+// Rounded to decimals, with no "-0.0" for values that round to zero
+static void putFloat(Writer &out, float value, uint8_t decimals)
+{
+    if (decimals > FORMAT_MAX_DECIMALS)
+        decimals = FORMAT_MAX_DECIMALS;
+    uint64_t scaled = scaleFloat(value, decimals);
+    if (value < 0 && scaled > 0)
+        out.put('-');
+    out.putFixed(scaled, decimals);
+}
+
+size_t MetricFormat::fixed(char *buf, size_t size, float value, uint8_t decimals)
+{
+    if (isnan(value))
+        return notAvailable(buf, size);
+    Writer out = {buf, size, 0, false};
+    putFloat(out, value, decimals);
+    return out.finishValue();
+}
+
+size_t MetricFormat::percent(char *buf, size_t size, float value, uint8_t decimals)
+{
+    if (isnan(value))
+        return notAvailable(buf, size);
+    Writer out = {buf, size, 0, false};
+    putFloat(out, value, decimals);
+    out.put('%');
+    return out.finishValue();
+}
+
+size_t MetricFormat::temperature(char *buf, size_t size, float celsius)
+{
+    if (isnan(celsius))
+        return notAvailable(buf, size);
+    Writer out = {buf, size, 0, false};
+    putFloat(out, celsius, 0);
+    out.puts("\xC2\xB0"
+             "C");
+    return out.finishValue();
+}
+
+size_t MetricFormat::duration(char *buf, size_t size, uint32_t seconds)
+{
+    Writer out = {buf, size, 0, false};
+    uint32_t days = seconds / 86400;
+    uint32_t rest = seconds % 86400;
+    if (days > 0)
+    {
+        out.putUint(days);
+        out.puts(days == 1 ? " day, " : " days, ");
+    }
+    out.putUint(rest / 3600);
+    out.put(':');
+    out.putUint(rest / 60 % 60, 2);
+    out.put(':');
+    out.putUint(rest % 60, 2);
+    return out.finishValue();
+}
+
+static int readUint(const char *&p, uint32_t &value)
+{
+    int digits = 0;
+    value = 0;
+    while (*p >= '0' && *p <= '9' && digits < 9)
+    {
+        value = value * 10 + (*p++ - '0');
+        digits++;
+    }
+    return digits;
+}
+
+static bool skip(const char *&p, const char *literal)
+{
+    size_t len = strlen(literal);
+    if (strncmp(p, literal, len) != 0)
+        return false;
+    p += len;
+    return true;
+}
+
+bool MetricFormat::parseDuration(const char *text, uint32_t &seconds)
+{
+    if (!text)
+        return false;
+    const char *p = text;
+    uint32_t days = 0, hours, minutes, secs;
+
+    const char *start = p;
+    if (readUint(p, days) && skip(p, " day"))
+    {
+        skip(p, "s");
+        if (!skip(p, ", "))
+            return false;
+    }
+    else
+    {
+        p = start;
+        days = 0;
+    }
+
+    if (!readUint(p, hours) || !skip(p, ":") || readUint(p, minutes) != 2 || !skip(p, ":") ||
+        readUint(p, secs) != 2 || *p != '\0' || minutes > 59 || secs > 59)
+        return false;
+    seconds = days * 86400 + hours * 3600 + minutes * 60 + secs;
+    return true;
+}
+
+size_t MetricFormat::text(char *buf, size_t size, const char *text)
+{
+    Writer out = {buf, size, 0, false};
+    out.puts(text ? text : "");
+    return out.finish();
+}
+
+size_t MetricFormat::padLeft(char *buf, size_t size, size_t width)
+{
+    size_t len = strlen(buf);
+    if (len >= width || width >= size)
+        return len;
+    size_t pad = width - len;
+    memmove(buf + pad, buf, len + 1);
+    memset(buf, ' ', pad);
+    return width;
+}
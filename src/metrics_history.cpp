@@ -0,0 +1,206 @@
+#include "metrics_history.h"
+#include <math.h>
+#include <string.h>
+
+MetricSeries MetricsHistory::series[METRIC_COUNT];
+MetricObserver MetricsHistory::observer = nullptr;
+
+static const char *const metric_names[METRIC_COUNT] = {
+    "host_cpu",
+    "host_mem",
+    "host_load",
+    "host_temp",
+    "host_net_rx",
+    "host_net_tx",
+    "device_cpu",
+    "device_heap",
+    "device_rssi",
+    "device_temp"};
+
+static void resetAccumulator(MetricSeries &s)
+{
+    s.accMin = INFINITY;
+    s.accMax = -INFINITY;
+    s.accSum = 0;
+    s.accCount = 0;
+}
+
+static void finalizeBucket(MetricSeries &s, HistoryBucket &bucket)
+{
+    if (s.accCount > 0)
+    {
+        bucket.min = s.accMin;
+        bucket.avg = s.accSum / s.accCount;
+        bucket.max = s.accMax;
+    }
+    else
+    {
+        bucket.min = bucket.avg = bucket.max = NAN;
+    }
+}
+
+static void startSeries(MetricSeries &s, uint32_t slot, uint32_t bucketSlot)
+{
+    for (int i = 0; i < HISTORY_HIRES_SAMPLES; i++)
+    {
+        s.hires[i] = NAN;
+    }
+    for (int i = 0; i < HISTORY_BUCKETS; i++)
+    {
+        s.buckets[i].min = s.buckets[i].avg = s.buckets[i].max = NAN;
+    }
+    s.hiresSlot = slot;
+    s.bucketSlot = bucketSlot;
+    resetAccumulator(s);
+    s.started = true;
+}
+
+void MetricsHistory::record(MetricId id, float value, uint64_t nowMs)
+{
+    if (id >= METRIC_COUNT || isnan(value))
+        return;
+    if (observer)
+        observer(id, value, nowMs);
+
+    MetricSeries &s = series[id];
+    uint32_t slot = nowMs / HISTORY_HIRES_STEP_MS;
+    uint32_t bucketSlot = nowMs / HISTORY_BUCKET_STEP_MS;
+
+    if (!s.started)
+    {
+        startSeries(s, slot, bucketSlot);
+    }
+
+    if (slot > s.hiresSlot)
+    {
+        uint32_t gap = slot - s.hiresSlot;
+        if (gap > HISTORY_HIRES_SAMPLES)
+            gap = HISTORY_HIRES_SAMPLES;
+        for (uint32_t i = 1; i < gap; i++)
+        {
+            s.hires[(slot - i) % HISTORY_HIRES_SAMPLES] = NAN;
+        }
+        s.hiresSlot = slot;
+    }
+    if (slot == s.hiresSlot)
+    {
+        s.hires[slot % HISTORY_HIRES_SAMPLES] = value;
+    }
+
+    if (bucketSlot > s.bucketSlot)
+    {
+        finalizeBucket(s, s.buckets[s.bucketSlot % HISTORY_BUCKETS]);
+        uint32_t gap = bucketSlot - s.bucketSlot;
+        if (gap > HISTORY_BUCKETS)
+            gap = HISTORY_BUCKETS;
+        for (uint32_t i = 1; i < gap; i++)
+        {
+            HistoryBucket &b = s.buckets[(bucketSlot - i) % HISTORY_BUCKETS];
+            b.min = b.avg = b.max = NAN;
+        }
+        s.bucketSlot = bucketSlot;
+        resetAccumulator(s);
+    }
+    if (bucketSlot == s.bucketSlot)
+    {
+        if (value < s.accMin)
+            s.accMin = value;
+        if (value > s.accMax)
+            s.accMax = value;
+        s.accSum += value;
+        s.accCount++;
+    }
+}
+
+// Works out the slot window [first, last] newer than sinceMs, bounded by what
+// the ring still holds and by the caller's buffer size.
+static size_t windowFor(uint32_t last, uint32_t capacity, uint32_t step, uint64_t sinceMs,
+                        size_t maxCount, uint32_t &first)
+{
+    uint32_t oldest = last >= capacity - 1 ? last - capacity + 1 : 0;
+    first = sinceMs ? (uint32_t)(sinceMs / step) + 1 : 0;
+    if (first < oldest)
+        first = oldest;
+    if (first > last)
+        return 0;
+    size_t count = last - first + 1;
+    if (count > maxCount)
+    {
+        first = last - maxCount + 1;
+        count = maxCount;
+    }
+    return count;
+}
+
+size_t MetricsHistory::copyHires(MetricId id, uint64_t sinceMs, uint64_t &startMs, float *out, size_t maxCount)
+{
+    startMs = 0;
+    if (id >= METRIC_COUNT || !series[id].started || maxCount == 0)
+        return 0;
+
+    const MetricSeries &s = series[id];
+    uint32_t first;
+    size_t count = windowFor(s.hiresSlot, HISTORY_HIRES_SAMPLES, HISTORY_HIRES_STEP_MS, sinceMs, maxCount, first);
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = s.hires[(first + i) % HISTORY_HIRES_SAMPLES];
+    }
+    startMs = (uint64_t)first * HISTORY_HIRES_STEP_MS;
+    return count;
+}
+
+size_t MetricsHistory::copyBuckets(MetricId id, uint64_t sinceMs, uint64_t &startMs, HistoryBucket *out, size_t maxCount)
+{
+    startMs = 0;
+    if (id >= METRIC_COUNT || !series[id].started || maxCount == 0)
+        return 0;
+
+    MetricSeries &s = series[id];
+    uint32_t first;
+    size_t count = windowFor(s.bucketSlot, HISTORY_BUCKETS, HISTORY_BUCKET_STEP_MS, sinceMs, maxCount, first);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t slot = first + i;
+        if (slot == s.bucketSlot)
+        {
+            finalizeBucket(s, out[i]);
+        }
+        else
+        {
+            out[i] = s.buckets[slot % HISTORY_BUCKETS];
+        }
+    }
+    startMs = (uint64_t)first * HISTORY_BUCKET_STEP_MS;
+    return count;
+}
+
+void MetricsHistory::setObserver(MetricObserver callback)
+{
+    observer = callback;
+}
+
+const char *MetricsHistory::metricName(MetricId id)
+{
+    return id < METRIC_COUNT ? metric_names[id] : "";
+}
+
+bool MetricsHistory::findMetric(const char *name, MetricId &id)
+{
+    for (uint8_t i = 0; i < METRIC_COUNT; i++)
+    {
+        if (strcmp(name, metric_names[i]) == 0)
+        {
+            id = (MetricId)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MetricsHistory::clear()
+{
+    for (uint8_t i = 0; i < METRIC_COUNT; i++)
+    {
+        series[i].started = false;
+    }
+}
@@ -0,0 +1,391 @@
+#include "mqtt_publisher.h"
+#include "settings_manager.h"
+#include "glances_api.h"
+#include "display.h"
+#include "config.h"
+#include "log_ring.h"
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <math.h>
+#include <stdarg.h>
+
+struct DiscoveryEntity
+{
+    const char *component;
+    const char *object;
+    const char *name;
+    const char *unit;
+    const char *deviceClass;
+};
+
+// Every entity reads its value from the shared state topic; switches and
+// buttons additionally get a command topic under <base>/cmd/<object>.
+static const DiscoveryEntity entities[] = {
+    {"sensor", "temperature", "Temperature", "°C", "temperature"},
+    {"sensor", "free_heap", "Free Memory", "KB", nullptr},
+    {"sensor", "wifi_strength", "WiFi Signal", "dBm", "signal_strength"},
+    {"sensor", "uptime", "Uptime", "s", nullptr},
+    {"sensor", "host_cpu", "Host CPU", "%", nullptr},
+    {"sensor", "host_mem", "Host Memory", "%", nullptr},
+    {"sensor", "host_load", "Host Load", nullptr, nullptr},
+    {"sensor", "host_temp", "Host Temperature", "°C", "temperature"},
+    {"sensor", "host_disk", "Host Drives", "%", nullptr},
+    {"sensor", "host_cache", "Host Cache", "%", nullptr},
+    {"sensor", "host_net_rx", "Host Download", "B/s", "data_rate"},
+    {"sensor", "host_net_tx", "Host Upload", "B/s", "data_rate"},
+    {"sensor", "host_net_rx_peak", "Host Download Peak", "B/s", "data_rate"},
+    {"sensor", "host_net_tx_peak", "Host Upload Peak", "B/s", "data_rate"},
+    {"switch", "dark_mode", "Dark Mode", nullptr, nullptr},
+    {"switch", "display", "Display", nullptr, nullptr},
+    {"button", "restart", "Restart", nullptr, nullptr},
+};
+
+static WiFiClient mqttNet;
+static PubSubClient mqtt(mqttNet);
+static char nodeId[24];
+static char payloadBuf[MQTT_BUFFER_SIZE];
+static unsigned long lastAttempt = 0;
+static unsigned long backoff = MQTT_RECONNECT_MIN_MS;
+static bool attempted = false;
+static unsigned long lastPublish = 0;
+static uint32_t lastStateHash = 0;
+static bool publishPending = false;
+static bool discoveryPending = true;
+static bool restartPending = false;
+
+// Connects run in a short-lived task so that DNS, the TCP connect and the
+// CONNACK wait never stall loop(). While one runs, nothing else touches the
+// client. The broker settings are copied for the task, since the web server
+// may change them meanwhile.
+enum ConnectState : uint8_t
+{
+    CONNECT_IDLE,
+    CONNECT_RUNNING,
+    CONNECT_DONE
+};
+
+static volatile ConnectState connectState = CONNECT_IDLE;
+static volatile bool connectOk = false;
+static bool reconfigurePending = false;
+static char connectHost[64];
+static char connectUser[32];
+static char connectPassword[64];
+static char willTopic[64];
+
+static void topicFor(char *buf, size_t size, const char *subtopic)
+{
+    snprintf(buf, size, "%s/%s", SettingsManager::getMqttTopic(), subtopic);
+}
+
+static void appendf(size_t &len, const char *format, ...)
+{
+    if (len >= sizeof(payloadBuf))
+        return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(payloadBuf + len, sizeof(payloadBuf) - len, format, args);
+    va_end(args);
+    if (n > 0)
+        len += n;
+}
+
+static void appendNumber(size_t &len, const char *key, float value)
+{
+    if (isnan(value))
+        appendf(len, ",\"%s\":null", key);
+    else
+        appendf(len, ",\"%s\":%.1f", key, value);
+}
+
+static uint32_t fnv1a(const char *data, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    while (len--)
+    {
+        hash ^= (uint8_t)*data++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool parseSwitch(const char *value)
+{
+    return strcasecmp(value, "ON") == 0 || strcasecmp(value, "true") == 0 || strcmp(value, "1") == 0;
+}
+
+void MqttPublisher::begin()
+{
+    uint64_t mac = ESP.getEfuseMac();
+    snprintf(nodeId, sizeof(nodeId), "cydsm_%06lx", (unsigned long)((mac >> 24) & 0xFFFFFF));
+
+    mqtt.setBufferSize(MQTT_BUFFER_SIZE);
+    mqtt.setSocketTimeout(2);
+    mqtt.setKeepAlive(30);
+    mqtt.setCallback(onMessage);
+}
+
+void MqttPublisher::reconfigure()
+{
+    if (connectState != CONNECT_IDLE)
+    {
+        // Dropped once the running attempt finishes
+        reconfigurePending = true;
+        return;
+    }
+    if (mqtt.connected())
+    {
+        mqtt.disconnect();
+    }
+    backoff = MQTT_RECONNECT_MIN_MS;
+    attempted = false;
+    discoveryPending = true;
+}
+
+void MqttPublisher::requestPublish()
+{
+    publishPending = true;
+}
+
+bool MqttPublisher::isConnected()
+{
+    return connectState == CONNECT_IDLE && mqtt.connected();
+}
+
+bool MqttPublisher::publish(const char *subtopic, const char *payload, bool retained)
+{
+    if (!isConnected())
+        return false;
+
+    char topic[96];
+    topicFor(topic, sizeof(topic), subtopic);
+    return mqtt.publish(topic, payload, retained);
+}
+
+void MqttPublisher::loop()
+{
+    if (connectState == CONNECT_RUNNING)
+    {
+        return;
+    }
+    if (connectState == CONNECT_DONE)
+    {
+        finishConnect();
+    }
+
+    if (SettingsManager::getMqttHost()[0] == '\0' || WiFi.status() != WL_CONNECTED)
+    {
+        return;
+    }
+
+    if (!mqtt.connected())
+    {
+        if (!attempted || millis() - lastAttempt >= backoff)
+        {
+            connect();
+        }
+        return;
+    }
+
+    mqtt.loop();
+
+    if (restartPending)
+    {
+        publish("status", "offline", true);
+        mqtt.disconnect();
+        delay(100);
+        ESP.restart();
+    }
+
+    if (discoveryPending)
+    {
+        publishDiscovery();
+    }
+    publishState(false);
+}
+
+void MqttPublisher::connectTask(void *)
+{
+    connectOk = mqtt.connect(nodeId,
+                             connectUser[0] ? connectUser : nullptr,
+                             connectPassword[0] ? connectPassword : nullptr,
+                             willTopic, 0, true, "offline");
+    connectState = CONNECT_DONE;
+    vTaskDelete(NULL);
+}
+
+void MqttPublisher::connect()
+{
+    attempted = true;
+    lastAttempt = millis();
+    strlcpy(connectHost, SettingsManager::getMqttHost(), sizeof(connectHost));
+    strlcpy(connectUser, SettingsManager::getMqttUser(), sizeof(connectUser));
+    strlcpy(connectPassword, SettingsManager::getMqttPassword(), sizeof(connectPassword));
+    topicFor(willTopic, sizeof(willTopic), "status");
+    mqtt.setServer(connectHost, SettingsManager::getMqttPort());
+
+    LOG_D(LOG_MOD_MQTT, "Connecting to MQTT broker %s:%d", connectHost, SettingsManager::getMqttPort());
+    connectState = CONNECT_RUNNING;
+    if (xTaskCreatePinnedToCore(connectTask, "mqtt_connect", MQTT_CONNECT_STACK, NULL, 1, NULL, 0) != pdPASS)
+    {
+        LOG_E(LOG_MOD_MQTT, "No memory for the MQTT connect task");
+        connectOk = false;
+        connectState = CONNECT_DONE;
+    }
+}
+
+void MqttPublisher::finishConnect()
+{
+    connectState = CONNECT_IDLE;
+    if (reconfigurePending)
+    {
+        reconfigurePending = false;
+        reconfigure();
+        return;
+    }
+
+    if (!connectOk)
+    {
+        LOG_W(LOG_MOD_MQTT, "MQTT connect failed (state %d), retrying in %lu ms", mqtt.state(), backoff);
+        backoff = backoff * 2 > MQTT_RECONNECT_MAX_MS ? MQTT_RECONNECT_MAX_MS : backoff * 2;
+        return;
+    }
+
+    char commandTopic[64];
+    LOG_I(LOG_MOD_MQTT, "MQTT connected");
+    backoff = MQTT_RECONNECT_MIN_MS;
+    mqtt.publish(willTopic, "online", true);
+    topicFor(commandTopic, sizeof(commandTopic), "cmd/#");
+    mqtt.subscribe(commandTopic);
+    discoveryPending = true;
+    publishPending = true;
+}
+
+void MqttPublisher::publishDiscovery()
+{
+    const char *base = SettingsManager::getMqttTopic();
+    char topic[128];
+
+    for (const DiscoveryEntity &entity : entities)
+    {
+        size_t len = 0;
+        appendf(len, "{\"name\":\"%s\",\"unique_id\":\"%s_%s\",\"object_id\":\"%s_%s\"",
+                entity.name, nodeId, entity.object, nodeId, entity.object);
+        appendf(len, ",\"availability_topic\":\"%s/status\"", base);
+
+        if (strcmp(entity.component, "button") == 0)
+        {
+            appendf(len, ",\"command_topic\":\"%s/cmd/%s\",\"payload_press\":\"PRESS\"", base, entity.object);
+        }
+        else
+        {
+            appendf(len, ",\"state_topic\":\"%s/state\"", base);
+            if (strcmp(entity.component, "switch") == 0)
+            {
+                appendf(len, ",\"command_topic\":\"%s/cmd/%s\"", base, entity.object);
+                appendf(len, ",\"value_template\":\"{{ 'ON' if value_json.%s else 'OFF' }}\"", entity.object);
+            }
+            else
+            {
+                appendf(len, ",\"value_template\":\"{{ value_json.%s }}\",\"state_class\":\"measurement\"", entity.object);
+            }
+        }
+        if (entity.unit)
+            appendf(len, ",\"unit_of_measurement\":\"%s\"", entity.unit);
+        if (entity.deviceClass)
+            appendf(len, ",\"device_class\":\"%s\"", entity.deviceClass);
+        appendf(len, ",\"device\":{\"identifiers\":[\"%s\"],\"name\":\"CYD System Monitor\",\"model\":\"ESP32-2432S028R\"}}", nodeId);
+
+        snprintf(topic, sizeof(topic), "homeassistant/%s/%s/%s/config", entity.component, nodeId, entity.object);
+        if (!mqtt.publish(topic, payloadBuf, true))
+        {
+            LOG_W(LOG_MOD_MQTT, "MQTT discovery publish failed for %s", entity.object);
+            return;
+        }
+    }
+    discoveryPending = false;
+}
+
+void MqttPublisher::publishState(bool force)
+{
+    unsigned long now = millis();
+    if (!force && now - lastPublish < MQTT_MIN_PUBLISH_INTERVAL_MS)
+    {
+        return;
+    }
+
+    size_t len = 0;
+    appendf(len, "{\"temperature\":%.1f", (temperatureRead() - 32) / 1.8);
+    appendf(len, ",\"free_heap\":%u", ESP.getFreeHeap() / 1024);
+    appendf(len, ",\"wifi_strength\":%d", WiFi.RSSI());
+    appendf(len, ",\"dark_mode\":%s", SettingsManager::getDarkMode() ? "true" : "false");
+    appendf(len, ",\"display\":%s", display_is_awake() ? "true" : "false");
+    appendNumber(len, "host_cpu", host_metrics.cpu_percent);
+    appendNumber(len, "host_mem", host_metrics.mem_percent);
+    appendNumber(len, "host_load", host_metrics.load1);
+    appendNumber(len, "host_temp", host_metrics.temperature);
+    appendNumber(len, "host_disk", host_metrics.disk_percent);
+    appendNumber(len, "host_cache", host_metrics.cache_percent);
+    appendNumber(len, "host_net_rx", host_metrics.net_rx_rate);
+    appendNumber(len, "host_net_tx", host_metrics.net_tx_rate);
+    appendNumber(len, "host_net_rx_peak", host_metrics.net_rx_peak);
+    appendNumber(len, "host_net_tx_peak", host_metrics.net_tx_peak);
+
+    // Uptime always moves, so it is left out of the change check and only
+    // rides along with real changes or the periodic refresh.
+    uint32_t hash = fnv1a(payloadBuf, len);
+    bool changed = hash != lastStateHash;
+    if (!force && !publishPending && !changed && now - lastPublish < MQTT_MAX_PUBLISH_INTERVAL_MS)
+    {
+        return;
+    }
+    appendf(len, ",\"uptime\":%lu}", millis() / 1000);
+
+    char topic[64];
+    topicFor(topic, sizeof(topic), "state");
+    if (mqtt.publish(topic, payloadBuf, true))
+    {
+        lastStateHash = hash;
+        lastPublish = now;
+        publishPending = false;
+    }
+}
+
+void MqttPublisher::onMessage(char *topic, uint8_t *payload, unsigned int length)
+{
+    char prefix[48];
+    topicFor(prefix, sizeof(prefix), "cmd/");
+    size_t prefixLen = strlen(prefix);
+    if (strncmp(topic, prefix, prefixLen) != 0)
+    {
+        return;
+    }
+    const char *command = topic + prefixLen;
+
+    char value[16];
+    size_t n = length < sizeof(value) - 1 ? length : sizeof(value) - 1;
+    memcpy(value, payload, n);
+    value[n] = '\0';
+
+    LOG_D(LOG_MOD_MQTT, "MQTT command %s = %s", command, value);
+
+    if (strcmp(command, "dark_mode") == 0)
+    {
+        SettingsManager::setDarkMode(parseSwitch(value));
+    }
+    else if (strcmp(command, "display") == 0)
+    {
+        display_sleep(!parseSwitch(value));
+    }
+    else if (strcmp(command, "restart") == 0)
+    {
+        restartPending = true;
+        return;
+    }
+    else
+    {
+        return;
+    }
+    publishPending = true;
+    publishState(true);
+}
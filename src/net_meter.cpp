@@ -0,0 +1,330 @@
+#include "net_meter.h"
+#include <string.h>
+#include <stdio.h>
+
+// Bonds and bridges carry the traffic of their member ports, so they are
+// preferred over the physical interfaces behind them. Windows hosts name
+// their adapters Ethernet and Wi-Fi.
+static const char default_patterns[] = "bond*,br0,eth0,en*,wl*,Ethernet*,Wi-Fi*";
+
+struct NetPattern
+{
+    bool exclude;
+    GlobPattern glob;
+};
+
+struct InterfaceState
+{
+    char name[NET_NAME_LENGTH];
+    uint32_t hash;
+    int8_t priority;
+    bool hasRate;
+    uint64_t rxBytes;
+    uint64_t txBytes;
+    uint64_t stampUs;
+    float rxRate;
+    float txRate;
+};
+
+static NetPattern patterns[NET_MAX_PATTERNS];
+static size_t pattern_count = 0;
+static bool patterns_loaded = false;
+static NetMode net_mode = NET_MODE_FIRST;
+
+// Interfaces of the previous payload, looked up through index, and the ones
+// collected from the payload being parsed
+static InterfaceState previous[NET_MAX_INTERFACES];
+static size_t previous_count = 0;
+static int8_t index_slots[NET_INDEX_SLOTS];
+static InterfaceState current[NET_MAX_INTERFACES];
+static size_t current_count = 0;
+static uint64_t pass_stamp_us = 0;
+
+static NetRates net_rates;
+static uint64_t rx_peak_us = 0;
+static uint64_t tx_peak_us = 0;
+
+static uint32_t nameHash(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name)
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void rebuildIndex()
+{
+    memset(index_slots, -1, sizeof(index_slots));
+    for (size_t i = 0; i < previous_count; i++)
+    {
+        uint32_t slot = previous[i].hash % NET_INDEX_SLOTS;
+        while (index_slots[slot] >= 0)
+            slot = (slot + 1) % NET_INDEX_SLOTS;
+        index_slots[slot] = i;
+    }
+}
+
+static const InterfaceState *findPrevious(const char *name, uint32_t hash)
+{
+    uint32_t slot = hash % NET_INDEX_SLOTS;
+    while (index_slots[slot] >= 0)
+    {
+        const InterfaceState &state = previous[index_slots[slot]];
+        if (state.hash == hash && strcmp(state.name, name) == 0)
+            return &state;
+        slot = (slot + 1) % NET_INDEX_SLOTS;
+    }
+    return nullptr;
+}
+
+// Position of the first matching pattern, or -1 when excluded or unmatched
+static int priorityOf(const char *name)
+{
+    for (size_t i = 0; i < pattern_count; i++)
+    {
+        if (patterns[i].glob.matches(name))
+            return patterns[i].exclude ? -1 : (int)i;
+    }
+    return -1;
+}
+
+static void holdPeak(float rate, float &peak, uint64_t &peakUs, uint64_t nowUs)
+{
+    if (rate >= peak || nowUs - peakUs > NET_PEAK_HOLD_MS * 1000ULL)
+    {
+        peak = rate;
+        peakUs = nowUs;
+    }
+}
+
+const char *NetMeter::defaultPatterns()
+{
+    return default_patterns;
+}
+
+const char *NetMeter::modeName(NetMode mode)
+{
+    return mode == NET_MODE_SUM ? "sum" : "first";
+}
+
+bool NetMeter::parseMode(const char *name, NetMode &mode)
+{
+    if (!name)
+        return false;
+    if (strcmp(name, "first") == 0)
+        mode = NET_MODE_FIRST;
+    else if (strcmp(name, "sum") == 0)
+        mode = NET_MODE_SUM;
+    else
+        return false;
+    return true;
+}
+
+static bool parsePatterns(const char *text, NetPattern *compiled, size_t &count, char *error, size_t errorSize)
+{
+    count = 0;
+    if (!text || text[0] == '\0')
+        text = default_patterns;
+
+    const char *entry = text;
+    while (*entry)
+    {
+        const char *end = entry;
+        while (*end && *end != ',')
+            end++;
+
+        const char *start = entry;
+        const char *stop = end;
+        while (start < stop && *start == ' ')
+            start++;
+        while (stop > start && stop[-1] == ' ')
+            stop--;
+
+        if (stop > start)
+        {
+            NetPattern pattern;
+            pattern.exclude = *start == '!';
+            if (count == NET_MAX_PATTERNS)
+            {
+                snprintf(error, errorSize, "More than %d patterns", NET_MAX_PATTERNS);
+                return false;
+            }
+            if (!pattern.glob.compile(start + pattern.exclude, stop - start - pattern.exclude))
+            {
+                snprintf(error, errorSize, "Invalid pattern '%.*s'", (int)(stop - start), start);
+                return false;
+            }
+            compiled[count++] = pattern;
+        }
+
+        entry = *end ? end + 1 : end;
+    }
+
+    if (count == 0)
+    {
+        snprintf(error, errorSize, "No interface patterns");
+        return false;
+    }
+    return true;
+}
+
+bool NetMeter::validate(const char *text, char *error, size_t errorSize)
+{
+    NetPattern compiled[NET_MAX_PATTERNS];
+    size_t count;
+    return parsePatterns(text, compiled, count, error, errorSize);
+}
+
+bool NetMeter::compile(const char *text, NetMode mode, char *error, size_t errorSize)
+{
+    NetPattern compiled[NET_MAX_PATTERNS];
+    size_t count;
+    if (!parsePatterns(text, compiled, count, error, errorSize))
+        return false;
+
+    memcpy(patterns, compiled, sizeof(NetPattern) * count);
+    pattern_count = count;
+    patterns_loaded = true;
+    if (mode != net_mode)
+    {
+        net_mode = mode;
+        reset();
+    }
+    return true;
+}
+
+void NetMeter::beginPass(uint64_t nowUs)
+{
+    if (!patterns_loaded)
+    {
+        char error[8];
+        compile(default_patterns, net_mode, error, sizeof(error));
+    }
+    if (previous_count == 0)
+        rebuildIndex();
+
+    pass_stamp_us = nowUs;
+    current_count = 0;
+}
+
+void NetMeter::addInterface(const char *name, uint64_t rxBytes, uint64_t txBytes)
+{
+    if (!name || current_count == NET_MAX_INTERFACES)
+        return;
+
+    int priority = priorityOf(name);
+    if (priority < 0)
+        return;
+
+    InterfaceState &state = current[current_count++];
+    snprintf(state.name, sizeof(state.name), "%s", name);
+    state.hash = nameHash(state.name);
+    state.priority = priority;
+    state.rxBytes = rxBytes;
+    state.txBytes = txBytes;
+    state.stampUs = pass_stamp_us;
+    state.hasRate = false;
+
+    // A counter going backwards means the interface or Glances restarted;
+    // the next payload starts a fresh interval.
+    const InterfaceState *prev = findPrevious(state.name, state.hash);
+    if (prev && pass_stamp_us > prev->stampUs && rxBytes >= prev->rxBytes && txBytes >= prev->txBytes)
+    {
+        float seconds = (pass_stamp_us - prev->stampUs) / 1000000.0f;
+        state.rxRate = (rxBytes - prev->rxBytes) / seconds;
+        state.txRate = (txBytes - prev->txBytes) / seconds;
+        state.hasRate = true;
+    }
+}
+
+bool NetMeter::endPass()
+{
+    const InterfaceState *selected = nullptr;
+    float rx = 0;
+    float tx = 0;
+    uint8_t count = 0;
+
+    for (size_t i = 0; i < current_count; i++)
+    {
+        const InterfaceState &state = current[i];
+        if (net_mode == NET_MODE_FIRST)
+        {
+            if (!selected || state.priority < selected->priority)
+                selected = &state;
+        }
+        else if (state.hasRate)
+        {
+            rx += state.rxRate;
+            tx += state.txRate;
+            count++;
+        }
+    }
+
+    net_rates.valid = false;
+    if (net_mode == NET_MODE_FIRST && selected)
+    {
+        snprintf(net_rates.name, sizeof(net_rates.name), "%s", selected->name);
+        if (selected->hasRate)
+        {
+            rx = selected->rxRate;
+            tx = selected->txRate;
+            count = 1;
+        }
+    }
+    else if (net_mode == NET_MODE_SUM)
+    {
+        snprintf(net_rates.name, sizeof(net_rates.name), "%u interfaces", (unsigned)current_count);
+    }
+
+    if (count > 0)
+    {
+        net_rates.valid = true;
+        net_rates.rxRate = rx;
+        net_rates.txRate = tx;
+        net_rates.interfaceCount = count;
+        holdPeak(rx, net_rates.rxPeak, rx_peak_us, pass_stamp_us);
+        holdPeak(tx, net_rates.txPeak, tx_peak_us, pass_stamp_us);
+    }
+
+    memcpy(previous, current, sizeof(InterfaceState) * current_count);
+    previous_count = current_count;
+    rebuildIndex();
+    return net_rates.valid;
+}
+
+const NetRates &NetMeter::rates()
+{
+    return net_rates;
+}
+
+size_t NetMeter::interfaceCount()
+{
+    return previous_count;
+}
+
+NetInterfaceRate NetMeter::interfaceRate(size_t index)
+{
+    NetInterfaceRate rate = {"", false, 0, 0};
+    if (index < previous_count)
+    {
+        const InterfaceState &state = previous[index];
+        rate.name = state.name;
+        rate.valid = state.hasRate;
+        rate.rxRate = state.rxRate;
+        rate.txRate = state.txRate;
+    }
+    return rate;
+}
+
+void NetMeter::reset()
+{
+    previous_count = 0;
+    current_count = 0;
+    rebuildIndex();
+    memset(&net_rates, 0, sizeof(net_rates));
+    rx_peak_us = 0;
+    tx_peak_us = 0;
+}
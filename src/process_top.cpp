@@ -0,0 +1,105 @@
+#include "process_top.h"
+#include "top_heap.h"
+#include <stdio.h>
+#include <string.h>
+
+static ProcessSort sort_key = PROCESS_SORT_CPU;
+
+static uint32_t seen = 0;
+
+// Ordered result of the last complete pass, which is what the page and API show
+static ProcessEntry top[PROCESS_TOP_N];
+static size_t top_count = 0;
+static uint32_t top_seen = 0;
+static uint32_t top_parse_us = 0;
+
+static float keyOf(const ProcessEntry &entry)
+{
+    return sort_key == PROCESS_SORT_MEM ? entry.mem : entry.cpu;
+}
+
+static bool lighter(const ProcessEntry &a, const ProcessEntry &b)
+{
+    return keyOf(a) < keyOf(b);
+}
+
+// Heap being filled by the current pass
+static TopHeap<ProcessEntry, PROCESS_TOP_N, lighter> heap;
+
+void ProcessTop::setSort(ProcessSort sort)
+{
+    sort_key = sort;
+}
+
+ProcessSort ProcessTop::sort()
+{
+    return sort_key;
+}
+
+const char *ProcessTop::sortName(ProcessSort sort)
+{
+    return sort == PROCESS_SORT_MEM ? "mem" : "cpu";
+}
+
+bool ProcessTop::parseSort(const char *name, ProcessSort &sort)
+{
+    if (!name)
+        return false;
+    if (strcmp(name, "cpu") == 0)
+        sort = PROCESS_SORT_CPU;
+    else if (strcmp(name, "mem") == 0)
+        sort = PROCESS_SORT_MEM;
+    else
+        return false;
+    return true;
+}
+
+void ProcessTop::beginPass()
+{
+    heap.clear();
+    seen = 0;
+}
+
+void ProcessTop::add(const char *name, uint32_t pid, float cpu, float mem)
+{
+    seen++;
+
+    ProcessEntry candidate;
+    candidate.pid = pid;
+    candidate.cpu = cpu;
+    candidate.mem = mem;
+
+    if (!heap.keeps(candidate))
+        return;
+    snprintf(candidate.name, sizeof(candidate.name), "%s", name ? name : "?");
+    heap.push(candidate);
+}
+
+void ProcessTop::endPass(uint32_t parseUs)
+{
+    heap.sortHeaviestFirst();
+    memcpy(top, heap.data(), sizeof(ProcessEntry) * heap.count());
+    top_count = heap.count();
+    top_seen = seen;
+    top_parse_us = parseUs;
+}
+
+size_t ProcessTop::count()
+{
+    return top_count;
+}
+
+const ProcessEntry &ProcessTop::entry(size_t index)
+{
+    return top[index < top_count ? index : 0];
+}
+
+uint32_t ProcessTop::processCount()
+{
+    return top_seen;
+}
+
+uint32_t ProcessTop::parseUs()
+{
+    return top_parse_us;
+}
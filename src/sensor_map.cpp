@@ -0,0 +1,340 @@
+#include "sensor_map.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Intel package, AMD Tctl/Tdie, NVMe composite and GPU edge temperatures.
+// The CPU thresholds match the original hard-coded 40/50 °C.
+static const char default_map[] =
+    "CPU=Package id 0|Tctl|Tdie|CPU*@40/50;"
+    "NVMe=Composite*@50/65;"
+    "GPU=*edge*|GPU*@60/80";
+
+static SensorSlot slots[SENSOR_MAX_SLOTS];
+static size_t slot_count = 0;
+static bool map_loaded = false;
+static SensorReading readings[SENSOR_MAX_SLOTS];
+
+// Position of each slot's sensor in the array, and a hash of its label to
+// notice when the entry at that position is no longer the same sensor
+static int16_t mapped_index[SENSOR_MAX_SLOTS];
+static uint32_t mapped_hash[SENSOR_MAX_SLOTS];
+static uint16_t mapped_entries = 0;
+static bool map_valid = false;
+static uint32_t rebuild_count = 0;
+
+static bool building = false;
+static bool relocating = false;
+static uint16_t pass_index = 0;
+static bool found[SENSOR_MAX_SLOTS];
+static float found_value[SENSOR_MAX_SLOTS];
+
+static uint32_t labelHash(const char *label)
+{
+    uint32_t hash = 2166136261u;
+    while (*label)
+    {
+        hash ^= (uint8_t)*label++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void trim(const char *&start, const char *&stop)
+{
+    while (start < stop && (*start == ' ' || *start == '\r' || *start == '\n'))
+        start++;
+    while (stop > start && (stop[-1] == ' ' || stop[-1] == '\r' || stop[-1] == '\n'))
+        stop--;
+}
+
+static bool parseThresholds(const char *start, const char *stop, SensorSlot &slot)
+{
+    char buf[24];
+    if (stop - start >= (int)sizeof(buf))
+        return false;
+    memcpy(buf, start, stop - start);
+    buf[stop - start] = '\0';
+
+    char *end;
+    slot.warn = strtof(buf, &end);
+    if (end == buf || *end != '/')
+        return false;
+    const char *critStart = end + 1;
+    slot.crit = strtof(critStart, &end);
+    return end != critStart && *end == '\0' && slot.crit >= slot.warn;
+}
+
+static bool parseEntry(const char *start, const char *stop, SensorSlot &slot)
+{
+    const char *equals = (const char *)memchr(start, '=', stop - start);
+    if (!equals)
+        return false;
+
+    const char *nameStart = start;
+    const char *nameStop = equals;
+    trim(nameStart, nameStop);
+    if (nameStop == nameStart || nameStop - nameStart >= SENSOR_NAME_LENGTH)
+        return false;
+    memcpy(slot.name, nameStart, nameStop - nameStart);
+    slot.name[nameStop - nameStart] = '\0';
+
+    const char *at = (const char *)memchr(equals, '@', stop - equals);
+    const char *patternsStop = at ? at : stop;
+    slot.warn = SENSOR_DEFAULT_WARN;
+    slot.crit = SENSOR_DEFAULT_CRIT;
+    if (at)
+    {
+        const char *thresholdStart = at + 1;
+        const char *thresholdStop = stop;
+        trim(thresholdStart, thresholdStop);
+        if (!parseThresholds(thresholdStart, thresholdStop, slot))
+            return false;
+    }
+
+    slot.patternCount = 0;
+    const char *pattern = equals + 1;
+    while (pattern < patternsStop)
+    {
+        const char *end = (const char *)memchr(pattern, '|', patternsStop - pattern);
+        if (!end)
+            end = patternsStop;
+
+        const char *patternStart = pattern;
+        const char *patternStop = end;
+        trim(patternStart, patternStop);
+        if (slot.patternCount == SENSOR_MAX_PATTERNS ||
+            !slot.patterns[slot.patternCount].compile(patternStart, patternStop - patternStart))
+            return false;
+        slot.patternCount++;
+
+        pattern = end + 1;
+    }
+    return slot.patternCount > 0;
+}
+
+const char *SensorMap::defaultMap()
+{
+    return default_map;
+}
+
+static bool parseMap(const char *text, SensorSlot *compiled, size_t &count, char *error, size_t errorSize)
+{
+    count = 0;
+    if (!text || text[0] == '\0')
+        text = default_map;
+
+    const char *entry = text;
+    while (*entry)
+    {
+        const char *end = entry;
+        while (*end && *end != ';')
+            end++;
+
+        const char *start = entry;
+        const char *stop = end;
+        trim(start, stop);
+
+        if (stop > start)
+        {
+            if (count == SENSOR_MAX_SLOTS)
+            {
+                snprintf(error, errorSize, "More than %d sensors", SENSOR_MAX_SLOTS);
+                return false;
+            }
+            if (!parseEntry(start, stop, compiled[count]))
+            {
+                snprintf(error, errorSize, "Invalid sensor '%.*s'", (int)(stop - start), start);
+                return false;
+            }
+            count++;
+        }
+
+        entry = *end ? end + 1 : end;
+    }
+    return true;
+}
+
+bool SensorMap::validate(const char *text, char *error, size_t errorSize)
+{
+    SensorSlot compiled[SENSOR_MAX_SLOTS];
+    size_t count;
+    return parseMap(text, compiled, count, error, errorSize);
+}
+
+bool SensorMap::compile(const char *text, char *error, size_t errorSize)
+{
+    SensorSlot compiled[SENSOR_MAX_SLOTS];
+    size_t count;
+    if (!parseMap(text, compiled, count, error, errorSize))
+        return false;
+
+    memcpy(slots, compiled, sizeof(SensorSlot) * count);
+    slot_count = count;
+    map_loaded = true;
+    map_valid = false;
+    for (size_t i = 0; i < SENSOR_MAX_SLOTS; i++)
+    {
+        readings[i].present = false;
+        readings[i].value = NAN;
+    }
+    resetExtremes();
+    return true;
+}
+
+size_t SensorMap::slotCount()
+{
+    return slot_count;
+}
+
+const SensorSlot &SensorMap::slot(size_t index)
+{
+    return slots[index < slot_count ? index : 0];
+}
+
+void SensorMap::beginPass()
+{
+    if (!map_loaded)
+    {
+        char error[8];
+        compile(default_map, error, sizeof(error));
+    }
+
+    building = !map_valid;
+    relocating = false;
+    pass_index = 0;
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        found[i] = false;
+        if (building)
+            mapped_index[i] = -1;
+    }
+}
+
+void SensorMap::addSensor(const char *label, const char *type, float value)
+{
+    uint16_t index = pass_index++;
+    if (!label)
+        return;
+
+    if (!building)
+    {
+        for (size_t i = 0; i < slot_count && !relocating; i++)
+        {
+            if (mapped_index[i] != index)
+                continue;
+            if (labelHash(label) != mapped_hash[i])
+            {
+                // Sensors were added, removed or reordered
+                map_valid = false;
+                relocating = true;
+                break;
+            }
+            found[i] = true;
+            found_value[i] = value;
+        }
+        if (!relocating)
+            return;
+
+        // Until the map is rebuilt on the next pass, slots still missing
+        // follow their sensor's label to wherever it moved
+        uint32_t hash = labelHash(label);
+        for (size_t i = 0; i < slot_count; i++)
+        {
+            if (!found[i] && mapped_index[i] >= 0 && mapped_hash[i] == hash)
+            {
+                found[i] = true;
+                found_value[i] = value;
+            }
+        }
+        return;
+    }
+
+    if (!type || strncmp(type, "temperature", 11) != 0)
+        return;
+
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        if (mapped_index[i] >= 0)
+            continue;
+        const SensorSlot &slot = slots[i];
+        for (uint8_t p = 0; p < slot.patternCount; p++)
+        {
+            if (slot.patterns[p].matches(label))
+            {
+                mapped_index[i] = index;
+                mapped_hash[i] = labelHash(label);
+                snprintf(readings[i].label, sizeof(readings[i].label), "%s", label);
+                found[i] = true;
+                found_value[i] = value;
+                break;
+            }
+        }
+    }
+}
+
+void SensorMap::endPass()
+{
+    if (building)
+    {
+        mapped_entries = pass_index;
+        map_valid = true;
+        rebuild_count++;
+    }
+    else if (pass_index != mapped_entries)
+    {
+        map_valid = false;
+    }
+
+    for (size_t i = 0; i < slot_count; i++)
+    {
+        SensorReading &reading = readings[i];
+        // A sensor that moved up the list while the pass was relocating was
+        // not seen again; keep its last reading for the one pass
+        if (relocating && !found[i] && reading.present)
+            continue;
+        reading.present = found[i];
+        if (!found[i])
+        {
+            reading.value = NAN;
+            continue;
+        }
+
+        reading.value = found_value[i];
+        reading.level = levelOf(i, reading.value);
+        if (isnan(reading.min) || reading.value < reading.min)
+            reading.min = reading.value;
+        if (isnan(reading.max) || reading.value > reading.max)
+            reading.max = reading.value;
+    }
+}
+
+const SensorReading &SensorMap::reading(size_t index)
+{
+    return readings[index < SENSOR_MAX_SLOTS ? index : 0];
+}
+
+SensorLevel SensorMap::levelOf(size_t index, float value)
+{
+    const SensorSlot &s = slot(index);
+    if (value >= s.crit)
+        return SENSOR_LEVEL_CRIT;
+    if (value >= s.warn)
+        return SENSOR_LEVEL_WARN;
+    return SENSOR_LEVEL_OK;
+}
+
+uint32_t SensorMap::rebuildCount()
+{
+    return rebuild_count;
+}
+
+void SensorMap::resetExtremes()
+{
+    for (size_t i = 0; i < SENSOR_MAX_SLOTS; i++)
+    {
+        readings[i].min = NAN;
+        readings[i].max = NAN;
+    }
+}
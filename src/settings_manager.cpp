@@ -1,67 +1,349 @@
 #include "settings_manager.h"
 #include "config.h"
+#include "fs_classifier.h"
+#include "net_meter.h"
+#include "sensor_map.h"
+#include "touch.h"
+#include "alert_engine.h"
+#include "log_ring.h"
+#include <Arduino.h>
 #include <lvgl.h>
 #include <string.h>
 
+// All settings live in a single NVS blob so boot costs one lookup instead of
+// one per key. Fields may only be appended to SettingsRecord; bump
+// SETTINGS_VERSION when doing so. Shorter records written by older firmware
+// load into a default-initialised record, so new fields keep their defaults.
+#define SETTINGS_KEY "cfg"
+#define SETTINGS_MAGIC 0x4359
+#define SETTINGS_VERSION 7
+#define THEME_COLOR_COUNT 6
+#define NO_COLOR_OVERRIDE 0xFFFFFFFF
+#define LEGACY_BENCH_NAMESPACE "settings_kv"
+
+struct SettingsHeader
+{
+    uint16_t magic;
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t length;
+    uint16_t reserved2;
+    uint32_t crc;
+};
+
+struct SettingsRecord
+{
+    uint8_t darkMode;
+    uint8_t reserved;
+    uint16_t glancesPort;
+    uint32_t darkColors[THEME_COLOR_COUNT];
+    uint32_t lightColors[THEME_COLOR_COUNT];
+    char glancesHost[64];
+    // v2
+    uint16_t mqttPort;
+    uint16_t reserved2;
+    char mqttHost[64];
+    char mqttUser[32];
+    char mqttPassword[64];
+    char mqttTopic[32];
+    // v3
+    char fsRules[FS_RULES_MAX_LENGTH];
+    // v4
+    uint8_t netMode;
+    uint8_t reserved3[3];
+    char netInterfaces[NET_INTERFACES_MAX_LENGTH];
+    // v5
+    char sensorMap[SENSOR_MAP_MAX_LENGTH];
+    // v6
+    TouchCalibration touchCalibration;
+    // v7
+    char alertRules[ALERT_RULES_MAX_LENGTH];
+    char alertWebhook[ALERT_WEBHOOK_MAX_LENGTH];
+};
+
+struct SettingsBlob
+{
+    SettingsHeader header;
+    SettingsRecord record;
+};
+
+// Order matches the legacy per-key names and the ThemeColors members
+static const char *const color_names[THEME_COLOR_COUNT] = {
+    "bg_color",
+    "card_bg_color",
+    "text_color",
+    "cpu_color",
+    "ram_color",
+    "border_color"};
+
+static lv_color_t ThemeColors::*const color_members[THEME_COLOR_COUNT] = {
+    &ThemeColors::bg_color,
+    &ThemeColors::card_bg_color,
+    &ThemeColors::text_color,
+    &ThemeColors::cpu_color,
+    &ThemeColors::ram_color,
+    &ThemeColors::border_color};
+
 Preferences SettingsManager::preferences;
 bool SettingsManager::darkMode = true;
 SettingsManager::ThemeCallback SettingsManager::themeCallback = nullptr;
 
 static ThemeColors mutable_dark_theme = dark_theme;
 static ThemeColors mutable_light_theme = light_theme;
+static SettingsRecord record;
 
 String SettingsManager::glancesHost;
 uint16_t SettingsManager::glancesPort;
+uint32_t SettingsManager::loadTimeUs = 0;
+bool SettingsManager::updating = false;
+bool SettingsManager::pendingSave = false;
+bool SettingsManager::pendingTheme = false;
+
+static uint32_t crc32(const uint8_t *data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    while (length--)
+    {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static void setRecordDefaults(SettingsRecord &rec)
+{
+    memset(&rec, 0, sizeof(rec));
+    rec.darkMode = 1;
+    rec.glancesPort = 61208;
+    rec.mqttPort = 1883;
+    strlcpy(rec.mqttTopic, "cydsm", sizeof(rec.mqttTopic));
+    rec.touchCalibration = touch_default_calibration();
+    for (int i = 0; i < THEME_COLOR_COUNT; i++)
+    {
+        rec.darkColors[i] = NO_COLOR_OVERRIDE;
+        rec.lightColors[i] = NO_COLOR_OVERRIDE;
+    }
+}
+
+static int findColorIndex(const char *colorName)
+{
+    for (int i = 0; i < THEME_COLOR_COUNT; i++)
+    {
+        if (strcmp(colorName, color_names[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void buildTheme(ThemeColors &theme, const ThemeColors &defaults, const uint32_t *overrides)
+{
+    theme = defaults;
+    for (int i = 0; i < THEME_COLOR_COUNT; i++)
+    {
+        if (overrides[i] != NO_COLOR_OVERRIDE)
+        {
+            theme.*color_members[i] = lv_color_hex(overrides[i]);
+        }
+    }
+}
 
 void SettingsManager::begin()
 {
+    uint32_t start = micros();
+
     preferences.begin("settings", false);
-    darkMode = preferences.getBool("darkMode", true);
+    loadSettings();
 
-    glancesHost = preferences.getString("glances_host", "");
-    glancesPort = preferences.getUInt("glances_port", 61208);
+    loadTimeUs = micros() - start;
+    LOG_I(LOG_MOD_SYSTEM, "Settings loaded in %u us", (unsigned)loadTimeUs);
+    removeLegacyBench();
+#ifdef SETTINGS_LEGACY_BENCH
+    measureLegacyLoad();
+#endif
 
-    glances_host = glancesHost;
-    glances_port = glancesPort;
+    if (themeCallback)
+    {
+        themeCallback(darkMode);
+    }
+}
+
+void SettingsManager::loadSettings()
+{
+    SettingsBlob blob;
+    setRecordDefaults(blob.record);
 
-    mutable_dark_theme = dark_theme;
-    mutable_light_theme = light_theme;
+    size_t read = preferences.getBytes(SETTINGS_KEY, &blob, sizeof(blob));
+    bool valid = read >= sizeof(SettingsHeader) &&
+                 blob.header.magic == SETTINGS_MAGIC &&
+                 blob.header.length <= sizeof(SettingsRecord) &&
+                 read == sizeof(SettingsHeader) + blob.header.length &&
+                 blob.header.crc == crc32((const uint8_t *)&blob.record, blob.header.length);
 
-    if (preferences.isKey("bg_color"))
+    if (valid)
     {
-        uint32_t color = preferences.getUInt("bg_color", 0);
-        mutable_dark_theme.bg_color = lv_color_hex(color);
+        record = blob.record;
+        if (blob.header.version != SETTINGS_VERSION)
+        {
+            LOG_I(LOG_MOD_SYSTEM, "Upgrading settings record from v%d to v%d", blob.header.version, SETTINGS_VERSION);
+            applyRecord();
+            saveSettings();
+            return;
+        }
     }
-    if (preferences.isKey("card_bg_color"))
+    else
     {
-        uint32_t color = preferences.getUInt("card_bg_color", 0);
-        mutable_dark_theme.card_bg_color = lv_color_hex(color);
+        if (read > 0)
+        {
+            LOG_W(LOG_MOD_SYSTEM, "Settings record corrupt, falling back to defaults");
+        }
+        setRecordDefaults(record);
+        if (migrateLegacyKeys())
+        {
+            applyRecord();
+            saveSettings();
+            return;
+        }
     }
-    if (preferences.isKey("text_color"))
+
+    applyRecord();
+}
+
+// Imports the one-key-per-setting layout used before the settings blob. Legacy
+// color overrides only ever applied to the dark theme.
+bool SettingsManager::migrateLegacyKeys()
+{
+    if (!preferences.isKey("darkMode") && !preferences.isKey("glances_host") &&
+        !preferences.isKey("glances_port") && !preferences.isKey("bg_color") &&
+        !preferences.isKey("card_bg_color") && !preferences.isKey("text_color") &&
+        !preferences.isKey("cpu_color") && !preferences.isKey("ram_color") &&
+        !preferences.isKey("border_color"))
     {
-        uint32_t color = preferences.getUInt("text_color", 0);
-        mutable_dark_theme.text_color = lv_color_hex(color);
+        return false;
     }
-    if (preferences.isKey("cpu_color"))
+
+    LOG_I(LOG_MOD_SYSTEM, "Migrating legacy settings keys");
+    record.darkMode = preferences.getBool("darkMode", true) ? 1 : 0;
+    record.glancesPort = preferences.getUInt("glances_port", 61208);
+    String host = preferences.getString("glances_host", "");
+    strlcpy(record.glancesHost, host.c_str(), sizeof(record.glancesHost));
+
+    for (int i = 0; i < THEME_COLOR_COUNT; i++)
     {
-        uint32_t color = preferences.getUInt("cpu_color", 0);
-        mutable_dark_theme.cpu_color = lv_color_hex(color);
+        if (preferences.isKey(color_names[i]))
+        {
+            record.darkColors[i] = preferences.getUInt(color_names[i], 0) & 0xFFFFFF;
+        }
     }
-    if (preferences.isKey("ram_color"))
+
+    preferences.remove("darkMode");
+    preferences.remove("glances_host");
+    preferences.remove("glances_port");
+    for (int i = 0; i < THEME_COLOR_COUNT; i++)
     {
-        uint32_t color = preferences.getUInt("ram_color", 0);
-        mutable_dark_theme.ram_color = lv_color_hex(color);
+        preferences.remove(color_names[i]);
     }
-    if (preferences.isKey("border_color"))
+    return true;
+}
+
+// Earlier firmware timed the per-key layout on every boot against a scratch
+// namespace holding a copy of the settings, Glances host included. Its keys
+// are erased where they are still left. Opening a namespace that does not
+// exist read-only fails without writing anything.
+void SettingsManager::removeLegacyBench()
+{
+    Preferences legacy;
+    if (!legacy.begin(LEGACY_BENCH_NAMESPACE, true))
+    {
+        return;
+    }
+    bool stale = legacy.isKey("darkMode");
+    legacy.end();
+    if (!stale)
     {
-        uint32_t color = preferences.getUInt("border_color", 0);
-        mutable_dark_theme.border_color = lv_color_hex(color);
+        return;
     }
+    legacy.begin(LEGACY_BENCH_NAMESPACE, false);
+    legacy.clear();
+    legacy.end();
+}
 
-    if (themeCallback)
+#ifdef SETTINGS_LEGACY_BENCH
+// Build with -D SETTINGS_LEGACY_BENCH to time the one-key-per-setting load
+// that boot did before the blob, with all six color overrides set. The
+// scratch namespace is written, read and cleared again in the same boot.
+void SettingsManager::measureLegacyLoad()
+{
+    Preferences legacy;
+    if (!legacy.begin(LEGACY_BENCH_NAMESPACE, false))
     {
-        themeCallback(darkMode);
+        return;
+    }
+    legacy.putBool("darkMode", record.darkMode);
+    legacy.putString("glances_host", record.glancesHost);
+    legacy.putUInt("glances_port", record.glancesPort);
+    for (int i = 0; i < THEME_COLOR_COUNT; i++)
+    {
+        legacy.putUInt(color_names[i], lv_color_to32(mutable_dark_theme.*color_members[i]) & 0xFFFFFF);
     }
+    legacy.end();
+
+    uint32_t start = micros();
+
+    legacy.begin(LEGACY_BENCH_NAMESPACE, true);
+    bool dark = legacy.getBool("darkMode", true);
+    String host = legacy.getString("glances_host", "");
+    uint32_t port = legacy.getUInt("glances_port", 61208);
+    uint32_t colors = 0;
+    for (int i = 0; i < THEME_COLOR_COUNT; i++)
+    {
+        if (legacy.isKey(color_names[i]))
+        {
+            colors ^= legacy.getUInt(color_names[i], 0);
+        }
+    }
+    legacy.end();
+
+    uint32_t legacyUs = micros() - start;
+    LOG_I(LOG_MOD_SYSTEM, "Settings per-key layout loaded in %u us (blob: %u us)", (unsigned)legacyUs,
+          (unsigned)loadTimeUs);
+    (void)dark;
+    (void)port;
+    (void)colors;
+    removeLegacyBench();
+}
+#endif
+
+void SettingsManager::applyRecord()
+{
+    record.glancesHost[sizeof(record.glancesHost) - 1] = '\0';
+    record.mqttHost[sizeof(record.mqttHost) - 1] = '\0';
+    record.mqttUser[sizeof(record.mqttUser) - 1] = '\0';
+    record.mqttPassword[sizeof(record.mqttPassword) - 1] = '\0';
+    record.mqttTopic[sizeof(record.mqttTopic) - 1] = '\0';
+    record.fsRules[sizeof(record.fsRules) - 1] = '\0';
+    record.netInterfaces[sizeof(record.netInterfaces) - 1] = '\0';
+    record.sensorMap[sizeof(record.sensorMap) - 1] = '\0';
+    record.alertRules[sizeof(record.alertRules) - 1] = '\0';
+    record.alertWebhook[sizeof(record.alertWebhook) - 1] = '\0';
+    if (!touch_calibration_valid(record.touchCalibration))
+    {
+        record.touchCalibration = touch_default_calibration();
+    }
+
+    darkMode = record.darkMode != 0;
+    glancesHost = record.glancesHost;
+    glancesPort = record.glancesPort;
+
+    glances_host = glancesHost;
+    glances_port = glancesPort;
+
+    buildTheme(mutable_dark_theme, dark_theme, record.darkColors);
+    buildTheme(mutable_light_theme, light_theme, record.lightColors);
 }
 
 bool SettingsManager::getDarkMode()
@@ -72,56 +354,78 @@ bool SettingsManager::getDarkMode()
 void SettingsManager::setDarkMode(bool enabled)
 {
     darkMode = enabled;
-    saveSettings();
-    if (themeCallback)
-    {
-        themeCallback(enabled);
-    }
+    changed(true);
 }
 
-void SettingsManager::saveSettings()
+void SettingsManager::beginUpdate()
 {
-    preferences.putBool("darkMode", darkMode);
+    updating = true;
 }
 
-void SettingsManager::updateThemeColor(const char *colorName, uint32_t color)
+void SettingsManager::commit()
 {
-    ThemeColors &theme = darkMode ? mutable_dark_theme : mutable_light_theme;
-
-    if (strcmp(colorName, "bg_color") == 0)
-    {
-        theme.bg_color = lv_color_hex(color);
-        preferences.putUInt("bg_color", color);
-    }
-    else if (strcmp(colorName, "card_bg_color") == 0)
+    updating = false;
+    if (pendingSave)
     {
-        theme.card_bg_color = lv_color_hex(color);
-        preferences.putUInt("card_bg_color", color);
+        saveSettings();
     }
-    else if (strcmp(colorName, "text_color") == 0)
+    if (pendingTheme && themeCallback)
     {
-        theme.text_color = lv_color_hex(color);
-        preferences.putUInt("text_color", color);
+        themeCallback(darkMode);
     }
-    else if (strcmp(colorName, "cpu_color") == 0)
+    pendingSave = false;
+    pendingTheme = false;
+}
+
+// Saves the record and, for theme changes, restyles the GUI, or leaves both
+// to commit() while an update is open
+void SettingsManager::changed(bool theme)
+{
+    if (updating)
     {
-        theme.cpu_color = lv_color_hex(color);
-        preferences.putUInt("cpu_color", color);
+        pendingSave = true;
+        pendingTheme |= theme;
+        return;
     }
-    else if (strcmp(colorName, "ram_color") == 0)
+    saveSettings();
+    if (theme && themeCallback)
     {
-        theme.ram_color = lv_color_hex(color);
-        preferences.putUInt("ram_color", color);
+        themeCallback(darkMode);
     }
-    else if (strcmp(colorName, "border_color") == 0)
+}
+
+void SettingsManager::saveSettings()
+{
+    SettingsBlob blob;
+    record.darkMode = darkMode ? 1 : 0;
+    blob.record = record;
+    blob.header.magic = SETTINGS_MAGIC;
+    blob.header.version = SETTINGS_VERSION;
+    blob.header.reserved = 0;
+    blob.header.length = sizeof(SettingsRecord);
+    blob.header.reserved2 = 0;
+    blob.header.crc = crc32((const uint8_t *)&blob.record, sizeof(SettingsRecord));
+
+    if (preferences.putBytes(SETTINGS_KEY, &blob, sizeof(blob)) != sizeof(blob))
     {
-        theme.border_color = lv_color_hex(color);
-        preferences.putUInt("border_color", color);
+        LOG_E(LOG_MOD_SYSTEM, "Failed to save settings");
     }
-    if (themeCallback)
+}
+
+void SettingsManager::updateThemeColor(const char *colorName, uint32_t color)
+{
+    int index = findColorIndex(colorName);
+    if (index < 0)
     {
-        themeCallback(darkMode);
+        return;
     }
+
+    ThemeColors &theme = darkMode ? mutable_dark_theme : mutable_light_theme;
+    uint32_t *overrides = darkMode ? record.darkColors : record.lightColors;
+
+    overrides[index] = color & 0xFFFFFF;
+    theme.*color_members[index] = lv_color_hex(overrides[index]);
+    changed(true);
 }
 
 const ThemeColors &SettingsManager::getCurrentTheme()
@@ -131,12 +435,29 @@ const ThemeColors &SettingsManager::getCurrentTheme()
 
 void SettingsManager::clearSavedColors()
 {
-    preferences.remove("bg_color");
-    preferences.remove("card_bg_color");
-    preferences.remove("text_color");
-    preferences.remove("cpu_color");
-    preferences.remove("ram_color");
-    preferences.remove("border_color");
+    uint32_t *overrides = darkMode ? record.darkColors : record.lightColors;
+    for (int i = 0; i < THEME_COLOR_COUNT; i++)
+    {
+        overrides[i] = NO_COLOR_OVERRIDE;
+    }
+    changed(false);
+}
+
+void SettingsManager::resetCurrentTheme()
+{
+    clearSavedColors();
+    if (darkMode)
+    {
+        mutable_dark_theme = dark_theme;
+    }
+    else
+    {
+        mutable_light_theme = light_theme;
+    }
+    if (themeCallback)
+    {
+        themeCallback(darkMode);
+    }
 }
 
 const String &SettingsManager::getGlancesHost()
@@ -151,14 +472,143 @@ uint16_t SettingsManager::getGlancesPort()
 
 void SettingsManager::setGlancesHost(const String &host)
 {
-    glancesHost = host;
-    preferences.putString("glances_host", host);
-    glances_host = host;
+    strlcpy(record.glancesHost, host.c_str(), sizeof(record.glancesHost));
+    glancesHost = record.glancesHost;
+    glances_host = glancesHost;
+    changed(false);
 }
 
 void SettingsManager::setGlancesPort(uint16_t port)
 {
+    record.glancesPort = port;
     glancesPort = port;
-    preferences.putUInt("glances_port", port);
     glances_port = port;
-}
\ No newline at end of file
+    changed(false);
+}
+
+uint32_t SettingsManager::getLoadTimeUs()
+{
+    return loadTimeUs;
+}
+
+const char *SettingsManager::getMqttHost()
+{
+    return record.mqttHost;
+}
+
+uint16_t SettingsManager::getMqttPort()
+{
+    return record.mqttPort;
+}
+
+const char *SettingsManager::getMqttUser()
+{
+    return record.mqttUser;
+}
+
+const char *SettingsManager::getMqttPassword()
+{
+    return record.mqttPassword;
+}
+
+const char *SettingsManager::getMqttTopic()
+{
+    return record.mqttTopic;
+}
+
+void SettingsManager::setMqttHost(const String &host)
+{
+    strlcpy(record.mqttHost, host.c_str(), sizeof(record.mqttHost));
+    changed(false);
+}
+
+void SettingsManager::setMqttPort(uint16_t port)
+{
+    record.mqttPort = port;
+    changed(false);
+}
+
+void SettingsManager::setMqttCredentials(const String &user, const String &password)
+{
+    strlcpy(record.mqttUser, user.c_str(), sizeof(record.mqttUser));
+    strlcpy(record.mqttPassword, password.c_str(), sizeof(record.mqttPassword));
+    changed(false);
+}
+
+void SettingsManager::setMqttTopic(const String &topic)
+{
+    strlcpy(record.mqttTopic, topic.length() ? topic.c_str() : "cydsm", sizeof(record.mqttTopic));
+    changed(false);
+}
+
+const char *SettingsManager::getFsRules()
+{
+    return record.fsRules;
+}
+
+void SettingsManager::setFsRules(const String &rules)
+{
+    strlcpy(record.fsRules, rules.c_str(), sizeof(record.fsRules));
+    changed(false);
+}
+
+const char *SettingsManager::getNetInterfaces()
+{
+    return record.netInterfaces;
+}
+
+uint8_t SettingsManager::getNetMode()
+{
+    return record.netMode;
+}
+
+const char *SettingsManager::getSensorMap()
+{
+    return record.sensorMap;
+}
+
+void SettingsManager::setSensorMap(const String &map)
+{
+    strlcpy(record.sensorMap, map.c_str(), sizeof(record.sensorMap));
+    changed(false);
+}
+
+void SettingsManager::setNetInterfaces(const String &patterns, uint8_t mode)
+{
+    strlcpy(record.netInterfaces, patterns.c_str(), sizeof(record.netInterfaces));
+    record.netMode = mode;
+    changed(false);
+}
+
+const TouchCalibration &SettingsManager::getTouchCalibration()
+{
+    return record.touchCalibration;
+}
+
+void SettingsManager::setTouchCalibration(const TouchCalibration &calibration)
+{
+    record.touchCalibration = calibration;
+    changed(false);
+}
+
+const char *SettingsManager::getAlertRules()
+{
+    return record.alertRules;
+}
+
+void SettingsManager::setAlertRules(const String &rules)
+{
+    strlcpy(record.alertRules, rules.c_str(), sizeof(record.alertRules));
+    changed(false);
+}
+
+const char *SettingsManager::getAlertWebhook()
+{
+    return record.alertWebhook;
+}
+
+void SettingsManager::setAlertWebhook(const String &url)
+{
+    strlcpy(record.alertWebhook, url.c_str(), sizeof(record.alertWebhook));
+    changed(false);
+}
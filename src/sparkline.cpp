@@ -0,0 +1,103 @@
+#include "sparkline.h"
+#include <string.h>
+
+struct SparklineData
+{
+    uint16_t count;
+    lv_color_t color;
+    float values[SPARKLINE_MAX_POINTS];
+};
+
+static void draw_cb(lv_event_t *e)
+{
+    lv_obj_t *spark = lv_event_get_target(e);
+    SparklineData *data = (SparklineData *)lv_obj_get_user_data(spark);
+    if (!data || data->count < 2)
+        return;
+
+    float max = 0;
+    for (uint16_t i = 0; i < data->count; i++)
+    {
+        if (data->values[i] > max)
+            max = data->values[i];
+    }
+
+    lv_area_t area;
+    lv_obj_get_content_coords(spark, &area);
+    lv_coord_t w = lv_area_get_width(&area) - 1;
+    lv_coord_t h = lv_area_get_height(&area) - 1;
+
+    lv_draw_line_dsc_t dsc;
+    lv_draw_line_dsc_init(&dsc);
+    dsc.color = data->color;
+    dsc.width = 2;
+    dsc.round_start = 1;
+    dsc.round_end = 1;
+
+    // Points are spread over the full width whatever the count
+    lv_point_t prev;
+    for (uint16_t i = 0; i < data->count; i++)
+    {
+        lv_point_t p;
+        p.x = area.x1 + (lv_coord_t)((int32_t)w * i / (data->count - 1));
+        p.y = area.y2 - (max > 0 ? (lv_coord_t)(data->values[i] * h / max) : 0);
+        if (i > 0)
+            lv_draw_line(lv_event_get_draw_ctx(e), &dsc, &prev, &p);
+        prev = p;
+    }
+}
+
+static void delete_cb(lv_event_t *e)
+{
+    lv_obj_t *spark = lv_event_get_target(e);
+    lv_mem_free(lv_obj_get_user_data(spark));
+    lv_obj_set_user_data(spark, NULL);
+}
+
+lv_obj_t *sparkline_create(lv_obj_t *parent)
+{
+    lv_obj_t *spark = lv_obj_create(parent);
+    lv_obj_set_style_bg_opa(spark, LV_OPA_0, 0);
+    lv_obj_set_style_border_width(spark, 0, 0);
+    lv_obj_set_style_pad_all(spark, 2, 0);
+    lv_obj_clear_flag(spark, LV_OBJ_FLAG_SCROLLABLE);
+
+    SparklineData *data = (SparklineData *)lv_mem_alloc(sizeof(SparklineData));
+    if (data)
+    {
+        data->count = 0;
+        data->color = lv_color_white();
+    }
+    lv_obj_set_user_data(spark, data);
+    lv_obj_add_event_cb(spark, draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(spark, delete_cb, LV_EVENT_DELETE, NULL);
+    return spark;
+}
+
+void sparkline_set_values(lv_obj_t *spark, const float *values, uint16_t count)
+{
+    SparklineData *data = (SparklineData *)lv_obj_get_user_data(spark);
+    if (!data)
+        return;
+
+    if (count > SPARKLINE_MAX_POINTS)
+    {
+        values += count - SPARKLINE_MAX_POINTS;
+        count = SPARKLINE_MAX_POINTS;
+    }
+    if (count == data->count && memcmp(values, data->values, count * sizeof(float)) == 0)
+        return;
+
+    memcpy(data->values, values, count * sizeof(float));
+    data->count = count;
+    lv_obj_invalidate(spark);
+}
+
+void sparkline_set_color(lv_obj_t *spark, lv_color_t color)
+{
+    SparklineData *data = (SparklineData *)lv_obj_get_user_data(spark);
+    if (!data)
+        return;
+    data->color = color;
+    lv_obj_invalidate(spark);
+}
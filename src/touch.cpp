@@ -0,0 +1,244 @@
+#include "touch.h"
+#include "config.h"
+#include "display.h"
+#include "log_ring.h"
+#include <Arduino.h>
+#include <SPI.h>
+
+// XPT2046 control bytes: 12-bit differential conversions that keep the ADC
+// powered between samples, and a final one (PD = 00) that powers down and
+// re-enables PENIRQ
+#define XPT_Z1 0xB1
+#define XPT_Z2 0xC1
+#define XPT_X 0xD1
+#define XPT_Y 0x91
+#define XPT_POWER_DOWN 0x90
+#define XPT_SAMPLES 3
+
+// TFT_eSPI drives the display from VSPI unless USE_HSPI_PORT is set; the
+// touch controller takes the other host so a read never waits on, or
+// re-routes the pins of, a display DMA transfer
+#ifdef USE_HSPI_PORT
+static SPIClass touch_spi(VSPI);
+#else
+static SPIClass touch_spi(HSPI);
+#endif
+
+static const TouchCalibration default_calibration = {TOUCH_X_MIN, TOUCH_X_MAX, TOUCH_Y_MIN, TOUCH_Y_MAX};
+static TouchCalibration calibration = default_calibration;
+static lv_indev_t *indev = NULL;
+
+static volatile bool pen_irq = false;
+static volatile uint32_t irq_us = 0;
+
+static bool reading = false;
+static bool pressed = false;
+static uint8_t release_reads = 0;
+static lv_point_t point = {0, 0};
+static bool awaiting_response = false;
+static uint32_t delivered_us = 0;
+static uint32_t response_sum_us = 0;
+static uint32_t response_count = 0;
+static TouchStats stats;
+
+static void IRAM_ATTR pen_isr()
+{
+    if (!pen_irq)
+    {
+        irq_us = (uint32_t)esp_timer_get_time();
+        pen_irq = true;
+    }
+}
+
+static uint16_t read_channel(uint8_t command)
+{
+    touch_spi.transfer(command);
+    return touch_spi.transfer16(0) >> 3;
+}
+
+static uint16_t median3(const uint16_t *v)
+{
+    if (v[0] > v[1])
+        return v[1] > v[2] ? v[1] : (v[0] > v[2] ? v[2] : v[0]);
+    return v[0] > v[2] ? v[0] : (v[1] > v[2] ? v[2] : v[1]);
+}
+
+// Pressure first, so a light or lifting finger costs two conversions
+// instead of eight. Positions are the median of three samples, after a
+// discarded one that settles the multiplexer.
+static bool read_panel(int16_t &x, int16_t &y)
+{
+    uint16_t xs[XPT_SAMPLES];
+    uint16_t ys[XPT_SAMPLES];
+
+    touch_spi.beginTransaction(SPISettings(TOUCH_SPI_FREQUENCY, MSBFIRST, SPI_MODE0));
+    digitalWrite(TOUCH_CS, LOW);
+    int32_t z = read_channel(XPT_Z1) + 4095 - read_channel(XPT_Z2);
+    bool touched = z >= TOUCH_Z_THRESHOLD;
+    if (touched)
+    {
+        read_channel(XPT_X);
+        for (int i = 0; i < XPT_SAMPLES; i++)
+            xs[i] = read_channel(XPT_X);
+        read_channel(XPT_Y);
+        for (int i = 0; i < XPT_SAMPLES; i++)
+            ys[i] = read_channel(XPT_Y);
+    }
+    read_channel(XPT_POWER_DOWN);
+    digitalWrite(TOUCH_CS, HIGH);
+    touch_spi.endTransaction();
+    stats.spiReads++;
+
+    if (!touched)
+        return false;
+
+    // Panel axes rotated to match the display's rotation 3
+    x = 4095 - median3(ys);
+    y = median3(xs);
+    return true;
+}
+
+static lv_coord_t map_axis(int16_t raw, uint16_t from, uint16_t to, uint16_t size)
+{
+    long v = map(raw, from, to, 0, size - 1);
+    return (lv_coord_t)constrain(v, 0, size - 1);
+}
+
+static void stop_reading(lv_indev_drv_t *drv)
+{
+    reading = false;
+    pen_irq = false;
+    lv_timer_pause(drv->read_timer);
+    // A touch that started while we were reading has no edge left to catch
+    if (digitalRead(TOUCH_IRQ) == LOW)
+    {
+        irq_us = micros();
+        pen_irq = true;
+    }
+}
+
+static void touch_read(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    int16_t rawX, rawY;
+    if (read_panel(rawX, rawY))
+    {
+        lv_point_t p = {map_axis(rawX, calibration.xMin, calibration.xMax, screenWidth),
+                        map_axis(rawY, calibration.yMin, calibration.yMax, screenHeight)};
+        release_reads = 0;
+        stats.rawX = rawX;
+        stats.rawY = rawY;
+
+        if (!pressed)
+        {
+            pressed = true;
+            point = p;
+            stats.presses++;
+            stats.inputUs = micros() - irq_us;
+            if (stats.inputUs > stats.inputMaxUs)
+                stats.inputMaxUs = stats.inputUs;
+            awaiting_response = true;
+            delivered_us = micros();
+        }
+        else if (abs(p.x - point.x) > TOUCH_JITTER_PX || abs(p.y - point.y) > TOUCH_JITTER_PX)
+        {
+            point.x = (point.x + p.x) / 2;
+            point.y = (point.y + p.y) / 2;
+        }
+        data->point = point;
+        data->state = LV_INDEV_STATE_PR;
+        return;
+    }
+
+    data->point = point;
+    // A bouncing finger drops out for a read or two without lifting
+    if (pressed && ++release_reads < TOUCH_RELEASE_READS)
+    {
+        data->state = LV_INDEV_STATE_PR;
+        return;
+    }
+
+    data->state = LV_INDEV_STATE_REL;
+    pressed = false;
+    stop_reading(drv);
+}
+
+void init_touch()
+{
+    pinMode(TOUCH_CS, OUTPUT);
+    digitalWrite(TOUCH_CS, HIGH);
+    pinMode(TOUCH_IRQ, INPUT); // input-only pin, pulled up on the board
+    touch_spi.begin(TOUCH_SCLK, TOUCH_MISO, TOUCH_MOSI, TOUCH_CS);
+
+    // One conversion leaves the controller powered down with PENIRQ enabled
+    int16_t x, y;
+    read_panel(x, y);
+
+    static lv_indev_drv_t indev_drv;
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    indev_drv.read_cb = touch_read;
+    indev = lv_indev_drv_register(&indev_drv);
+    lv_timer_pause(indev_drv.read_timer);
+
+    attachInterrupt(digitalPinToInterrupt(TOUCH_IRQ), pen_isr, FALLING);
+    LOG_I(LOG_MOD_SYSTEM, "Touch initialized");
+}
+
+void touch_service()
+{
+    if (!indev)
+        return;
+
+    if (pen_irq && !reading)
+    {
+        reading = true;
+        stats.wakeups++;
+        lv_timer_t *timer = indev->driver->read_timer;
+        lv_timer_set_period(timer, TOUCH_READ_PERIOD_MS);
+        lv_timer_resume(timer);
+        lv_timer_ready(timer);
+    }
+
+    if (awaiting_response)
+    {
+        // The first refresh after LVGL saw the press is the response
+        uint32_t refreshed = display_last_refresh_us();
+        if ((int32_t)(refreshed - delivered_us) > 0)
+        {
+            uint32_t elapsed = refreshed - irq_us;
+            awaiting_response = false;
+            stats.responseUs = elapsed;
+            if (elapsed > stats.responseMaxUs)
+                stats.responseMaxUs = elapsed;
+            response_sum_us += elapsed;
+            stats.responseAvgUs = response_sum_us / ++response_count;
+        }
+        else if (micros() - irq_us > TOUCH_RESPONSE_TIMEOUT_US)
+        {
+            // The touch changed nothing on screen
+            awaiting_response = false;
+        }
+    }
+}
+
+void touch_set_calibration(const TouchCalibration &cal)
+{
+    calibration = touch_calibration_valid(cal) ? cal : default_calibration;
+}
+
+const TouchCalibration &touch_default_calibration()
+{
+    return default_calibration;
+}
+
+bool touch_calibration_valid(const TouchCalibration &cal)
+{
+    return cal.xMin <= 4095 && cal.xMax <= 4095 && cal.yMin <= 4095 && cal.yMax <= 4095 &&
+           abs((int)cal.xMax - (int)cal.xMin) >= TOUCH_MIN_SPAN &&
+           abs((int)cal.yMax - (int)cal.yMin) >= TOUCH_MIN_SPAN;
+}
+
+const TouchStats &touch_stats()
+{
+    return stats;
+}
@@ -9,81 +9,169 @@
 #include "SPIFFS.h"
 #include "FS.h"
 #include "display.h"
+#include "metrics_history.h"
+#include "mqtt_publisher.h"
+#include "device_stats.h"
+#include "loop_latency.h"
+#include "fetch_stats.h"
+#include "alloc_counter.h"
+#include "boot_profile.h"
+#include "log_ring.h"
+#include "wifi_manager.h"
+#include "glances_api.h"
+#include "fs_classifier.h"
+#include "net_meter.h"
+#include "sensor_map.h"
+#include "core_heatmap.h"
+#include "touch.h"
+#include "alert_engine.h"
+#include "container_top.h"
+#include "process_top.h"
+#include "gui.h"
+#include <math.h>
+#include <stdarg.h>
 
 #define TFT_BL 27
 #define TFT_BACKLIGHT_ON HIGH
 
-extern const ThemeColors dark_theme;
-extern const ThemeColors light_theme;
-static unsigned long last_micros = 0;
-static float cpu_usage = 0;
-static const int SAMPLE_COUNT = 10;
-static unsigned long samples[SAMPLE_COUNT] = {0};
-static int sample_index = 0;
+WebServer server(80);
 
-void updateCPUUsage()
+void updateDeviceHistory()
 {
-    unsigned long current_micros = esp_timer_get_time();
+    static unsigned long lastSample = 0;
+    if (lastSample != 0 && millis() - lastSample < HISTORY_HIRES_STEP_MS)
+    {
+        return;
+    }
+    lastSample = millis();
 
-    if (last_micros > 0)
+    uint64_t now = esp_timer_get_time() / 1000;
+    uint32_t total_heap = ESP.getHeapSize();
+    MetricsHistory::record(METRIC_DEVICE_CPU, DeviceStats::totalUsage(), now);
+    MetricsHistory::record(METRIC_DEVICE_HEAP, (total_heap - ESP.getFreeHeap()) * 100.0f / total_heap, now);
+    MetricsHistory::record(METRIC_DEVICE_TEMP, (temperatureRead() - 32) / 1.8, now);
+    if (WiFi.status() == WL_CONNECTED)
+    {
+        MetricsHistory::record(METRIC_DEVICE_RSSI, WiFi.RSSI(), now);
+    }
+}
+
+// Writes text into out as the contents of a JSON string, escaping quotes,
+// backslashes and control characters. Cut to fit, never mid-escape.
+static const char *jsonEscape(const char *text, char *out, size_t size)
+{
+    size_t len = 0;
+    for (const char *c = text; *c && len + 7 < size; c++)
     {
-        unsigned long delta = current_micros - last_micros;
-        samples[sample_index] = delta;
-        sample_index = (sample_index + 1) % SAMPLE_COUNT;
-        unsigned long sum = 0;
-        unsigned long max_sample = 0;
-        for (int i = 0; i < SAMPLE_COUNT; i++)
+        if (*c == '"' || *c == '\\')
         {
-            sum += samples[i];
-            if (samples[i] > max_sample)
-                max_sample = samples[i];
+            out[len++] = '\\';
+            out[len++] = *c;
         }
-        unsigned long avg = sum / SAMPLE_COUNT;
-        float usage = (float)avg / max_sample * 100.0;
-        cpu_usage = (cpu_usage * 0.8) + (usage * 0.2);
-        if (cpu_usage < 0)
-            cpu_usage = 0;
-        if (cpu_usage > 100)
-            cpu_usage = 100;
+        else if ((uint8_t)*c < 0x20)
+            len += snprintf(out + len, size - len, "\\u%04x", *c);
+        else
+            out[len++] = *c;
     }
-
-    last_micros = current_micros;
+    out[len] = '\0';
+    return out;
 }
 
-WebServer server(80);
+// Buffers small writes and sends them as chunks of a chunked HTTP response,
+// so large JSON bodies never need to be assembled in one String.
+class ChunkedResponse
+{
+public:
+    void begin(int code, const char *contentType)
+    {
+        len = 0;
+        server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server.send(code, contentType, "");
+    }
+
+    void printf(const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf + len, sizeof(buf) - len, format, args);
+        va_end(args);
+        if (n < 0)
+            return;
+        if ((size_t)n >= sizeof(buf) - len)
+        {
+            flush();
+            va_start(args, format);
+            n = vsnprintf(buf, sizeof(buf), format, args);
+            va_end(args);
+            if (n < 0)
+                return;
+            if ((size_t)n >= sizeof(buf))
+                n = sizeof(buf) - 1;
+        }
+        len += n;
+    }
+
+    void value(float v)
+    {
+        if (isnan(v))
+            printf("null");
+        else
+            printf("%.1f", v);
+    }
+
+    void flush()
+    {
+        if (len > 0)
+        {
+            server.sendContent(buf, len);
+            len = 0;
+        }
+    }
+
+    void end()
+    {
+        flush();
+        server.sendContent("");
+    }
+
+private:
+    char buf[512];
+    size_t len = 0;
+};
 
 void handleRoot()
 {
-    Serial.println("Handling root request");
-    File root = SPIFFS.open("/");
-    File file = root.openNextFile();
-    Serial.println("Files in SPIFFS:");
-    while (file)
+    LOG_D(LOG_MOD_WEB, "Handling root request");
+    if (LogRing::enabled(LOG_LEVEL_DEBUG, LOG_MOD_WEB))
     {
-        Serial.print("  ");
-        Serial.println(file.name());
-        file = root.openNextFile();
+        File root = SPIFFS.open("/");
+        File file = root.openNextFile();
+        while (file)
+        {
+            LOG_D(LOG_MOD_WEB, "  SPIFFS file %s", file.name());
+            file = root.openNextFile();
+        }
     }
 
     File htmlFile = SPIFFS.open("/index.html", "r");
     if (!htmlFile)
     {
-        Serial.println("Failed to open /index.html");
+        LOG_E(LOG_MOD_WEB, "Failed to open /index.html");
         server.send(500, "text/plain", "Failed to load HTML file");
         return;
     }
 
-    Serial.printf("File size: %d bytes\n", htmlFile.size());
+    LOG_D(LOG_MOD_WEB, "index.html: %u bytes", (unsigned)htmlFile.size());
     server.streamFile(htmlFile, "text/html");
     htmlFile.close();
 }
 
 void handleGetSettings()
 {
-    StaticJsonDocument<1024> doc;
+    // Heap allocated: this has outgrown what the loop task's stack can spare
+    DynamicJsonDocument doc(3072);
 
-    updateCPUUsage();
-    doc["cpuUsage"] = (int)cpu_usage;
+    doc["cpuUsage"] = (int)DeviceStats::totalUsage();
     doc["wifiStrength"] = WiFi.RSSI();
     doc["chipModel"] = ESP.getChipModel();
     doc["chipRevision"] = ESP.getChipRevision();
@@ -176,69 +264,284 @@ void handleGetSettings()
     doc["glances_host"] = SettingsManager::getGlancesHost();
     doc["glances_port"] = SettingsManager::getGlancesPort();
     doc["debug_mode"] = debug_mode;
+    doc["settingsLoadUs"] = SettingsManager::getLoadTimeUs();
+    doc["mqtt_host"] = SettingsManager::getMqttHost();
+    doc["mqtt_port"] = SettingsManager::getMqttPort();
+    doc["mqtt_user"] = SettingsManager::getMqttUser();
+    doc["mqtt_topic"] = SettingsManager::getMqttTopic();
+    doc["mqtt_connected"] = MqttPublisher::isConnected();
+    doc["fs_rules"] = SettingsManager::getFsRules()[0] ? SettingsManager::getFsRules() : FsClassifier::defaultRules();
+    doc["net_interfaces"] = SettingsManager::getNetInterfaces()[0] ? SettingsManager::getNetInterfaces()
+                                                                   : NetMeter::defaultPatterns();
+    doc["net_mode"] = NetMeter::modeName((NetMode)SettingsManager::getNetMode());
+    doc["sensor_map"] = SettingsManager::getSensorMap()[0] ? SettingsManager::getSensorMap() : SensorMap::defaultMap();
+    doc["alert_rules"] = SettingsManager::getAlertRules()[0] ? SettingsManager::getAlertRules()
+                                                             : AlertEngine::defaultRules();
+    doc["alert_webhook"] = SettingsManager::getAlertWebhook();
+    const TouchCalibration &touch = SettingsManager::getTouchCalibration();
+    JsonObject calibration = doc.createNestedObject("touch_calibration");
+    calibration["x_min"] = touch.xMin;
+    calibration["x_max"] = touch.xMax;
+    calibration["y_min"] = touch.yMin;
+    calibration["y_max"] = touch.yMax;
+    JsonArray sensors = doc.createNestedArray("sensors");
+    for (size_t i = 0; i < SensorMap::slotCount(); i++)
+    {
+        const SensorReading &reading = SensorMap::reading(i);
+        if (!reading.present)
+            continue;
+        JsonObject sensor = sensors.createNestedObject();
+        sensor["name"] = SensorMap::slot(i).name;
+        sensor["label"] = reading.label;
+        sensor["value"] = reading.value;
+        sensor["min"] = reading.min;
+        sensor["max"] = reading.max;
+        sensor["level"] = reading.level;
+    }
+    const NetRates &net = NetMeter::rates();
+    if (net.valid)
+    {
+        JsonObject network = doc.createNestedObject("network");
+        network["interface"] = net.name;
+        network["rx"] = net.rxRate;
+        network["tx"] = net.txRate;
+        network["rx_peak"] = net.rxPeak;
+        network["tx_peak"] = net.txPeak;
+    }
 
     String response;
     serializeJson(doc, response);
     server.send(200, "application/json", response);
 }
 
-void handleUpdateSettings()
+static void sendSettingsError(const char *message)
 {
-    String json = server.arg("plain");
-    StaticJsonDocument<512> doc;
-    DeserializationError error = deserializeJson(doc, json);
+    StaticJsonDocument<128> response;
+    response["status"] = "error";
+    response["message"] = message;
+    String responseStr;
+    serializeJson(response, responseStr);
+    server.send(400, "application/json", responseStr);
+}
 
-    if (!error)
+// Checks every field of a settings update before any is applied, so a bad
+// field rejects the whole request. Fills error and returns false on the
+// first invalid field.
+static bool validateSettings(JsonDocument &doc, char *error, size_t errorSize)
+{
+    if (doc.containsKey("fs_rules"))
     {
-        if (doc.containsKey("darkMode"))
+        const char *rules = doc["fs_rules"] | "";
+        if (strlen(rules) >= FS_RULES_MAX_LENGTH)
         {
-            SettingsManager::setDarkMode(doc["darkMode"].as<bool>());
+            snprintf(error, errorSize, "rules longer than %d characters", FS_RULES_MAX_LENGTH - 1);
+            return false;
         }
-        if (doc.containsKey("bg_color"))
-        {
-            uint32_t color = doc["bg_color"].as<uint32_t>();
-            Serial.printf("Updating bg_color to: %06X\n", color);
-            SettingsManager::updateThemeColor("bg_color", color);
-        }
-        if (doc.containsKey("text_color"))
-        {
-            SettingsManager::updateThemeColor("text_color", doc["text_color"].as<uint32_t>());
-        }
-        if (doc.containsKey("cpu_color"))
-        {
-            SettingsManager::updateThemeColor("cpu_color", doc["cpu_color"].as<uint32_t>());
-        }
-        if (doc.containsKey("ram_color"))
+        if (!FsClassifier::validate(rules, error, errorSize))
+            return false;
+    }
+    if (doc.containsKey("net_interfaces") || doc.containsKey("net_mode"))
+    {
+        const char *patterns = doc["net_interfaces"] | SettingsManager::getNetInterfaces();
+        NetMode mode;
+        if (doc.containsKey("net_mode") && !NetMeter::parseMode(doc["net_mode"], mode))
         {
-            SettingsManager::updateThemeColor("ram_color", doc["ram_color"].as<uint32_t>());
+            snprintf(error, errorSize, "net_mode must be first or sum");
+            return false;
         }
-        if (doc.containsKey("border_color"))
+        if (strlen(patterns) >= NET_INTERFACES_MAX_LENGTH)
         {
-            SettingsManager::updateThemeColor("border_color", doc["border_color"].as<uint32_t>());
+            snprintf(error, errorSize, "interfaces longer than %d characters", NET_INTERFACES_MAX_LENGTH - 1);
+            return false;
         }
-        if (doc.containsKey("card_bg_color"))
+        if (!NetMeter::validate(patterns, error, errorSize))
+            return false;
+    }
+    if (doc.containsKey("sensor_map"))
+    {
+        const char *map = doc["sensor_map"] | "";
+        if (strlen(map) >= SENSOR_MAP_MAX_LENGTH)
         {
-            SettingsManager::updateThemeColor("card_bg_color", doc["card_bg_color"].as<uint32_t>());
+            snprintf(error, errorSize, "sensor map longer than %d characters", SENSOR_MAP_MAX_LENGTH - 1);
+            return false;
         }
-        if (doc.containsKey("glances_host"))
+        if (!SensorMap::validate(map, error, errorSize))
+            return false;
+    }
+    if (doc.containsKey("alert_rules"))
+    {
+        const char *rules = doc["alert_rules"] | "";
+        if (strlen(rules) >= ALERT_RULES_MAX_LENGTH)
         {
-            SettingsManager::setGlancesHost(doc["glances_host"].as<String>());
+            snprintf(error, errorSize, "alert rules longer than %d characters", ALERT_RULES_MAX_LENGTH - 1);
+            return false;
         }
-        if (doc.containsKey("glances_port"))
+        if (!AlertEngine::validate(rules, error, errorSize))
+            return false;
+    }
+    if (doc.containsKey("alert_webhook"))
+    {
+        const char *url = doc["alert_webhook"] | "";
+        if (strlen(url) >= ALERT_WEBHOOK_MAX_LENGTH || (url[0] && strncmp(url, "http://", 7) != 0))
         {
-            SettingsManager::setGlancesPort(doc["glances_port"].as<uint16_t>());
+            snprintf(error, errorSize, "alert_webhook must be an http:// URL under 96 characters");
+            return false;
         }
-        if (doc.containsKey("debug_mode"))
+    }
+    if (doc.containsKey("touch_calibration"))
+    {
+        JsonObject cal = doc["touch_calibration"];
+        TouchCalibration touch = SettingsManager::getTouchCalibration();
+        touch.xMin = cal["x_min"] | touch.xMin;
+        touch.xMax = cal["x_max"] | touch.xMax;
+        touch.yMin = cal["y_min"] | touch.yMin;
+        touch.yMax = cal["y_max"] | touch.yMax;
+        if (!touch_calibration_valid(touch))
         {
-            debug_mode = doc["debug_mode"].as<bool>();
-            Serial.printf("Debug mode %s\n", debug_mode ? "enabled" : "disabled");
+            snprintf(error, errorSize, "touch_calibration values must be 0-4095, at least 1000 apart");
+            return false;
         }
-        server.send(200, "application/json", "{\"status\":\"success\"}");
     }
-    else
+    return true;
+}
+
+void handleUpdateSettings()
+{
+    String json = server.arg("plain");
+    StaticJsonDocument<768> doc;
+    DeserializationError error = deserializeJson(doc, json);
+
+    if (error)
     {
         server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
+        return;
+    }
+
+    char settingsError[64];
+    if (!validateSettings(doc, settingsError, sizeof(settingsError)))
+    {
+        sendSettingsError(settingsError);
+        return;
+    }
+
+    // Everything below has been validated and cannot fail. The record is
+    // saved and the theme applied once, in commit().
+    char compileError[64];
+    SettingsManager::beginUpdate();
+    if (doc.containsKey("darkMode"))
+    {
+        SettingsManager::setDarkMode(doc["darkMode"].as<bool>());
+    }
+    if (doc.containsKey("bg_color"))
+    {
+        uint32_t color = doc["bg_color"].as<uint32_t>();
+        LOG_I(LOG_MOD_WEB, "Updating bg_color to: %06X", color);
+        SettingsManager::updateThemeColor("bg_color", color);
+    }
+    if (doc.containsKey("text_color"))
+    {
+        SettingsManager::updateThemeColor("text_color", doc["text_color"].as<uint32_t>());
+    }
+    if (doc.containsKey("cpu_color"))
+    {
+        SettingsManager::updateThemeColor("cpu_color", doc["cpu_color"].as<uint32_t>());
+    }
+    if (doc.containsKey("ram_color"))
+    {
+        SettingsManager::updateThemeColor("ram_color", doc["ram_color"].as<uint32_t>());
+    }
+    if (doc.containsKey("border_color"))
+    {
+        SettingsManager::updateThemeColor("border_color", doc["border_color"].as<uint32_t>());
+    }
+    if (doc.containsKey("card_bg_color"))
+    {
+        SettingsManager::updateThemeColor("card_bg_color", doc["card_bg_color"].as<uint32_t>());
+    }
+    if (doc.containsKey("glances_host"))
+    {
+        SettingsManager::setGlancesHost(doc["glances_host"].as<String>());
+    }
+    if (doc.containsKey("glances_port"))
+    {
+        SettingsManager::setGlancesPort(doc["glances_port"].as<uint16_t>());
+    }
+    if (doc.containsKey("fs_rules"))
+    {
+        String rules = doc["fs_rules"].as<String>();
+        FsClassifier::compile(rules.c_str(), compileError, sizeof(compileError));
+        SettingsManager::setFsRules(rules);
+    }
+    if (doc.containsKey("net_interfaces") || doc.containsKey("net_mode"))
+    {
+        String patterns = doc["net_interfaces"] | SettingsManager::getNetInterfaces();
+        NetMode mode = (NetMode)SettingsManager::getNetMode();
+        if (doc.containsKey("net_mode"))
+            NetMeter::parseMode(doc["net_mode"], mode);
+        NetMeter::compile(patterns.c_str(), mode, compileError, sizeof(compileError));
+        SettingsManager::setNetInterfaces(patterns, mode);
+    }
+    if (doc.containsKey("sensor_map"))
+    {
+        String map = doc["sensor_map"].as<String>();
+        SensorMap::compile(map.c_str(), compileError, sizeof(compileError));
+        SettingsManager::setSensorMap(map);
+    }
+    if (doc.containsKey("alert_rules"))
+    {
+        String rules = doc["alert_rules"].as<String>();
+        AlertEngine::compile(rules.c_str(), compileError, sizeof(compileError));
+        SettingsManager::setAlertRules(rules);
+    }
+    if (doc.containsKey("alert_webhook"))
+    {
+        SettingsManager::setAlertWebhook(doc["alert_webhook"].as<String>());
     }
+    if (doc.containsKey("touch_calibration"))
+    {
+        JsonObject cal = doc["touch_calibration"];
+        TouchCalibration touch = SettingsManager::getTouchCalibration();
+        touch.xMin = cal["x_min"] | touch.xMin;
+        touch.xMax = cal["x_max"] | touch.xMax;
+        touch.yMin = cal["y_min"] | touch.yMin;
+        touch.yMax = cal["y_max"] | touch.yMax;
+        SettingsManager::setTouchCalibration(touch);
+        touch_set_calibration(touch);
+    }
+    bool mqttChanged = false;
+    if (doc.containsKey("mqtt_host"))
+    {
+        SettingsManager::setMqttHost(doc["mqtt_host"].as<String>());
+        mqttChanged = true;
+    }
+    if (doc.containsKey("mqtt_port"))
+    {
+        SettingsManager::setMqttPort(doc["mqtt_port"].as<uint16_t>());
+        mqttChanged = true;
+    }
+    if (doc.containsKey("mqtt_user") || doc.containsKey("mqtt_password"))
+    {
+        SettingsManager::setMqttCredentials(doc["mqtt_user"] | SettingsManager::getMqttUser(),
+                                            doc["mqtt_password"] | SettingsManager::getMqttPassword());
+        mqttChanged = true;
+    }
+    if (doc.containsKey("mqtt_topic"))
+    {
+        SettingsManager::setMqttTopic(doc["mqtt_topic"].as<String>());
+        mqttChanged = true;
+    }
+    SettingsManager::commit();
+    if (mqttChanged)
+    {
+        MqttPublisher::reconfigure();
+    }
+    if (doc.containsKey("debug_mode"))
+    {
+        debug_mode = doc["debug_mode"].as<bool>();
+        LogRing::setAllLevels(debug_mode ? LOG_LEVEL_DEBUG : LOG_LEVEL_INFO);
+        LOG_I(LOG_MOD_WEB, "Debug mode %s", debug_mode ? "enabled" : "disabled");
+    }
+    server.send(200, "application/json", "{\"status\":\"success\"}");
 }
 
 void handleRestart()
@@ -250,19 +553,7 @@ void handleRestart()
 
 void handleResetTheme()
 {
-    if (SettingsManager::getDarkMode())
-    {
-        const_cast<ThemeColors &>(SettingsManager::getCurrentTheme()) = dark_theme;
-    }
-    else
-    {
-        const_cast<ThemeColors &>(SettingsManager::getCurrentTheme()) = light_theme;
-    }
-    SettingsManager::clearSavedColors();
-    if (SettingsManager::themeCallback)
-    {
-        SettingsManager::themeCallback(SettingsManager::getDarkMode());
-    }
+    SettingsManager::resetCurrentTheme();
 
     server.send(200, "application/json", "{\"status\":\"success\"}");
 }
@@ -307,6 +598,7 @@ void handleHaCommand()
     if (doc.containsKey("dark_mode"))
     {
         SettingsManager::setDarkMode(doc["dark_mode"].as<bool>());
+        MqttPublisher::requestPublish();
         success = true;
         message = "Dark mode updated";
     }
@@ -314,6 +606,7 @@ void handleHaCommand()
     if (doc.containsKey("display"))
     {
         display_sleep(!doc["display"].as<bool>());
+        MqttPublisher::requestPublish();
         success = true;
         message = "Display state updated";
     }
@@ -331,23 +624,65 @@ void handleHaCommand()
         }
     }
 
+    if (doc.containsKey("page"))
+    {
+        GuiPage page;
+        if (gui_find_page(doc["page"] | "", page))
+        {
+            gui_show_page(page);
+            success = true;
+            message = "Page changed";
+        }
+        else
+        {
+            message = "Unknown page";
+        }
+    }
+
+    if (doc.containsKey("process_sort"))
+    {
+        ProcessSort sort;
+        if (ProcessTop::parseSort(doc["process_sort"], sort))
+        {
+            ProcessTop::setSort(sort);
+            gui_refresh();
+            success = true;
+            message = "Process sort updated";
+        }
+        else
+        {
+            message = "process_sort must be cpu or mem";
+        }
+    }
+
+    if (doc.containsKey("container_sort"))
+    {
+        ProcessSort sort;
+        if (ProcessTop::parseSort(doc["container_sort"], sort))
+        {
+            ContainerTop::setSort(sort);
+            gui_refresh();
+            success = true;
+            message = "Container sort updated";
+        }
+        else
+        {
+            message = "container_sort must be cpu or mem";
+        }
+    }
+
+    if (doc.containsKey("reset_sensor_extremes"))
+    {
+        SensorMap::resetExtremes();
+        success = true;
+        message = "Sensor min/max reset";
+    }
+
     if (doc.containsKey("reset_theme"))
     {
         if (doc["reset_theme"].as<bool>())
         {
-            if (SettingsManager::getDarkMode())
-            {
-                const_cast<ThemeColors &>(SettingsManager::getCurrentTheme()) = dark_theme;
-            }
-            else
-            {
-                const_cast<ThemeColors &>(SettingsManager::getCurrentTheme()) = light_theme;
-            }
-            SettingsManager::clearSavedColors();
-            if (SettingsManager::themeCallback)
-            {
-                SettingsManager::themeCallback(SettingsManager::getDarkMode());
-            }
+            SettingsManager::resetCurrentTheme();
             success = true;
             message = "Theme reset to defaults";
         }
@@ -392,6 +727,373 @@ void handleDisplaySleep()
     }
 }
 
+void handleHistory()
+{
+    MetricId metric;
+    if (!server.hasArg("metric") || !MetricsHistory::findMetric(server.arg("metric").c_str(), metric))
+    {
+        server.send(400, "application/json", "{\"error\":\"Unknown metric\"}");
+        return;
+    }
+
+    uint64_t since = server.hasArg("since") ? strtoull(server.arg("since").c_str(), nullptr, 10) : 0;
+    String res = server.hasArg("res") ? server.arg("res") : "";
+    bool withHires = res.length() == 0 || res == "hires";
+    bool withBuckets = res.length() == 0 || res == "buckets";
+
+    static float hires[HISTORY_HIRES_SAMPLES];
+    static HistoryBucket buckets[HISTORY_BUCKETS];
+    uint64_t start;
+
+    ChunkedResponse out;
+    out.begin(200, "application/json");
+    out.printf("{\"metric\":\"%s\",\"now\":%llu", MetricsHistory::metricName(metric),
+               (unsigned long long)(esp_timer_get_time() / 1000));
+
+    if (withHires)
+    {
+        size_t count = MetricsHistory::copyHires(metric, since, start, hires, HISTORY_HIRES_SAMPLES);
+        out.printf(",\"hires\":{\"start\":%llu,\"step\":%lu,\"v\":[", (unsigned long long)start, HISTORY_HIRES_STEP_MS);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i)
+                out.printf(",");
+            out.value(hires[i]);
+        }
+        out.printf("]}");
+    }
+
+    if (withBuckets)
+    {
+        size_t count = MetricsHistory::copyBuckets(metric, since, start, buckets, HISTORY_BUCKETS);
+        out.printf(",\"buckets\":{\"start\":%llu,\"step\":%lu", (unsigned long long)start, HISTORY_BUCKET_STEP_MS);
+        const char *columns[] = {"min", "avg", "max"};
+        for (int c = 0; c < 3; c++)
+        {
+            out.printf(",\"%s\":[", columns[c]);
+            for (size_t i = 0; i < count; i++)
+            {
+                if (i)
+                    out.printf(",");
+                out.value(c == 0 ? buckets[i].min : c == 1 ? buckets[i].avg : buckets[i].max);
+            }
+            out.printf("]");
+        }
+        out.printf("}");
+    }
+
+    out.printf("}");
+    out.end();
+}
+
+void handleTelemetry()
+{
+    ChunkedResponse out;
+    out.begin(200, "application/json");
+
+    out.printf("{\"uptime\":%lu,\"runTimeStats\":%s,\"cores\":[", millis() / 1000,
+               DeviceStats::hasRunTimeStats() ? "true" : "false");
+    for (int c = 0; c < portNUM_PROCESSORS; c++)
+    {
+        out.printf(c ? ",%.1f" : "%.1f", DeviceStats::coreUsage(c));
+    }
+
+    out.printf("],\"loop\":{");
+    for (int s = 0; s < STAGE_COUNT; s++)
+    {
+        out.printf(s ? ",\"%s\":%.1f" : "\"%s\":%.1f", DeviceStats::stageName((LoopStage)s),
+                   DeviceStats::stageShare((LoopStage)s));
+    }
+
+    out.printf("},\"tasks\":[");
+    for (size_t i = 0; i < DeviceStats::taskCount(); i++)
+    {
+        const TaskStat &task = DeviceStats::task(i);
+        out.printf("%s{\"name\":\"%s\",\"cpu\":", i ? "," : "", task.name);
+        if (task.cpuPercent < 0)
+            out.printf("null");
+        else
+            out.printf("%.1f", task.cpuPercent);
+        out.printf(",\"stack\":%u,\"core\":%d,\"priority\":%u}", task.stackHighWater, task.core, task.priority);
+    }
+
+    out.printf("],\"boot\":{");
+    for (int p = 0; p < BOOT_PHASE_COUNT; p++)
+    {
+        const char *name = BootProfile::phaseName((BootPhase)p);
+        if (BootProfile::reached((BootPhase)p))
+            out.printf(p ? ",\"%s\":%u" : "\"%s\":%u", name, BootProfile::phaseMs((BootPhase)p));
+        else
+            out.printf(p ? ",\"%s\":null" : "\"%s\":null", name);
+    }
+
+    const WifiStats &wifi = WifiManager::stats();
+    out.printf("},\"wifi\":{\"state\":\"%s\",\"connects\":%u,\"disconnects\":%u,\"attempts\":%u,"
+               "\"lastReason\":%u,\"reconnectMs\":%u,\"reconnectMaxMs\":%u,\"connectedForMs\":%ld,"
+               "\"rssi\":%d,\"rssiMin\":%d,\"rssiMax\":%d",
+               WifiManager::stateName(wifi.state), wifi.connects, wifi.disconnects, wifi.attempts, wifi.lastReason,
+               wifi.lastReconnectMs, wifi.maxReconnectMs,
+               WifiManager::connected() ? (long)(millis() - wifi.connectedMs) : -1L, wifi.rssi, wifi.rssiMin,
+               wifi.rssiMax);
+
+    out.printf("},\"heap\":{\"free\":%u,\"min\":%u,\"maxAlloc\":%u}",
+               ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap());
+
+    // LVGL's own pool, see LV_MEM_SIZE in lv_conf.h
+    lv_mem_monitor_t lvgl;
+    lv_mem_monitor(&lvgl);
+    out.printf(",\"lvgl\":{\"size\":%u,\"used\":%u,\"free\":%u,\"biggest\":%u,\"maxUsed\":%u,\"usedPct\":%u,"
+               "\"fragPct\":%u}",
+               lvgl.total_size, lvgl.total_size - lvgl.free_size, lvgl.free_size, lvgl.free_biggest_size,
+               lvgl.max_used, lvgl.used_pct, lvgl.frag_pct);
+
+    out.printf(",\"glances\":{\"cycles\":%u,\"failed\":%u,\"cycleMs\":%u,\"cycleMaxMs\":%u,\"lastOk\":%s,"
+               "\"okAgeMs\":%ld",
+               glances_cycle.cycles, glances_cycle.failedCycles, glances_cycle.lastCycleMs, glances_cycle.maxCycleMs,
+               glances_cycle.lastOk ? "true" : "false",
+               glances_cycle.lastOkMs ? (long)(millis() - glances_cycle.lastOkMs) : -1L);
+    if (AllocCounter::enabled())
+        out.printf(",\"allocs\":%u,\"allocsMax\":%u}", glances_cycle.lastAllocs, glances_cycle.maxAllocs);
+    else
+        out.printf(",\"allocs\":null,\"allocsMax\":null}");
+
+    const HeatmapStats &heatmap = core_heatmap_stats();
+    out.printf(",\"heatmap\":{\"cores\":%u,\"changedCells\":%u,\"updateUs\":%u,\"drawUs\":%u}",
+               heatmap.cores, heatmap.changedCells, heatmap.updateUs, heatmap.drawUs);
+
+    const TouchStats &touch = touch_stats();
+    out.printf(",\"touch\":{\"presses\":%u,\"wakeups\":%u,\"spiReads\":%u,\"rawX\":%d,\"rawY\":%d,"
+               "\"inputUs\":%u,\"inputMaxUs\":%u,\"responseUs\":%u,\"responseAvgUs\":%u,\"responseMaxUs\":%u}}",
+               touch.presses, touch.wakeups, touch.spiReads, touch.rawX, touch.rawY, touch.inputUs,
+               touch.inputMaxUs, touch.responseUs, touch.responseAvgUs, touch.responseMaxUs);
+    out.end();
+}
+
+void handleAlertStatus()
+{
+    ChunkedResponse out;
+    out.begin(200, "application/json");
+    out.printf("{\"active\":%u,\"evaluations\":%u,\"dropped\":%u,\"rules\":[", AlertEngine::activeCount(),
+               AlertEngine::evalCount(), AlertEngine::droppedEvents());
+    for (size_t i = 0; i < AlertEngine::ruleCount(); i++)
+    {
+        const AlertRule &rule = AlertEngine::rule(i);
+        const AlertState &state = AlertEngine::state(i);
+        out.printf("%s{\"name\":\"%s\",\"metric\":\"%s\",\"rate\":%s,\"above\":%s,\"limit\":%g,\"clear\":%g,"
+                   "\"forMs\":%u,\"actions\":%u,\"state\":\"%s\",\"value\":%g,\"sinceMs\":%llu,\"fired\":%u}",
+                   i ? "," : "", rule.name, MetricsHistory::metricName(rule.metric), rule.rate ? "true" : "false",
+                   rule.above ? "true" : "false", rule.limit, rule.clear, rule.forMs, rule.actions,
+                   state.active ? "firing" : state.pending ? "pending" : "ok", state.value,
+                   (unsigned long long)state.sinceMs, state.fireCount);
+    }
+    out.printf("]}");
+    out.end();
+}
+
+void handleContainers()
+{
+    const ContainerSummary &summary = ContainerTop::summary();
+    ChunkedResponse out;
+    out.begin(200, "application/json");
+    out.printf("{\"sort\":\"%s\",\"total\":%u,\"running\":%u,\"restarting\":%u,\"unhealthy\":%u,"
+               "\"parseUs\":%u,\"top\":[",
+               ProcessTop::sortName(ContainerTop::sort()), summary.total, summary.running, summary.restarting,
+               summary.unhealthy, ContainerTop::parseUs());
+    for (size_t i = 0; i < ContainerTop::count(); i++)
+    {
+        const ContainerEntry &container = ContainerTop::entry(i);
+        char name[CONTAINER_NAME_LENGTH * 6];
+        out.printf("%s{\"name\":\"%s\",\"state\":\"%s\",\"cpu\":%.1f,\"memMb\":%.1f}", i ? "," : "",
+                   jsonEscape(container.name, name, sizeof(name)), ContainerTop::stateName(container.state),
+                   container.cpu, container.memMb);
+    }
+    out.printf("]}");
+    out.end();
+}
+
+void handleProcesses()
+{
+    ChunkedResponse out;
+    out.begin(200, "application/json");
+    out.printf("{\"sort\":\"%s\",\"processes\":%u,\"parseUs\":%u,\"top\":[",
+               ProcessTop::sortName(ProcessTop::sort()), ProcessTop::processCount(), ProcessTop::parseUs());
+    for (size_t i = 0; i < ProcessTop::count(); i++)
+    {
+        const ProcessEntry &process = ProcessTop::entry(i);
+        char name[PROCESS_NAME_LENGTH * 6];
+        out.printf("%s{\"name\":\"%s\",\"pid\":%u,\"cpu\":%.1f,\"mem\":%.1f}", i ? "," : "",
+                   jsonEscape(process.name, name, sizeof(name)), process.pid, process.cpu, process.mem);
+    }
+    out.printf("]}");
+    out.end();
+}
+
+void handleFetchStats()
+{
+    if (server.method() == HTTP_DELETE)
+    {
+        FetchStats::reset();
+        server.send(200, "application/json", "{\"status\":\"success\"}");
+        return;
+    }
+
+    ChunkedResponse out;
+    out.begin(200, "application/json");
+
+    out.printf("{\"buckets_us\":[");
+    for (size_t b = 0; b + 1 < FETCH_HIST_BUCKETS; b++)
+    {
+        out.printf(b ? ",%u" : "%u", FetchStats::bucketLimitUs(b));
+    }
+    out.printf("],\"endpoints\":[");
+
+    for (size_t i = 0; i < FetchStats::endpointCount(); i++)
+    {
+        const EndpointStats &stats = FetchStats::endpoint(i);
+        out.printf("%s{\"endpoint\":\"%s\",\"count\":%u,\"bytes_avg\":%u,\"errors\":{", i ? "," : "",
+                   stats.endpoint, stats.count, stats.count ? (uint32_t)(stats.bytesTotal / stats.count) : 0);
+        for (int e = 0; e < FETCH_ERR_COUNT; e++)
+        {
+            out.printf(e ? ",\"%s\":%u" : "\"%s\":%u", FetchStats::errorName((FetchError)e), stats.errors[e]);
+        }
+        out.printf("},\"phases\":{");
+        for (int p = 0; p < PHASE_COUNT; p++)
+        {
+            out.printf("%s\"%s\":{\"avg_us\":%u,\"max_us\":%u,\"last_us\":%u,\"hist\":[", p ? "," : "",
+                       FetchStats::phaseName((FetchPhase)p),
+                       stats.count ? (uint32_t)(stats.phaseSumUs[p] / stats.count) : 0,
+                       stats.phaseMaxUs[p], stats.last.phaseUs[p]);
+            for (int b = 0; b < FETCH_HIST_BUCKETS; b++)
+            {
+                out.printf(b ? ",%u" : "%u", stats.histogram[p][b]);
+            }
+            out.printf("]}");
+        }
+        out.printf("}}");
+    }
+
+    out.printf("]}");
+    out.end();
+}
+
+static void printLatency(ChunkedResponse &out, const LatencyHistogram &histogram)
+{
+    out.printf("\"count\":%u,\"avg_us\":%u,\"p50_us\":%u,\"p99_us\":%u,\"max_us\":%u,\"last_us\":%u",
+               histogram.count, histogram.count ? (uint32_t)(histogram.sumUs / histogram.count) : 0,
+               LoopLatency::quantileUs(histogram, 0.5f), LoopLatency::quantileUs(histogram, 0.99f),
+               histogram.maxUs, histogram.lastUs);
+}
+
+void handleLoopLatency()
+{
+    if (server.method() == HTTP_DELETE)
+    {
+        LoopLatency::reset();
+        server.send(200, "application/json", "{\"status\":\"success\"}");
+        return;
+    }
+
+    ChunkedResponse out;
+    out.begin(200, "application/json");
+
+    out.printf("{\"watchdog\":{\"active\":%s,\"timeout_s\":%d,\"last_reset\":\"%s\"},\"loop\":{",
+               LoopLatency::watchdogActive() ? "true" : "false", LOOP_WDT_TIMEOUT_S, LoopLatency::resetReason());
+    printLatency(out, LoopLatency::iteration());
+    out.printf("},\"stages\":{");
+    for (int s = 0; s < STAGE_COUNT; s++)
+    {
+        out.printf(s ? ",\"%s\":{" : "\"%s\":{", DeviceStats::stageName((LoopStage)s));
+        printLatency(out, LoopLatency::stage((LoopStage)s));
+        out.printf(",\"budget_us\":%u,\"overruns\":%u}", LoopLatency::budgetUs((LoopStage)s),
+                   LoopLatency::overruns((LoopStage)s));
+    }
+    out.printf("},\"stalls\":[");
+    for (size_t i = 0; i < LoopLatency::stallCount(); i++)
+    {
+        const LoopStall &stall = LoopLatency::stall(i);
+        out.printf("%s{\"at_ms\":%u,\"stage\":\"%s\",\"us\":%u}", i ? "," : "", stall.atMs,
+                   DeviceStats::stageName(stall.stage), stall.us);
+    }
+    out.printf("]}");
+    out.end();
+}
+
+// Entries after since, oldest first, optionally only those at or above a
+// level and from one module. POST {"levels":{"glances":"debug"}} changes the
+// module filters; "all" sets every module.
+void handleLogs()
+{
+    if (server.method() == HTTP_POST)
+    {
+        StaticJsonDocument<256> doc;
+        if (deserializeJson(doc, server.arg("plain")) || !doc["levels"].is<JsonObject>())
+        {
+            server.send(400, "application/json", "{\"error\":\"Expected a levels object\"}");
+            return;
+        }
+        for (JsonPair pair : doc["levels"].as<JsonObject>())
+        {
+            LogModule module;
+            LogLevel level;
+            bool all = strcmp(pair.key().c_str(), "all") == 0;
+            if ((!all && !LogRing::parseModule(pair.key().c_str(), module)) ||
+                !LogRing::parseLevel(pair.value() | "", level))
+            {
+                server.send(400, "application/json", "{\"error\":\"Unknown module or level\"}");
+                return;
+            }
+            if (all)
+                LogRing::setAllLevels(level);
+            else
+                LogRing::setLevel(module, level);
+        }
+    }
+
+    LogLevel maxLevel = LOG_LEVEL_DEBUG;
+    bool oneModule = false;
+    LogModule module = LOG_MOD_SYSTEM;
+    if ((server.hasArg("level") && !LogRing::parseLevel(server.arg("level").c_str(), maxLevel)) ||
+        (server.hasArg("module") && !(oneModule = LogRing::parseModule(server.arg("module").c_str(), module))))
+    {
+        server.send(400, "application/json", "{\"error\":\"Unknown module or level\"}");
+        return;
+    }
+    uint32_t since = server.hasArg("since") ? strtoul(server.arg("since").c_str(), nullptr, 10) : 0;
+
+    ChunkedResponse out;
+    out.begin(200, "application/json");
+    uint32_t head = LogRing::head();
+    out.printf("{\"head\":%u,\"now\":%u,\"dropped\":%u,\"levels\":{", head, millis(), LogRing::dropped());
+    for (int m = 0; m < LOG_MOD_COUNT; m++)
+    {
+        out.printf(m ? ",\"%s\":\"%s\"" : "\"%s\":\"%s\"", LogRing::moduleName((LogModule)m),
+                   LogRing::levelName(LogRing::level((LogModule)m)));
+    }
+    out.printf("},\"entries\":[");
+
+    bool first = true;
+    uint32_t seq = LogRing::oldest();
+    if (seq <= since)
+        seq = since + 1;
+    for (; seq <= head; seq++)
+    {
+        LogEntry entry;
+        char text[LOG_LINE_LENGTH];
+        char escaped[LOG_LINE_LENGTH * 2];
+        if (!LogRing::read(seq, entry, text, sizeof(text)) || entry.level > maxLevel ||
+            (oneModule && entry.module != module))
+            continue;
+
+        jsonEscape(text, escaped, sizeof(escaped));
+        out.printf("%s{\"seq\":%u,\"ms\":%u,\"level\":\"%s\",\"module\":\"%s\",\"msg\":\"%s\"}",
+                   first ? "" : ",", entry.seq, entry.ms, LogRing::levelName(entry.level),
+                   LogRing::moduleName(entry.module), escaped);
+        first = false;
+    }
+    out.printf("]}");
+    out.end();
+}
+
 void setupWebServer()
 {
     server.on("/", HTTP_GET, handleRoot);
@@ -401,6 +1103,17 @@ void setupWebServer()
     server.on("/resetTheme", HTTP_POST, handleResetTheme);
     server.on("/api/status", HTTP_GET, handleHaStatus);
     server.on("/api/command", HTTP_POST, handleHaCommand);
+    server.on("/api/history", HTTP_GET, handleHistory);
+    server.on("/api/telemetry", HTTP_GET, handleTelemetry);
+    server.on("/api/fetchstats", HTTP_GET, handleFetchStats);
+    server.on("/api/processes", HTTP_GET, handleProcesses);
+    server.on("/api/containers", HTTP_GET, handleContainers);
+    server.on("/api/alerts", HTTP_GET, handleAlertStatus);
+    server.on("/api/logs", HTTP_GET, handleLogs);
+    server.on("/api/logs", HTTP_POST, handleLogs);
+    server.on("/api/fetchstats", HTTP_DELETE, handleFetchStats);
+    server.on("/api/loop", HTTP_GET, handleLoopLatency);
+    server.on("/api/loop", HTTP_DELETE, handleLoopLatency);
     server.on("/css/styles.css", HTTP_GET, []()
               {
         File file = SPIFFS.open("/css/styles.css", "r");
@@ -0,0 +1,202 @@
+#include "wifi_manager.h"
+#include "boot_profile.h"
+#include "config.h"
+#include "credentials.h"
+#include "log_ring.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+
+#if defined(WIFI_STATIC_IP) && !defined(WIFI_DNS)
+#define WIFI_DNS WIFI_GATEWAY
+#endif
+
+// Channel and BSSID of the last access point we joined
+static Preferences hint;
+static WifiStats link_stats;
+static bool hint_attempt = false;
+static uint32_t attempt_ms = 0;
+static uint32_t retry_ms = 0;
+static uint32_t backoff_ms = WIFI_BACKOFF_MIN_MS;
+static bool lost = false;
+static uint32_t lost_ms = 0;
+static uint32_t rssi_ms = 0;
+
+// Written by the WiFi event task
+static volatile bool disconnect_event = false;
+static volatile uint8_t disconnect_reason = 0;
+
+static void onDisconnected(arduino_event_id_t event, arduino_event_info_t info)
+{
+    disconnect_reason = info.wifi_sta_disconnected.reason;
+    disconnect_event = true;
+}
+
+static bool loadHint(uint8_t &channel, uint8_t *bssid)
+{
+    channel = hint.getUChar("channel", 0);
+    return channel && hint.getBytes("bssid", bssid, 6) == 6;
+}
+
+static void saveHint()
+{
+    uint8_t saved[6];
+    uint8_t channel = WiFi.channel();
+    const uint8_t *bssid = WiFi.BSSID();
+    if (!bssid || (hint.getUChar("channel", 0) == channel && hint.getBytes("bssid", saved, 6) == 6 &&
+                   memcmp(saved, bssid, 6) == 0))
+        return;
+    hint.putUChar("channel", channel);
+    hint.putBytes("bssid", bssid, 6);
+}
+
+static void startAttempt(bool useHint)
+{
+    uint8_t channel;
+    uint8_t bssid[6];
+    hint_attempt = useHint && loadHint(channel, bssid);
+    link_stats.state = WIFI_STATE_CONNECTING;
+    link_stats.attempts++;
+    attempt_ms = millis();
+
+    if (hint_attempt)
+    {
+        LOG_I(LOG_MOD_WIFI, "Joining %s on channel %u", WIFI_SSID, channel);
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD, channel, bssid);
+    }
+    else
+    {
+        LOG_I(LOG_MOD_WIFI, "Joining %s", WIFI_SSID);
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    }
+}
+
+static void onConnected(uint32_t now)
+{
+    link_stats.state = WIFI_STATE_CONNECTED;
+    link_stats.connects++;
+    link_stats.connectedMs = now;
+    disconnect_event = false;
+    disconnect_reason = 0;
+    backoff_ms = WIFI_BACKOFF_MIN_MS;
+    if (lost)
+    {
+        lost = false;
+        link_stats.lastReconnectMs = now - lost_ms;
+        if (link_stats.lastReconnectMs > link_stats.maxReconnectMs)
+            link_stats.maxReconnectMs = link_stats.lastReconnectMs;
+    }
+
+    link_stats.rssi = WiFi.RSSI();
+    link_stats.rssiMin = link_stats.rssi;
+    link_stats.rssiMax = link_stats.rssi;
+    rssi_ms = now;
+
+    saveHint();
+    BootProfile::mark(BOOT_WIFI);
+    LOG_I(LOG_MOD_WIFI, "Connected: %s as %s, channel %u, RSSI %d", WiFi.localIP().toString().c_str(), WiFi.getHostname(),
+          WiFi.channel(), link_stats.rssi);
+}
+
+void WifiManager::begin()
+{
+    WiFi.onEvent(onDisconnected, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    // Our own hint replaces the driver's stored config, which would
+    // otherwise be rewritten to flash on every attempt that alternates
+    // between the hinted and the scanning join
+    WiFi.persistent(false);
+    // The hostname only takes effect when set before the mode
+    WiFi.hostname("systemmonitor");
+    WiFi.mode(WIFI_STA);
+    // Reconnects are ours, with backoff, instead of the driver's immediate retry
+    WiFi.setAutoReconnect(false);
+
+#ifdef WIFI_STATIC_IP
+    IPAddress ip, gateway, subnet, dns;
+    if (!ip.fromString(WIFI_STATIC_IP) || !gateway.fromString(WIFI_GATEWAY) || !subnet.fromString(WIFI_SUBNET) ||
+        !dns.fromString(WIFI_DNS) || !WiFi.config(ip, gateway, subnet, dns))
+    {
+        LOG_E(LOG_MOD_WIFI, "Invalid static IP configuration, using DHCP");
+    }
+#endif
+
+    hint.begin("wifi", false);
+    startAttempt(true);
+}
+
+void WifiManager::service()
+{
+    uint32_t now = millis();
+    switch (link_stats.state)
+    {
+    case WIFI_STATE_IDLE:
+        break;
+
+    case WIFI_STATE_CONNECTING:
+        if (WiFi.status() == WL_CONNECTED)
+        {
+            onConnected(now);
+        }
+        else if (now - attempt_ms >= (hint_attempt ? WIFI_HINT_TIMEOUT_MS : WIFI_CONNECT_TIMEOUT_MS))
+        {
+            WiFi.disconnect();
+            if (hint_attempt)
+            {
+                // The access point moved or changed channel
+                LOG_W(LOG_MOD_WIFI, "Remembered access point not found, scanning");
+                startAttempt(false);
+            }
+            else
+            {
+                LOG_W(LOG_MOD_WIFI, "Connect failed, retrying in %u ms", backoff_ms);
+                link_stats.state = WIFI_STATE_BACKOFF;
+                retry_ms = now + backoff_ms;
+                backoff_ms = backoff_ms * 2 < WIFI_BACKOFF_MAX_MS ? backoff_ms * 2 : WIFI_BACKOFF_MAX_MS;
+            }
+        }
+        break;
+
+    case WIFI_STATE_CONNECTED:
+        if (disconnect_event || WiFi.status() != WL_CONNECTED)
+        {
+            link_stats.disconnects++;
+            link_stats.lastReason = disconnect_reason;
+            lost = true;
+            lost_ms = now;
+            LOG_W(LOG_MOD_WIFI, "Link lost (reason %u), reconnecting", link_stats.lastReason);
+            WiFi.disconnect();
+            startAttempt(true);
+        }
+        else if (now - rssi_ms >= WIFI_RSSI_SAMPLE_MS)
+        {
+            rssi_ms = now;
+            link_stats.rssi = WiFi.RSSI();
+            if (link_stats.rssi < link_stats.rssiMin)
+                link_stats.rssiMin = link_stats.rssi;
+            if (link_stats.rssi > link_stats.rssiMax)
+                link_stats.rssiMax = link_stats.rssi;
+        }
+        break;
+
+    case WIFI_STATE_BACKOFF:
+        if ((int32_t)(now - retry_ms) >= 0)
+            startAttempt(true);
+        break;
+    }
+}
+
+bool WifiManager::connected()
+{
+    return link_stats.state == WIFI_STATE_CONNECTED;
+}
+
+const WifiStats &WifiManager::stats()
+{
+    return link_stats;
+}
+
+const char *WifiManager::stateName(WifiState state)
+{
+    static const char *const names[] = {"idle", "connecting", "connected", "backoff"};
+    return state <= WIFI_STATE_BACKOFF ? names[state] : "";
+}
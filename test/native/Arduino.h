@@ -0,0 +1,192 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Just enough of the Arduino core for the host-side tests: time, Serial,
+// String and the Print/Stream bases of WiFiClient. Only the native
+// environments put this directory on the include path.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <chrono>
+#include <thread>
+#include "WString.h"
+
+inline uint32_t micros()
+{
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+inline uint32_t millis()
+{
+    return micros() / 1000;
+}
+
+inline void delay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// glibc only gained strlcpy in 2.38
+inline size_t native_strlcpy(char *dst, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size > 0)
+    {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#define strlcpy native_strlcpy
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t n = 0;
+        while (n < size && write(buffer[n]))
+            n++;
+        return n;
+    }
+    virtual void flush() {}
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (n < 0)
+            return 0;
+        return write((const uint8_t *)buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+    }
+};
+
+// Reads with a timeout, like the Arduino core: read(), peek() and
+// available() never block, the helpers below wait up to setTimeout()
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long ms) { timeout = ms; }
+
+    size_t readBytes(char *buffer, size_t length)
+    {
+        size_t n = 0;
+        while (n < length)
+        {
+            int c = timedRead();
+            if (c < 0)
+                break;
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+
+    size_t readBytesUntil(char terminator, char *buffer, size_t length)
+    {
+        size_t n = 0;
+        while (n < length)
+        {
+            int c = timedRead();
+            if (c < 0 || c == terminator)
+                break;
+            buffer[n++] = (char)c;
+        }
+        return n;
+    }
+
+    bool find(const char *target)
+    {
+        size_t len = strlen(target);
+        size_t matched = 0;
+        while (matched < len)
+        {
+            int c = timedRead();
+            if (c < 0)
+                return false;
+            matched = c == target[matched] ? matched + 1 : (c == target[0] ? 1 : 0);
+        }
+        return true;
+    }
+
+protected:
+    int timedRead()
+    {
+        uint32_t start = millis();
+        do
+        {
+            int c = read();
+            if (c >= 0)
+                return c;
+            delay(1);
+        } while (millis() - start < timeout);
+        return -1;
+    }
+
+    unsigned long timeout = 1000;
+};
+
+// Serial writes to stdout, or nowhere once quiet is set
+class NativeSerial
+{
+public:
+    bool quiet = false;
+
+    void begin(unsigned long) {}
+    size_t print(const char *text)
+    {
+        if (!quiet)
+            fputs(text, stdout);
+        return strlen(text);
+    }
+    size_t print(const String &text) { return print(text.c_str()); }
+    size_t print(int value) { return printf("%d", value); }
+    size_t println(const char *text = "")
+    {
+        print(text);
+        return print("\n");
+    }
+    size_t println(const String &text) { return println(text.c_str()); }
+    size_t println(int value)
+    {
+        print(value);
+        return print("\n");
+    }
+    int availableForWrite() { return 4096; }
+    size_t write(const uint8_t *buffer, size_t size)
+    {
+        if (!quiet)
+            fwrite(buffer, 1, size, stdout);
+        return size;
+    }
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        if (quiet)
+            return 0;
+        va_list args;
+        va_start(args, format);
+        int n = vprintf(format, args);
+        va_end(args);
+        return n > 0 ? n : 0;
+    }
+};
+
+inline NativeSerial Serial;
+
+#endif
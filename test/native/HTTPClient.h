@@ -0,0 +1,6 @@
+#ifndef NATIVE_HTTPCLIENT_H
+#define NATIVE_HTTPCLIENT_H
+
+#define HTTP_CODE_OK 200
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef NATIVE_IPADDRESS_H
+#define NATIVE_IPADDRESS_H
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+
+class IPAddress
+{
+public:
+    IPAddress() {}
+    explicit IPAddress(uint32_t networkOrder) : address(networkOrder) {}
+
+    bool fromString(const char *text) { return inet_pton(AF_INET, text, &address) == 1; }
+    bool fromString(const String &text) { return fromString(text.c_str()); }
+    uint32_t raw() const { return address; } // network byte order
+
+private:
+    uint32_t address = 0;
+};
+
+#endif
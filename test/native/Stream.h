@@ -0,0 +1,7 @@
+#ifndef NATIVE_STREAM_H
+#define NATIVE_STREAM_H
+
+// ArduinoJson includes this for its Stream support
+#include <Arduino.h>
+
+#endif
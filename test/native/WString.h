@@ -0,0 +1,57 @@
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <string>
+
+// The subset of Arduino's String used by code that runs in the native tests
+class String
+{
+public:
+    String() {}
+    String(const char *text) : value(text ? text : "") {}
+    String(const std::string &text) : value(text) {}
+
+    const char *c_str() const { return value.c_str(); }
+    unsigned int length() const { return value.length(); }
+    bool reserve(unsigned int size)
+    {
+        value.reserve(size);
+        return true;
+    }
+    bool concat(const char *text, unsigned int len)
+    {
+        value.append(text, len);
+        return true;
+    }
+    bool concat(const char *text)
+    {
+        value.append(text);
+        return true;
+    }
+    void replace(const String &find, const String &with)
+    {
+        if (find.value.empty())
+            return;
+        for (size_t at = value.find(find.value); at != std::string::npos;
+             at = value.find(find.value, at + with.value.size()))
+            value.replace(at, find.value.size(), with.value);
+    }
+    bool operator==(const char *text) const { return value == text; }
+    String &operator+=(const char *text)
+    {
+        value += text;
+        return *this;
+    }
+
+private:
+    std::string value;
+};
+
+// ArduinoJson's String support names this type
+class StringSumHelper : public String
+{
+public:
+    using String::String;
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include <Arduino.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include "IPAddress.h"
+#include "WiFiClient.h"
+
+#define WL_CONNECTED 3
+
+// The host network is always up
+class NativeWiFi
+{
+public:
+    int status() { return WL_CONNECTED; }
+
+    bool hostByName(const char *host, IPAddress &ip)
+    {
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        addrinfo *result = nullptr;
+        if (getaddrinfo(host, nullptr, &hints, &result) != 0 || !result)
+            return false;
+        ip = IPAddress(((sockaddr_in *)result->ai_addr)->sin_addr.s_addr);
+        freeaddrinfo(result);
+        return true;
+    }
+};
+
+inline NativeWiFi WiFi;
+
+#endif
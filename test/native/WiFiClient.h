@@ -0,0 +1,145 @@
+#ifndef NATIVE_WIFICLIENT_H
+#define NATIVE_WIFICLIENT_H
+
+#include <Arduino.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "IPAddress.h"
+
+// TCP client over a non-blocking POSIX socket with the ESP32 WiFiClient
+// behaviour the fetch path relies on: reads never block, connected() stays
+// true while received data is left, and a reset ends the connection.
+class WiFiClient : public Stream
+{
+public:
+    WiFiClient() {}
+    WiFiClient(const WiFiClient &) = delete;
+    WiFiClient &operator=(const WiFiClient &) = delete;
+    ~WiFiClient() { stop(); }
+
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs)
+    {
+        stop();
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            return 0;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = ip.raw();
+        if (::connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS)
+        {
+            stop();
+            return 0;
+        }
+
+        pollfd p = {fd, POLLOUT, 0};
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (poll(&p, 1, timeoutMs) != 1 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error)
+        {
+            stop();
+            return 0;
+        }
+        eof = false;
+        return 1;
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        size_t sent = 0;
+        while (fd >= 0 && sent < size)
+        {
+            ssize_t n = send(fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                sent += n;
+            }
+            else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                pollfd p = {fd, POLLOUT, 0};
+                if (poll(&p, 1, 1000) != 1)
+                    break;
+            }
+            else
+            {
+                eof = true;
+                break;
+            }
+        }
+        return sent;
+    }
+
+    int available() override
+    {
+        fill();
+        return (int)(length - head);
+    }
+
+    int read() override
+    {
+        fill();
+        return head < length ? buffer[head++] : -1;
+    }
+
+    int read(uint8_t *out, size_t size)
+    {
+        fill();
+        size_t n = length - head < size ? length - head : size;
+        memcpy(out, buffer + head, n);
+        head += n;
+        return n > 0 ? (int)n : -1;
+    }
+
+    int peek() override
+    {
+        fill();
+        return head < length ? buffer[head] : -1;
+    }
+
+    uint8_t connected()
+    {
+        fill();
+        return fd >= 0 && (!eof || head < length);
+    }
+
+    void stop()
+    {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+        eof = true;
+        head = length = 0;
+    }
+
+private:
+    void fill()
+    {
+        if (head < length || fd < 0 || eof)
+            return;
+        head = length = 0;
+        ssize_t n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (n > 0)
+            length = n;
+        else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            eof = true; // closed or reset by the peer
+    }
+
+    int fd = -1;
+    bool eof = true;
+    uint8_t buffer[1460];
+    size_t head = 0;
+    size_t length = 0;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef NATIVE_CORPUS_H
+#define NATIVE_CORPUS_H
+
+#include <ArduinoJson.h>
+#include <stdio.h>
+#include <string>
+#include "glances_parse.h"
+
+#ifndef GLANCES_CORPUS_DIR
+#define GLANCES_CORPUS_DIR "test/corpus"
+#endif
+
+// Synthetic Glances responses live in test/corpus/<host>/<endpoint>.json,
+// with a second snapshot in <endpoint>.2.json where rates need two. They are
+// generated, not captured from real hosts: each follows the field layout of
+// its Glances version and the mounts, interfaces and sensors typical of the
+// platform it is named after.
+inline bool readCorpus(const char *host, const char *endpoint, std::string &out)
+{
+    std::string path = std::string(GLANCES_CORPUS_DIR) + "/" + host + "/" + endpoint + ".json";
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    out.clear();
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        out.append(chunk, n);
+    fclose(file);
+    return true;
+}
+
+struct CorpusPass
+{
+    bool ok;
+    size_t elements;
+    size_t peakElementBytes; // largest memoryUsage() of one filtered element
+    bool overflowed;         // an element did not fit its document
+};
+
+// A response body held in memory, read through the Arduino Stream interface
+class CorpusStream : public Stream
+{
+public:
+    explicit CorpusStream(const std::string &data) : data(data) { setTimeout(0); }
+
+    int available() override { return (int)(data.size() - pos); }
+    int peek() override { return pos < data.size() ? (uint8_t)data[pos] : -1; }
+    int read() override { return pos < data.size() ? (uint8_t)data[pos++] : -1; }
+    size_t write(uint8_t) override { return 0; }
+
+private:
+    const std::string &data;
+    size_t pos = 0;
+};
+
+// Runs the device's array walk, GlancesParse::walkArray, over a corpus file
+// and hands each element to the same callback as GlancesAPI::streamArray
+inline CorpusPass streamCorpus(const std::string &json, JsonDocument &filter, JsonDocument &element,
+                               ArrayElementCallback callback, void *context)
+{
+    CorpusStream stream(json);
+    ArrayPass walk;
+    bool ok = GlancesParse::walkArray(stream, filter, element, callback, context, millis(), walk);
+    return {ok, walk.elements, walk.peakElementBytes, walk.overflowed};
+}
+
+#endif
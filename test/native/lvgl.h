@@ -0,0 +1,13 @@
+#ifndef NATIVE_LVGL_H
+#define NATIVE_LVGL_H
+
+#include <stdint.h>
+
+// Headers shared with the firmware only name these types
+typedef union
+{
+    uint16_t full;
+} lv_color_t;
+typedef struct _lv_obj_t lv_obj_t;
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef NATIVE_LWIP_DNS_H
+#define NATIVE_LWIP_DNS_H
+
+// The part of lwIP's resolver the fetch path uses. Host lookups finish
+// before dns_gethostbyname() returns, so the callback is never called.
+
+#include <stdint.h>
+#include <netdb.h>
+#include <netinet/in.h>
+
+typedef int8_t err_t;
+#define ERR_OK 0
+#define ERR_INPROGRESS -5
+#define ERR_ARG -16
+
+struct ip4_addr
+{
+    uint32_t addr; // network byte order
+};
+typedef ip4_addr ip4_addr_t;
+typedef ip4_addr_t ip_addr_t;
+
+#define ip_2_ip4(ipaddr) (ipaddr)
+#define ip4_addr_get_u32(src_ipaddr) ((src_ipaddr)->addr)
+
+typedef void (*dns_found_callback)(const char *name, const ip_addr_t *ipaddr, void *callback_arg);
+
+inline err_t dns_gethostbyname(const char *hostname, ip_addr_t *addr, dns_found_callback, void *)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    addrinfo *result = nullptr;
+    if (getaddrinfo(hostname, nullptr, &hints, &result) != 0 || !result)
+        return ERR_ARG;
+    addr->addr = ((sockaddr_in *)result->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(result);
+    return ERR_OK;
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+#include "alert_engine.h"
+
+// Checks how alert transitions are queued and times rule evaluation. Host
+// timings are not ESP32 timings. Run with
+// "pio test -e native -f test_bench_alerts -v" to see the figure.
+
+#define ALERT_BENCH_SNAPSHOTS 100000
+
+bool debug_mode = false;
+
+// 16 rules over all ten metrics: value and rate rules, some sharing a metric
+static const char bench_rules[] =
+    "a=host_cpu>95/85@120;b=host_cpu>80;c=host_mem>90;d=rate:host_mem>5;"
+    "e=host_load>8;f=host_temp>85/80@30;g=rate:host_temp>2;h=host_net_rx>100000000;"
+    "i=host_net_tx>100000000;j=device_cpu>90;k=device_heap>90/85;l=rate:device_heap>10;"
+    "m=device_rssi<-80;n=device_temp>70;o=host_temp<5;p=host_load<0.1";
+
+void setUp()
+{
+    AlertEvent event;
+    while (AlertEngine::pollEvent(event))
+        ;
+}
+
+void tearDown() {}
+
+static void test_recompile_clears()
+{
+    char error[64];
+    TEST_ASSERT_TRUE(AlertEngine::compile(AlertEngine::defaultRules(), error, sizeof(error)));
+    for (uint64_t ms = 0; ms <= 40000; ms += 2000)
+        AlertEngine::observe(METRIC_HOST_TEMP, 90, 1000000 + ms);
+    TEST_ASSERT_EQUAL_UINT32(1, AlertEngine::activeCount());
+
+    AlertEvent event;
+    TEST_ASSERT_TRUE(AlertEngine::pollEvent(event));
+    TEST_ASSERT_TRUE(event.active);
+    TEST_ASSERT_TRUE(event.notify);
+
+    // The firing alert is cleared when the rules change, under its old name
+    TEST_ASSERT_TRUE(AlertEngine::compile("hot=host_temp>95", error, sizeof(error)));
+    TEST_ASSERT_EQUAL_UINT32(0, AlertEngine::activeCount());
+    TEST_ASSERT_TRUE(AlertEngine::pollEvent(event));
+    TEST_ASSERT_FALSE(event.active);
+    TEST_ASSERT_TRUE(event.notify);
+    TEST_ASSERT_EQUAL_STRING("temp", event.rule.name);
+    TEST_ASSERT_FALSE(AlertEngine::pollEvent(event));
+
+    // An invalid text keeps the rules and raises nothing
+    TEST_ASSERT_FALSE(AlertEngine::compile("hot=nothing>1", error, sizeof(error)));
+    TEST_ASSERT_FALSE(AlertEngine::pollEvent(event));
+}
+
+// Cost of one snapshot: a sample of every metric, each visiting only the
+// rules chained to it
+static void test_bench_alerts()
+{
+    char error[64];
+    TEST_ASSERT_TRUE(AlertEngine::compile(bench_rules, error, sizeof(error)));
+    TEST_ASSERT_EQUAL_UINT32(16, AlertEngine::ruleCount());
+
+    uint32_t evaluations = AlertEngine::evalCount();
+    uint32_t start = micros();
+    for (uint32_t s = 0; s < ALERT_BENCH_SNAPSHOTS; s++)
+    {
+        uint64_t nowMs = 2000000 + s * 2000ULL;
+        float wave = (s % 64) / 64.0f;
+        for (uint8_t m = 0; m < METRIC_COUNT; m++)
+            AlertEngine::observe((MetricId)m, 40 + 20 * wave + m, nowMs);
+    }
+    uint32_t elapsed = micros() - start;
+
+    // Every rule is evaluated once per snapshot, rate rules once they have a
+    // previous sample
+    uint32_t evaluated = AlertEngine::evalCount() - evaluations;
+    TEST_ASSERT_TRUE(evaluated >= 16 * (ALERT_BENCH_SNAPSHOTS - 1) && evaluated <= 16 * ALERT_BENCH_SNAPSHOTS);
+    printf("%u rules: %.3f us per snapshot of %d metrics\n", (unsigned)AlertEngine::ruleCount(),
+           (double)elapsed / ALERT_BENCH_SNAPSHOTS, METRIC_COUNT);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_recompile_clears);
+    RUN_TEST(test_bench_alerts);
+    return UNITY_END();
+}
@@ -0,0 +1,227 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "metric_format.h"
+
+// Checks MetricFormat's output and times it against the snprintf calls it
+// replaced on the display path, failing when a formatter is not clearly
+// faster. Host timings only compare the two with each other; they are not
+// ESP32 timings, where float printing costs more. Run with
+// "pio test -e native -f test_bench_format -v" to see the table.
+
+#define FORMAT_BENCH_ITERATIONS 20000
+#define FORMAT_BENCH_RUNS 5 // the fastest run counts, so a busy host does not fail the margin
+// Each formatter must beat the snprintf it replaced by at least this much in
+// the native test build, which PlatformIO compiles with -Og against an
+// optimized libc. The host measured 2.6x for temperature and 3x or more
+// for the others.
+#define FORMAT_BENCH_MIN_SPEEDUP 1.5
+
+bool debug_mode = false;
+
+static volatile size_t sink = 0;
+
+static const float rate_samples[] = {0, 512, 1500, 20480, 870000, 1048576, 5.5e6, 1.2e9};
+static const uint64_t size_samples[] = {0, 4096, 256060514304ULL, 2000398934016ULL, 12000138625024ULL};
+static const float percent_samples[] = {0, 3.14f, 45.25f, 87.5f, 99.96f, 100};
+static const uint32_t uptime_samples[] = {59, 3725, 90061, 1047845, 3622200};
+
+// The display path before MetricFormat
+static void snprintfRate(char *buf, size_t size, float bytes_per_sec)
+{
+    if (bytes_per_sec > 1024 * 1024)
+        snprintf(buf, size, "%.1fM", bytes_per_sec / (1024.0 * 1024.0));
+    else if (bytes_per_sec > 1024)
+        snprintf(buf, size, "%.1fK", bytes_per_sec / 1024.0);
+    else
+        snprintf(buf, size, "%.0fB", bytes_per_sec);
+}
+
+static void snprintfSize(char *buf, size_t size, uint64_t bytes)
+{
+    static const char units[] = "BKMGTP";
+    double value = bytes;
+    int unit = 0;
+    while (value >= 1024 && unit < 5)
+    {
+        value /= 1024;
+        unit++;
+    }
+    snprintf(buf, size, value < 10 ? "%.1f%c" : "%.0f%c", value, units[unit]);
+}
+
+static void snprintfUptime(char *buf, size_t size, uint32_t seconds)
+{
+    uint32_t days = seconds / 86400;
+    uint32_t rest = seconds % 86400;
+    if (days > 0)
+        snprintf(buf, size, "%u day%s, %u:%02u:%02u", (unsigned)days, days == 1 ? "" : "s", (unsigned)(rest / 3600),
+                 (unsigned)(rest / 60 % 60), (unsigned)(rest % 60));
+    else
+        snprintf(buf, size, "%u:%02u:%02u", (unsigned)(rest / 3600), (unsigned)(rest / 60 % 60),
+                 (unsigned)(rest % 60));
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_rates()
+{
+    char buf[16];
+    MetricFormat::rate(buf, sizeof(buf), 0);
+    TEST_ASSERT_EQUAL_STRING("0B", buf);
+    MetricFormat::rate(buf, sizeof(buf), 999);
+    TEST_ASSERT_EQUAL_STRING("999B", buf);
+    MetricFormat::rate(buf, sizeof(buf), 1500);
+    TEST_ASSERT_EQUAL_STRING("1.46K", buf);
+    MetricFormat::rate(buf, sizeof(buf), 20480);
+    TEST_ASSERT_EQUAL_STRING("20.0K", buf);
+    MetricFormat::rate(buf, sizeof(buf), 1048576);
+    TEST_ASSERT_EQUAL_STRING("1.00M", buf);
+    MetricFormat::rate(buf, sizeof(buf), 1.2e9f);
+    TEST_ASSERT_EQUAL_STRING("1.12G", buf);
+    MetricFormat::rate(buf, sizeof(buf), NAN);
+    TEST_ASSERT_EQUAL_STRING("--", buf);
+
+    // Up past 999K, back down only under 0.9M
+    UnitScale scale = {};
+    MetricFormat::rate(buf, sizeof(buf), 900000, &scale);
+    TEST_ASSERT_EQUAL_STRING("879K", buf);
+    MetricFormat::rate(buf, sizeof(buf), 1030000, &scale);
+    TEST_ASSERT_EQUAL_STRING("0.98M", buf);
+    MetricFormat::rate(buf, sizeof(buf), 950000, &scale);
+    TEST_ASSERT_EQUAL_STRING("0.91M", buf);
+    MetricFormat::rate(buf, sizeof(buf), 900000, &scale);
+    TEST_ASSERT_EQUAL_STRING("879K", buf);
+
+    // A value that does not fit is not cut into a different number
+    char small[5];
+    TEST_ASSERT_EQUAL_UINT32(2, MetricFormat::rate(small, sizeof(small), 5e6));
+    TEST_ASSERT_EQUAL_STRING("--", small);
+    TEST_ASSERT_EQUAL_UINT32(4, MetricFormat::rate(small, sizeof(small), 999));
+    TEST_ASSERT_EQUAL_STRING("999B", small);
+}
+
+static void test_sizes()
+{
+    char buf[16];
+    MetricFormat::bytes(buf, sizeof(buf), 2000398934016ULL);
+    TEST_ASSERT_EQUAL_STRING("1.82T", buf);
+    MetricFormat::bytes(buf, sizeof(buf), 256060514304ULL);
+    TEST_ASSERT_EQUAL_STRING("238G", buf);
+    MetricFormat::bytes(buf, sizeof(buf), 1500000, UNIT_SI);
+    TEST_ASSERT_EQUAL_STRING("1.50M", buf);
+}
+
+static void test_numbers()
+{
+    char buf[24];
+    MetricFormat::percent(buf, sizeof(buf), 45.25f, 1);
+    TEST_ASSERT_EQUAL_STRING("45.3%", buf);
+    MetricFormat::percent(buf, sizeof(buf), 99.96f, 1);
+    TEST_ASSERT_EQUAL_STRING("100.0%", buf);
+    MetricFormat::fixed(buf, sizeof(buf), -0.04f, 1);
+    TEST_ASSERT_EQUAL_STRING("0.0", buf);
+    MetricFormat::fixed(buf, sizeof(buf), -2.5f, 1);
+    TEST_ASSERT_EQUAL_STRING("-2.5", buf);
+    MetricFormat::temperature(buf, sizeof(buf), 44.6f);
+    TEST_ASSERT_EQUAL_STRING("45°C", buf);
+
+    MetricFormat::text(buf, sizeof(buf), "1.5K");
+    TEST_ASSERT_EQUAL_UINT32(6, MetricFormat::padLeft(buf, sizeof(buf), 6));
+    TEST_ASSERT_EQUAL_STRING("  1.5K", buf);
+
+    // Numbers that do not fit print "--"; text is cut to fit
+    char small[6];
+    MetricFormat::percent(small, sizeof(small), 100, 1);
+    TEST_ASSERT_EQUAL_STRING("--", small);
+    MetricFormat::duration(small, sizeof(small), 3725);
+    TEST_ASSERT_EQUAL_STRING("--", small);
+    MetricFormat::text(small, sizeof(small), "eth0.100");
+    TEST_ASSERT_EQUAL_STRING("eth0.", small);
+}
+
+static void test_durations()
+{
+    char buf[32];
+    char expected[32];
+    for (uint32_t seconds : uptime_samples)
+    {
+        MetricFormat::duration(buf, sizeof(buf), seconds);
+        snprintfUptime(expected, sizeof(expected), seconds);
+        TEST_ASSERT_EQUAL_STRING(expected, buf);
+
+        uint32_t parsed = 0;
+        TEST_ASSERT_TRUE(MetricFormat::parseDuration(buf, parsed));
+        TEST_ASSERT_EQUAL_UINT32(seconds, parsed);
+    }
+
+    uint32_t parsed;
+    TEST_ASSERT_FALSE(MetricFormat::parseDuration("3:4:05", parsed));
+    TEST_ASSERT_FALSE(MetricFormat::parseDuration("2 weeks", parsed));
+}
+
+// ns per call in the fastest of FORMAT_BENCH_RUNS runs
+template <typename T, size_t N, typename F>
+static double timeNs(const T (&samples)[N], F format)
+{
+    char buf[32];
+    double best = 0;
+    for (int run = 0; run < FORMAT_BENCH_RUNS; run++)
+    {
+        uint32_t start = micros();
+        for (int i = 0; i < FORMAT_BENCH_ITERATIONS; i++)
+        {
+            for (const T &sample : samples)
+            {
+                format(buf, sizeof(buf), sample);
+                sink += buf[0];
+            }
+        }
+        double ns = (micros() - start) * 1000.0 / ((double)FORMAT_BENCH_ITERATIONS * N);
+        if (run == 0 || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+static void checkRow(const char *name, double before, double after)
+{
+    printf("%-12s %10.1f %10.1f %7.1fx\n", name, before, after, after > 0 ? before / after : 0);
+    TEST_ASSERT_TRUE_MESSAGE(before >= after * FORMAT_BENCH_MIN_SPEEDUP, name);
+}
+
+static void test_bench_format()
+{
+    printf("%-12s %10s %10s %8s\n", "format", "snprintf", "fixed", "speedup");
+
+    checkRow("rate", timeNs(rate_samples, snprintfRate),
+             timeNs(rate_samples, [](char *buf, size_t size, float v) { MetricFormat::rate(buf, size, v); }));
+    checkRow("size", timeNs(size_samples, snprintfSize),
+             timeNs(size_samples, [](char *buf, size_t size, uint64_t v) { MetricFormat::bytes(buf, size, v); }));
+    checkRow("percent",
+             timeNs(percent_samples, [](char *buf, size_t size, float v) { snprintf(buf, size, "%.1f%%", v); }),
+             timeNs(percent_samples,
+                    [](char *buf, size_t size, float v) { MetricFormat::percent(buf, size, v, 1); }));
+    checkRow("temperature",
+             timeNs(percent_samples, [](char *buf, size_t size, float v) { snprintf(buf, size, "%d°C", (int)v); }),
+             timeNs(percent_samples,
+                    [](char *buf, size_t size, float v) { MetricFormat::temperature(buf, size, v); }));
+    checkRow("uptime", timeNs(uptime_samples, snprintfUptime),
+             timeNs(uptime_samples,
+                    [](char *buf, size_t size, uint32_t v) { MetricFormat::duration(buf, size, v); }));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rates);
+    RUN_TEST(test_sizes);
+    RUN_TEST(test_numbers);
+    RUN_TEST(test_durations);
+    RUN_TEST(test_bench_format);
+    return UNITY_END();
+}
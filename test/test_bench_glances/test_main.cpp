@@ -0,0 +1,270 @@
+#include <unity.h>
+#include <Arduino.h>
+#include "corpus.h"
+#include "glances_parse.h"
+#include "fs_classifier.h"
+#include "net_meter.h"
+#include "disk_meter.h"
+#include "sensor_map.h"
+#include "process_top.h"
+#include "container_top.h"
+
+// Times every corpus response through the same filter and callback as the
+// device and reports what one streamed pass costs. Host timings only compare
+// endpoints and changes with each other; they are not ESP32 timings. Run with
+// "pio test -e native -v" to see the table.
+
+#define BENCH_ITERATIONS 200
+#define BENCH_PROCESSES 1000
+
+bool debug_mode = false;
+
+static const char *const hosts[] = {"linux-v4", "unraid-v4", "windows-v4", "linux-v3"};
+
+static FsSummary bench_fs;
+static RatePass bench_pass;
+static uint64_t bench_us = 0;
+
+static uint64_t benchNowUs()
+{
+    return bench_us += 2000000;
+}
+
+static void *fsBegin()
+{
+    FsClassifier::beginPass(bench_fs);
+    return &bench_fs;
+}
+
+static void *rateBegin()
+{
+    bench_pass = {benchNowUs, false};
+    return &bench_pass;
+}
+
+static void *sensorBegin()
+{
+    SensorMap::beginPass();
+    return nullptr;
+}
+
+static void *processBegin()
+{
+    ProcessTop::beginPass();
+    return nullptr;
+}
+
+static void *containerBegin()
+{
+    ContainerTop::beginPass();
+    return nullptr;
+}
+
+static void netEnd()
+{
+    NetMeter::endPass();
+}
+
+static void diskIoEnd()
+{
+    DiskMeter::endPass();
+}
+
+static void sensorEnd()
+{
+    SensorMap::endPass();
+}
+
+static void processEnd()
+{
+    ProcessTop::endPass(0);
+}
+
+static void containerEnd()
+{
+    ContainerTop::endPass(0);
+}
+
+struct BenchEndpoint
+{
+    const char *name;
+    size_t filterSize;
+    size_t elementSize;
+    void (*fillFilter)(JsonDocument &filter);
+    ArrayElementCallback callback;
+    void *(*begin)();
+    void (*end)();
+};
+
+static const BenchEndpoint endpoints[] = {
+    {"fs", GLANCES_FS_FILTER_SIZE, GLANCES_FS_ELEMENT_SIZE, GlancesParse::fsFilter, GlancesParse::onFsEntry,
+     fsBegin, nullptr},
+    {"network", GLANCES_NET_FILTER_SIZE, GLANCES_NET_ELEMENT_SIZE, GlancesParse::netFilter,
+     GlancesParse::onNetEntry, rateBegin, netEnd},
+    {"diskio", GLANCES_DISKIO_FILTER_SIZE, GLANCES_DISKIO_ELEMENT_SIZE, GlancesParse::diskIoFilter,
+     GlancesParse::onDiskIoEntry, rateBegin, diskIoEnd},
+    {"sensors", GLANCES_SENSOR_FILTER_SIZE, GLANCES_SENSOR_ELEMENT_SIZE, GlancesParse::sensorFilter,
+     GlancesParse::onSensorEntry, sensorBegin, sensorEnd},
+    {"processlist", GLANCES_PROCESS_FILTER_SIZE, GLANCES_PROCESS_ELEMENT_SIZE, GlancesParse::processFilter,
+     GlancesParse::onProcessEntry, processBegin, processEnd},
+    {"containers", GLANCES_CONTAINER_FILTER_SIZE, GLANCES_CONTAINER_ELEMENT_SIZE, GlancesParse::containerFilter,
+     GlancesParse::onContainerEntry, containerBegin, containerEnd},
+};
+
+void setUp() {}
+
+void tearDown() {}
+
+// Peak memory of a streamed pass is the filter plus the largest element.
+// "whole" is what parsing the same payload into one document would hold:
+// the payload buffer plus the filtered document.
+static void test_bench_corpus()
+{
+    printf("%-10s %-11s %7s %5s %9s %6s %6s %7s %8s\n", "host", "endpoint", "bytes", "elems", "us/pass",
+           "filter", "elem", "stream", "whole");
+
+    for (const char *host : hosts)
+    {
+        for (const BenchEndpoint &endpoint : endpoints)
+        {
+            std::string json;
+            if (!readCorpus(host, endpoint.name, json))
+                continue;
+
+            DynamicJsonDocument filter(endpoint.filterSize);
+            DynamicJsonDocument element(endpoint.elementSize);
+            endpoint.fillFilter(filter);
+            TEST_ASSERT_FALSE_MESSAGE(filter.overflowed(), endpoint.name);
+
+            CorpusPass pass = {};
+            uint32_t start = micros();
+            for (int i = 0; i < BENCH_ITERATIONS; i++)
+            {
+                void *context = endpoint.begin();
+                pass = streamCorpus(json, filter, element, endpoint.callback, context);
+                if (endpoint.end)
+                    endpoint.end();
+            }
+            uint32_t elapsed = micros() - start;
+            TEST_ASSERT_TRUE_MESSAGE(pass.ok, endpoint.name);
+            TEST_ASSERT_FALSE_MESSAGE(pass.overflowed, endpoint.name);
+
+            DynamicJsonDocument whole(json.size() * 2);
+            TEST_ASSERT_FALSE(deserializeJson(whole, json, DeserializationOption::Filter(filter)));
+            size_t streamBytes = filter.memoryUsage() + pass.peakElementBytes;
+            size_t wholeBytes = json.size() + whole.memoryUsage();
+
+            printf("%-10s %-11s %7u %5u %9.1f %6u %6u %7u %8u\n", host, endpoint.name, (unsigned)json.size(),
+                   (unsigned)pass.elements, (double)elapsed / BENCH_ITERATIONS, (unsigned)filter.memoryUsage(),
+                   (unsigned)pass.peakElementBytes, (unsigned)streamBytes, (unsigned)wholeBytes);
+        }
+    }
+}
+
+// A processlist payload of BENCH_PROCESSES entries, each with the full set of
+// fields Glances sends. Values come from a fixed-seed generator, so every run
+// parses the same bytes.
+static std::string processList(size_t count)
+{
+    static const char *const names[] = {"systemd", "kworker/u16:2", "postgres", "nginx", "python3", "node",
+                                        "dockerd", "containerd-shim", "sshd", "smbd", "Plex Media Server",
+                                        "java", "chrome", "bash", "rsyslogd", "zfs"};
+    uint32_t seed = 12345;
+    auto next = [&seed]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        return seed ^= seed << 5;
+    };
+
+    std::string json = "[";
+    char entry[768];
+    for (size_t i = 0; i < count; i++)
+    {
+        const char *name = names[next() % (sizeof(names) / sizeof(names[0]))];
+        unsigned pid = 1 + next() % 4000000;
+        float cpu = (next() % 100000) / 1000.0f * ((next() & 7) == 0 ? 4 : 0.05f);
+        float mem = (next() % 10000) / 1000.0f;
+        unsigned long long rss = (unsigned long long)(next() % 4000000) * 1024;
+        snprintf(entry, sizeof(entry),
+                 "%s{\"name\": \"%s\", \"pid\": %u, \"ppid\": %u, \"username\": \"root\", \"status\": \"S\", "
+                 "\"nice\": 0, \"num_threads\": %u, \"cpu_percent\": %.1f, \"memory_percent\": %.2f, "
+                 "\"cmdline\": [\"/usr/bin/%s\", \"--pid\", \"%u\"], \"memory_info\": {\"rss\": %llu, "
+                 "\"vms\": %llu, \"shared\": 8192000, \"text\": 450560, \"lib\": 0, \"data\": 20480000, "
+                 "\"dirty\": 0}, \"cpu_times\": {\"user\": %.2f, \"system\": %.2f, \"children_user\": 0.0, "
+                 "\"children_system\": 0.0, \"iowait\": 0.0}, \"io_counters\": [%u, %u, %u, %u, 1], "
+                 "\"gids\": {\"real\": 0, \"effective\": 0, \"saved\": 0}, \"key\": \"pid\", "
+                 "\"time_since_update\": 2.0}",
+                 i ? ", " : "", name, pid, 1 + next() % pid, 1 + next() % 64, cpu, mem, name, pid, rss, rss * 4,
+                 (next() % 100000) / 100.0, (next() % 10000) / 100.0, next(), next(), next(), next());
+        json += entry;
+    }
+    json += "]";
+    return json;
+}
+
+static ProcessEntry bench_processes[BENCH_PROCESSES];
+static size_t bench_process_count = 0;
+
+static void collectProcess(JsonObjectConst process, void *)
+{
+    if (bench_process_count == BENCH_PROCESSES)
+        return;
+    ProcessEntry &entry = bench_processes[bench_process_count++];
+    strlcpy(entry.name, process["name"] | "", sizeof(entry.name));
+    entry.pid = process["pid"];
+    entry.cpu = process["cpu_percent"];
+    entry.mem = process["memory_percent"];
+}
+
+// Parse time of a large process list: the whole streamed pass, and the top-N
+// heap on its own with the same entries
+static void test_bench_processlist()
+{
+    std::string json = processList(BENCH_PROCESSES);
+    DynamicJsonDocument filter(GLANCES_PROCESS_FILTER_SIZE);
+    DynamicJsonDocument element(GLANCES_PROCESS_ELEMENT_SIZE);
+    GlancesParse::processFilter(filter);
+
+    CorpusPass pass = {};
+    uint32_t start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        ProcessTop::beginPass();
+        pass = streamCorpus(json, filter, element, GlancesParse::onProcessEntry, nullptr);
+        ProcessTop::endPass(0);
+    }
+    uint32_t streamUs = micros() - start;
+    TEST_ASSERT_TRUE(pass.ok);
+    TEST_ASSERT_FALSE(pass.overflowed);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_PROCESSES, pass.elements);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_PROCESSES, ProcessTop::processCount());
+    TEST_ASSERT_EQUAL_UINT32(PROCESS_TOP_N, ProcessTop::count());
+    for (size_t i = 1; i < ProcessTop::count(); i++)
+        TEST_ASSERT_TRUE(ProcessTop::entry(i - 1).cpu >= ProcessTop::entry(i).cpu);
+
+    bench_process_count = 0;
+    streamCorpus(json, filter, element, collectProcess, nullptr);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_PROCESSES, bench_process_count);
+
+    start = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        ProcessTop::beginPass();
+        for (const ProcessEntry &entry : bench_processes)
+            ProcessTop::add(entry.name, entry.pid, entry.cpu, entry.mem);
+        ProcessTop::endPass(0);
+    }
+    uint32_t heapUs = micros() - start;
+
+    printf("%u processes, %u bytes: %.1f us per streamed pass, %.1f us in the top-%d heap, %u B peak element\n",
+           (unsigned)BENCH_PROCESSES, (unsigned)json.size(), (double)streamUs / BENCH_ITERATIONS,
+           (double)heapUs / BENCH_ITERATIONS, PROCESS_TOP_N, (unsigned)pass.peakElementBytes);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_corpus);
+    RUN_TEST(test_bench_processlist);
+    return UNITY_END();
+}
@@ -0,0 +1,370 @@
+#include <unity.h>
+#include "corpus.h"
+#include "glances_parse.h"
+#include "fs_classifier.h"
+#include "net_meter.h"
+#include "disk_meter.h"
+#include "sensor_map.h"
+#include "process_top.h"
+#include "container_top.h"
+
+bool debug_mode = false;
+
+static uint64_t fake_us = 0;
+
+static uint64_t fakeNowUs()
+{
+    return fake_us;
+}
+
+template <size_t FilterSize, size_t ElementSize>
+static CorpusPass runEndpoint(const char *host, const char *endpoint, void (*fillFilter)(JsonDocument &),
+                              ArrayElementCallback callback, void *context)
+{
+    StaticJsonDocument<FilterSize> filter;
+    StaticJsonDocument<ElementSize> element;
+    fillFilter(filter);
+    TEST_ASSERT_FALSE_MESSAGE(filter.overflowed(), endpoint);
+
+    std::string json;
+    TEST_ASSERT_TRUE_MESSAGE(readCorpus(host, endpoint, json), endpoint);
+    CorpusPass pass = streamCorpus(json, filter, element, callback, context);
+    TEST_ASSERT_TRUE_MESSAGE(pass.ok, endpoint);
+    TEST_ASSERT_FALSE_MESSAGE(pass.overflowed, endpoint);
+    return pass;
+}
+
+static void parseFs(const char *host, FsSummary &summary)
+{
+    FsClassifier::beginPass(summary);
+    runEndpoint<GLANCES_FS_FILTER_SIZE, GLANCES_FS_ELEMENT_SIZE>(host, "fs", GlancesParse::fsFilter,
+                                                                  GlancesParse::onFsEntry, &summary);
+}
+
+// Each snapshot is taken two seconds after the previous one
+static bool parseNet(const char *host, const char *endpoint)
+{
+    fake_us += 2000000;
+    RatePass pass = {fakeNowUs, false};
+    runEndpoint<GLANCES_NET_FILTER_SIZE, GLANCES_NET_ELEMENT_SIZE>(host, endpoint, GlancesParse::netFilter,
+                                                                    GlancesParse::onNetEntry, &pass);
+    TEST_ASSERT_TRUE(pass.started);
+    return NetMeter::endPass();
+}
+
+static bool parseDiskIo(const char *host, const char *endpoint)
+{
+    fake_us += 2000000;
+    RatePass pass = {fakeNowUs, false};
+    runEndpoint<GLANCES_DISKIO_FILTER_SIZE, GLANCES_DISKIO_ELEMENT_SIZE>(
+        host, endpoint, GlancesParse::diskIoFilter, GlancesParse::onDiskIoEntry, &pass);
+    TEST_ASSERT_TRUE(pass.started);
+    return DiskMeter::endPass();
+}
+
+static void parseSensors(const char *host)
+{
+    SensorMap::beginPass();
+    runEndpoint<GLANCES_SENSOR_FILTER_SIZE, GLANCES_SENSOR_ELEMENT_SIZE>(
+        host, "sensors", GlancesParse::sensorFilter, GlancesParse::onSensorEntry, nullptr);
+    SensorMap::endPass();
+}
+
+static void parseProcesses(const char *host)
+{
+    ProcessTop::beginPass();
+    runEndpoint<GLANCES_PROCESS_FILTER_SIZE, GLANCES_PROCESS_ELEMENT_SIZE>(
+        host, "processlist", GlancesParse::processFilter, GlancesParse::onProcessEntry, nullptr);
+    ProcessTop::endPass(0);
+}
+
+static void parseContainers(const char *host)
+{
+    ContainerTop::beginPass();
+    runEndpoint<GLANCES_CONTAINER_FILTER_SIZE, GLANCES_CONTAINER_ELEMENT_SIZE>(
+        host, "containers", GlancesParse::containerFilter, GlancesParse::onContainerEntry, nullptr);
+    ContainerTop::endPass(0);
+}
+
+static void parseUptime(const char *host, char *out, size_t size)
+{
+    std::string json;
+    TEST_ASSERT_TRUE(readCorpus(host, "uptime", json));
+    StaticJsonDocument<64> doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, json));
+    GlancesParse::formatUptime(doc.as<JsonVariantConst>(), out, size);
+}
+
+void setUp()
+{
+    char error[64];
+    FsClassifier::compile(FsClassifier::defaultRules(), error, sizeof(error));
+    NetMeter::compile(NetMeter::defaultPatterns(), NET_MODE_FIRST, error, sizeof(error));
+    NetMeter::reset();
+    DiskMeter::reset();
+    SensorMap::compile(SensorMap::defaultMap(), error, sizeof(error));
+    ProcessTop::setSort(PROCESS_SORT_CPU);
+    ContainerTop::setSort(PROCESS_SORT_CPU);
+}
+
+void tearDown() {}
+
+static void test_fs_linux_v4()
+{
+    static FsSummary summary;
+    parseFs("linux-v4", summary);
+    TEST_ASSERT_EQUAL_UINT16(6, summary.mountCount);
+    TEST_ASSERT_EQUAL_UINT16(2, summary.arrayCount);
+    TEST_ASSERT_EQUAL_UINT64(5000000000000ULL, summary.arraySize);
+    TEST_ASSERT_EQUAL_UINT64(1400000000000ULL, summary.arrayUsed);
+    TEST_ASSERT_EQUAL_UINT16(1, summary.cacheCount);
+    TEST_ASSERT_EQUAL_UINT16(3, summary.driveCount);
+    TEST_ASSERT_EQUAL_STRING("home", summary.drives[0].name);
+    TEST_ASSERT_EQUAL_STRING("cache", summary.drives[1].name);
+}
+
+static void test_fs_unraid_v4()
+{
+    static FsSummary summary;
+    parseFs("unraid-v4", summary);
+    TEST_ASSERT_EQUAL_UINT16(2, summary.arrayCount);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, FsClassifier::percent(summary.arrayUsed, summary.arraySize));
+    TEST_ASSERT_EQUAL_UINT16(1, summary.cacheCount);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 25.0f, FsClassifier::percent(summary.cacheUsed, summary.cacheSize));
+    TEST_ASSERT_EQUAL_STRING("disk1", summary.drives[0].name);
+}
+
+static void test_fs_windows_v4()
+{
+    static FsSummary summary;
+    parseFs("windows-v4", summary);
+    // Fixed drives only; the removable E: is ignored
+    TEST_ASSERT_EQUAL_UINT16(3, summary.mountCount);
+    TEST_ASSERT_EQUAL_UINT16(2, summary.arrayCount);
+    TEST_ASSERT_EQUAL_UINT64(2511000000000ULL, summary.arraySize);
+    TEST_ASSERT_EQUAL_UINT64(755500000000ULL, summary.arrayUsed);
+    TEST_ASSERT_EQUAL_STRING("C:", summary.drives[0].name);
+}
+
+static void test_fs_linux_v3()
+{
+    static FsSummary summary;
+    parseFs("linux-v3", summary);
+    TEST_ASSERT_EQUAL_UINT16(1, summary.arrayCount);
+    TEST_ASSERT_EQUAL_UINT16(0, summary.cacheCount);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, FsClassifier::percent(summary.arrayUsed, summary.arraySize));
+}
+
+static void test_fs_rule_conditions()
+{
+    // A read-only fixed drive is no longer part of the array
+    TEST_ASSERT_EQUAL(FS_GROUP_ARRAY, FsClassifier::classify("C:\\", "rw,fixed", "C:\\", "NTFS"));
+    TEST_ASSERT_EQUAL(FS_GROUP_IGNORE, FsClassifier::classify("F:\\", "ro,fixed", "F:\\", "NTFS"));
+
+    char error[64];
+    TEST_ASSERT_TRUE(FsClassifier::compile("cache:type=xfs&mnt=*cache*", error, sizeof(error)));
+    TEST_ASSERT_EQUAL(FS_GROUP_CACHE, FsClassifier::classify("/mnt/cache", "rw", "sdb1", "xfs"));
+    TEST_ASSERT_EQUAL(FS_GROUP_IGNORE, FsClassifier::classify("/mnt/cache", "rw", "sdb1", "btrfs"));
+    TEST_ASSERT_FALSE(FsClassifier::compile("array:opt=a&opt=b&opt=c", error, sizeof(error)));
+    TEST_ASSERT_FALSE(FsClassifier::compile("array:opt=a&", error, sizeof(error)));
+    TEST_ASSERT_EQUAL_UINT32(1, FsClassifier::ruleCount());
+}
+
+static void test_network_linux_v4()
+{
+    TEST_ASSERT_FALSE(parseNet("linux-v4", "network"));
+    TEST_ASSERT_TRUE(parseNet("linux-v4", "network.2"));
+    const NetRates &rates = NetMeter::rates();
+    TEST_ASSERT_EQUAL_STRING("enp3s0", rates.name);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 1250000.0f, rates.rxRate);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 250000.0f, rates.txRate);
+    TEST_ASSERT_EQUAL_UINT32(1, NetMeter::interfaceCount());
+}
+
+static void test_network_unraid_v4()
+{
+    parseNet("unraid-v4", "network");
+    // The bond is preferred over its member port and the bridge on top
+    TEST_ASSERT_EQUAL_STRING("bond0", NetMeter::rates().name);
+    TEST_ASSERT_EQUAL_UINT32(3, NetMeter::interfaceCount());
+}
+
+static void test_network_windows_v4()
+{
+    parseNet("windows-v4", "network");
+    TEST_ASSERT_EQUAL_STRING("Ethernet", NetMeter::rates().name);
+    TEST_ASSERT_EQUAL_UINT32(2, NetMeter::interfaceCount());
+}
+
+static void test_network_linux_v3()
+{
+    parseNet("linux-v3", "network");
+    TEST_ASSERT_TRUE(parseNet("linux-v3", "network.2"));
+    const NetRates &rates = NetMeter::rates();
+    TEST_ASSERT_EQUAL_STRING("eth0", rates.name);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 500000.0f, rates.rxRate);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 100000.0f, rates.txRate);
+}
+
+static void test_diskio_linux_v4()
+{
+    uint32_t rebuilds = DiskMeter::rebuildCount();
+    TEST_ASSERT_FALSE(parseDiskIo("linux-v4", "diskio"));
+    TEST_ASSERT_TRUE(parseDiskIo("linux-v4", "diskio.2"));
+    // The position map is built once and reused for the second payload
+    TEST_ASSERT_EQUAL_UINT32(rebuilds + 1, DiskMeter::rebuildCount());
+
+    // Partitions and loop devices are skipped, dm-0 is kept out of the total
+    TEST_ASSERT_EQUAL_UINT32(3, DiskMeter::diskCount());
+    const DiskTotals &totals = DiskMeter::totals();
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 11000000.0f, totals.readRate);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 2000000.0f, totals.writeRate);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 250.0f, totals.readIops);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 100.0f, totals.writeIops);
+    TEST_ASSERT_TRUE(totals.busiest >= 0);
+    TEST_ASSERT_EQUAL_STRING("nvme0n1", DiskMeter::disk(totals.busiest).name);
+    TEST_ASSERT_TRUE(DiskMeter::disk(2).stacked);
+}
+
+static void test_diskio_unraid_v4()
+{
+    parseDiskIo("unraid-v4", "diskio");
+    TEST_ASSERT_EQUAL_UINT32(6, DiskMeter::diskCount());
+    TEST_ASSERT_EQUAL_STRING("md1p1", DiskMeter::disk(4).name);
+    TEST_ASSERT_TRUE(DiskMeter::disk(4).stacked);
+}
+
+static void test_sensors_linux_v4()
+{
+    parseSensors("linux-v4");
+    TEST_ASSERT_TRUE(SensorMap::reading(0).present);
+    TEST_ASSERT_EQUAL_STRING("Package id 0", SensorMap::reading(0).label);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 48.0f, SensorMap::reading(0).value);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 38.85f, SensorMap::reading(1).value);
+    TEST_ASSERT_FALSE(SensorMap::reading(2).present);
+}
+
+static void test_sensors_unraid_v4()
+{
+    parseSensors("unraid-v4");
+    TEST_ASSERT_EQUAL_STRING("Tctl", SensorMap::reading(0).label);
+    TEST_ASSERT_EQUAL(SENSOR_LEVEL_CRIT, SensorMap::reading(0).level);
+    TEST_ASSERT_FALSE(SensorMap::reading(1).present);
+    TEST_ASSERT_EQUAL_STRING("edge", SensorMap::reading(2).label);
+}
+
+static void test_sensors_windows_v4()
+{
+    parseSensors("windows-v4");
+    for (size_t i = 0; i < SensorMap::slotCount(); i++)
+        TEST_ASSERT_FALSE(SensorMap::reading(i).present);
+}
+
+static void test_sensors_linux_v3()
+{
+    parseSensors("linux-v3");
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 55.0f, SensorMap::reading(0).value);
+}
+
+static void test_sensors_reordered()
+{
+    static const char *const labels[] = {"acpitz", "Package id 0", "Composite"};
+    static const float values[] = {30, 48, 39};
+    static const int orders[][3] = {{0, 1, 2}, {0, 1, 2}, {2, 0, 1}, {1, 2, 0}};
+    uint32_t rebuilds = SensorMap::rebuildCount();
+
+    for (const auto &order : orders)
+    {
+        SensorMap::beginPass();
+        for (int i : order)
+            SensorMap::addSensor(labels[i], "temperature_core", values[i]);
+        SensorMap::endPass();
+
+        // Never reported absent while the map catches up with the new order
+        TEST_ASSERT_TRUE(SensorMap::reading(0).present);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, 48.0f, SensorMap::reading(0).value);
+        TEST_ASSERT_TRUE(SensorMap::reading(1).present);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, 39.0f, SensorMap::reading(1).value);
+    }
+    // Built on the first pass and once more after the reorder
+    TEST_ASSERT_EQUAL_UINT32(rebuilds + 2, SensorMap::rebuildCount());
+}
+
+static void test_processes()
+{
+    parseProcesses("linux-v4");
+    TEST_ASSERT_EQUAL_UINT32(182, ProcessTop::processCount());
+    TEST_ASSERT_EQUAL_UINT32(PROCESS_TOP_N, ProcessTop::count());
+    TEST_ASSERT_EQUAL_STRING("ffmpeg", ProcessTop::entry(0).name);
+    TEST_ASSERT_EQUAL_UINT32(4242, ProcessTop::entry(0).pid);
+    TEST_ASSERT_EQUAL_STRING("postgres", ProcessTop::entry(1).name);
+
+    parseProcesses("windows-v4");
+    TEST_ASSERT_EQUAL_UINT32(61, ProcessTop::processCount());
+    TEST_ASSERT_EQUAL_STRING("MsMpEng.exe", ProcessTop::entry(0).name);
+}
+
+static void test_containers()
+{
+    parseContainers("linux-v4");
+    const ContainerSummary &summary = ContainerTop::summary();
+    TEST_ASSERT_EQUAL_UINT16(4, summary.total);
+    TEST_ASSERT_EQUAL_UINT16(2, summary.running);
+    TEST_ASSERT_EQUAL_UINT16(1, summary.restarting);
+    // Problem containers rank first
+    TEST_ASSERT_EQUAL_STRING("worker", ContainerTop::entry(0).name);
+    TEST_ASSERT_EQUAL_STRING("postgres", ContainerTop::entry(1).name);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 500.0f, ContainerTop::entry(1).memMb);
+
+    parseContainers("unraid-v4");
+    TEST_ASSERT_EQUAL_UINT16(12, ContainerTop::summary().total);
+    TEST_ASSERT_EQUAL_UINT16(11, ContainerTop::summary().running);
+    TEST_ASSERT_EQUAL_UINT32(CONTAINER_TOP_N, ContainerTop::count());
+}
+
+static void test_uptime()
+{
+    char uptime[32];
+    parseUptime("linux-v4", uptime, sizeof(uptime));
+    TEST_ASSERT_EQUAL_STRING("12 days, 3:04:05", uptime);
+    parseUptime("windows-v4", uptime, sizeof(uptime));
+    TEST_ASSERT_EQUAL_STRING("3:14:15", uptime);
+    parseUptime("linux-v3", uptime, sizeof(uptime));
+    TEST_ASSERT_EQUAL_STRING("5 days, 1:02:03", uptime);
+
+    StaticJsonDocument<32> doc;
+    doc.set(90061);
+    GlancesParse::formatUptime(doc.as<JsonVariantConst>(), uptime, sizeof(uptime));
+    TEST_ASSERT_EQUAL_STRING("1 day, 1:01:01", uptime);
+    doc.set(3725.5);
+    GlancesParse::formatUptime(doc.as<JsonVariantConst>(), uptime, sizeof(uptime));
+    TEST_ASSERT_EQUAL_STRING("1:02:05", uptime);
+    doc.clear();
+    GlancesParse::formatUptime(doc.as<JsonVariantConst>(), uptime, sizeof(uptime));
+    TEST_ASSERT_EQUAL_STRING("", uptime);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fs_linux_v4);
+    RUN_TEST(test_fs_unraid_v4);
+    RUN_TEST(test_fs_windows_v4);
+    RUN_TEST(test_fs_linux_v3);
+    RUN_TEST(test_fs_rule_conditions);
+    RUN_TEST(test_network_linux_v4);
+    RUN_TEST(test_network_unraid_v4);
+    RUN_TEST(test_network_windows_v4);
+    RUN_TEST(test_network_linux_v3);
+    RUN_TEST(test_diskio_linux_v4);
+    RUN_TEST(test_diskio_unraid_v4);
+    RUN_TEST(test_sensors_linux_v4);
+    RUN_TEST(test_sensors_unraid_v4);
+    RUN_TEST(test_sensors_windows_v4);
+    RUN_TEST(test_sensors_linux_v3);
+    RUN_TEST(test_sensors_reordered);
+    RUN_TEST(test_processes);
+    RUN_TEST(test_containers);
+    RUN_TEST(test_uptime);
+    return UNITY_END();
+}
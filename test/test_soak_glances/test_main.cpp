@@ -0,0 +1,245 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <malloc.h>
+#include <algorithm>
+#include <new>
+#include <vector>
+#include "config.h"
+#include "glances_api.h"
+#include "alloc_counter.h"
+#include "disk_meter.h"
+#include "process_top.h"
+#include "container_top.h"
+
+// Runs the firmware's fetch path (GlancesAPI::fetchData and streamArray over
+// the WiFiClient shim) against tools/soak/mock_glances.py for a fixed time
+// and reports cycle latency, recovery time after failures, heap drift and
+// allocations per cycle.
+// Start the mock first, then: pio test -e soak -v. Settings come from the
+// environment: SOAK_HOST, SOAK_PORT, SOAK_SECONDS, SOAK_INTERVAL_MS and
+// SOAK_CSV (one row per cycle).
+
+#define SOAK_DEFAULT_SECONDS 60
+#define SOAK_DEFAULT_INTERVAL_MS 1000
+// Growth of the allocated heap between the first and last tenth of the run
+#define SOAK_MAX_HEAP_DRIFT_BYTES 16384
+// Cycles that may allocate while the static documents are set up
+#define SOAK_WARMUP_CYCLES 2
+
+String glances_host = "127.0.0.1";
+uint16_t glances_port = 61208;
+bool debug_mode = false;
+
+static FsSummary soak_fs;
+
+// libstdc++ is a shared library here, so its operator new would reach
+// malloc without passing the --wrap of AllocCounter
+void *operator new(size_t size)
+{
+    void *block = malloc(size);
+    if (!block)
+        throw std::bad_alloc();
+    return block;
+}
+
+void operator delete(void *block) noexcept
+{
+    free(block);
+}
+
+void operator delete(void *block, size_t) noexcept
+{
+    free(block);
+}
+
+static uint64_t soakNowUs()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static long envLong(const char *name, long fallback)
+{
+    const char *value = getenv(name);
+    return value && *value ? atol(value) : fallback;
+}
+
+static size_t heapInUse()
+{
+    return mallinfo2().uordblks;
+}
+
+// One updateGlancesData() worth of requests, without the GUI and history
+static bool runCycle()
+{
+    static StaticJsonDocument<4096> doc;
+    static DynamicJsonDocument fsFilter(GLANCES_FS_FILTER_SIZE), fsElement(GLANCES_FS_ELEMENT_SIZE);
+    static DynamicJsonDocument netFilter(GLANCES_NET_FILTER_SIZE), netElement(GLANCES_NET_ELEMENT_SIZE);
+    static DynamicJsonDocument diskFilter(GLANCES_DISKIO_FILTER_SIZE), diskElement(GLANCES_DISKIO_ELEMENT_SIZE);
+    static DynamicJsonDocument sensorFilter(GLANCES_SENSOR_FILTER_SIZE), sensorElement(GLANCES_SENSOR_ELEMENT_SIZE);
+    static DynamicJsonDocument processFilter(GLANCES_PROCESS_FILTER_SIZE),
+        processElement(GLANCES_PROCESS_ELEMENT_SIZE);
+    static DynamicJsonDocument containerFilter(GLANCES_CONTAINER_FILTER_SIZE),
+        containerElement(GLANCES_CONTAINER_ELEMENT_SIZE);
+
+    if (fsFilter.isNull())
+    {
+        GlancesParse::fsFilter(fsFilter);
+        GlancesParse::netFilter(netFilter);
+        GlancesParse::diskIoFilter(diskFilter);
+        GlancesParse::sensorFilter(sensorFilter);
+        GlancesParse::processFilter(processFilter);
+        GlancesParse::containerFilter(containerFilter);
+    }
+
+    uint32_t errorsBefore = FetchStats::errorCount();
+    GlancesAPI::fetchData("/api/4/cpu", doc);
+    GlancesAPI::fetchData("/api/4/mem", doc);
+
+    SensorMap::beginPass();
+    if (GlancesAPI::streamArray("/api/4/sensors", sensorFilter, sensorElement, GlancesParse::onSensorEntry, nullptr))
+        SensorMap::endPass();
+
+    FsClassifier::beginPass(soak_fs);
+    GlancesAPI::streamArray("/api/4/fs", fsFilter, fsElement, GlancesParse::onFsEntry, &soak_fs);
+
+    ProcessTop::beginPass();
+    FetchTrace trace;
+    if (GlancesAPI::streamArray("/api/4/processlist", processFilter, processElement, GlancesParse::onProcessEntry,
+                                nullptr, &trace))
+        ProcessTop::endPass(trace.phaseUs[PHASE_PARSE]);
+
+    ContainerTop::beginPass();
+    if (GlancesAPI::streamArray("/api/4/containers", containerFilter, containerElement,
+                                GlancesParse::onContainerEntry, nullptr, &trace))
+        ContainerTop::endPass(trace.phaseUs[PHASE_PARSE]);
+
+    GlancesAPI::fetchData("/api/4/uptime", doc);
+
+    RatePass pass = {soakNowUs, false};
+    if (GlancesAPI::streamArray("/api/4/network", netFilter, netElement, GlancesParse::onNetEntry, &pass) &&
+        pass.started)
+        NetMeter::endPass();
+
+    pass = {soakNowUs, false};
+    if (GlancesAPI::streamArray("/api/4/diskio", diskFilter, diskElement, GlancesParse::onDiskIoEntry, &pass) &&
+        pass.started)
+        DiskMeter::endPass();
+
+    GlancesAPI::fetchData("/api/4/load", doc);
+    return FetchStats::errorCount() == errorsBefore;
+}
+
+static uint32_t percentile(std::vector<uint32_t> values, unsigned percent)
+{
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    return values[(values.size() - 1) * percent / 100];
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+static void test_soak()
+{
+    glances_host = getenv("SOAK_HOST") ? getenv("SOAK_HOST") : "127.0.0.1";
+    glances_port = (uint16_t)envLong("SOAK_PORT", 61208);
+    long seconds = envLong("SOAK_SECONDS", SOAK_DEFAULT_SECONDS);
+    uint32_t intervalMs = (uint32_t)envLong("SOAK_INTERVAL_MS", SOAK_DEFAULT_INTERVAL_MS);
+    FILE *csv = getenv("SOAK_CSV") ? fopen(getenv("SOAK_CSV"), "w") : nullptr;
+    if (csv)
+        fprintf(csv, "elapsed_ms,cycle_ms,ok,errors,allocs,heap_bytes\n");
+
+    // The fetch path logs every failure; a soak run only wants the summary
+    Serial.quiet = true;
+
+    std::vector<uint32_t> cycleMs;
+    std::vector<uint32_t> recoveryMs;
+    std::vector<size_t> heap;
+    uint32_t failed = 0;
+    uint32_t steadyAllocs = 0;
+    uint32_t failStartMs = 0;
+    bool failing = false;
+    uint32_t start = millis();
+
+    while ((long)(millis() - start) < seconds * 1000)
+    {
+        uint32_t cycleStart = millis();
+        uint32_t errorsBefore = FetchStats::errorCount();
+        uint32_t allocsBefore = AllocCounter::count();
+        bool ok = runCycle();
+        uint32_t allocs = AllocCounter::count() - allocsBefore;
+        uint32_t now = millis();
+        if (cycleMs.size() >= SOAK_WARMUP_CYCLES)
+            steadyAllocs = std::max(steadyAllocs, allocs);
+        cycleMs.push_back(now - cycleStart);
+        heap.push_back(heapInUse());
+
+        // Recovery runs from the start of the first failed cycle to the
+        // end of the next clean one
+        if (!ok)
+        {
+            failed++;
+            if (!failing)
+                failStartMs = cycleStart;
+            failing = true;
+        }
+        else if (failing)
+        {
+            recoveryMs.push_back(now - failStartMs);
+            failing = false;
+        }
+
+        if (csv)
+            fprintf(csv, "%u,%u,%d,%u,%u,%u\n", now - start, now - cycleStart, ok,
+                    FetchStats::errorCount() - errorsBefore, allocs, (unsigned)heap.back());
+        if (now - cycleStart < intervalMs)
+            delay(intervalMs - (now - cycleStart));
+    }
+    if (csv)
+        fclose(csv);
+    Serial.quiet = false;
+
+    // Heap growth compares the medians of the first and last tenth, so one
+    // cycle caught mid-allocation does not count as drift
+    size_t tenth = std::max<size_t>(1, heap.size() / 10);
+    std::vector<uint32_t> first(heap.begin(), heap.begin() + tenth);
+    std::vector<uint32_t> last(heap.end() - tenth, heap.end());
+    long drift = (long)percentile(last, 50) - (long)percentile(first, 50);
+
+    printf("cycles %u, failed %u, errors %u\n", (unsigned)cycleMs.size(), failed, FetchStats::errorCount());
+    printf("cycle ms: p50 %u, p95 %u, max %u\n", percentile(cycleMs, 50), percentile(cycleMs, 95),
+           percentile(cycleMs, 100));
+    printf("recoveries %u: p50 %u ms, max %u ms%s\n", (unsigned)recoveryMs.size(), percentile(recoveryMs, 50),
+           percentile(recoveryMs, 100), failing ? ", still failing at the end" : "");
+    printf("heap in use: %u -> %u bytes, drift %ld\n", (unsigned)heap.front(), (unsigned)heap.back(), drift);
+    printf("allocations per cycle after warm-up: max %u\n", steadyAllocs);
+    for (size_t i = 0; i < FetchStats::endpointCount(); i++)
+    {
+        const EndpointStats &stats = FetchStats::endpoint(i);
+        printf("  %-20s %6u ok", stats.endpoint, stats.count);
+        for (int e = 0; e < FETCH_ERR_COUNT; e++)
+        {
+            if (stats.errors[e])
+                printf(", %u %s", stats.errors[e], FetchStats::errorName((FetchError)e));
+        }
+        printf("\n");
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE(cycleMs.size() > failed, "no clean cycle; is the mock server running?");
+    TEST_ASSERT_LESS_THAN_MESSAGE(SOAK_MAX_HEAP_DRIFT_BYTES, drift, "heap grew over the run");
+    // The fetch path uses fixed buffers; any allocation is a regression. This
+    // only sees the firmware's code over the host WiFiClient shim, not the
+    // ESP32 network stack; esp32dev-soak counts those on the device.
+    TEST_ASSERT_TRUE(AllocCounter::enabled());
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, steadyAllocs, "the fetch path allocated after warm-up");
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_soak);
+    return UNITY_END();
+}
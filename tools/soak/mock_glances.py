@@ -0,0 +1,308 @@
+#!/usr/bin/env python3
+"""Replayable mock of the Glances REST API for soak tests.
+
+Serves the responses in a corpus directory (test/corpus/<host>) as
+/api/4/<endpoint>, fills in cpu, mem, load, percpu and uptime when the corpus
+has none, and keeps the network and disk I/O counters moving so the rate
+meters see traffic. Faults are injected per request with the given
+probabilities:
+
+  latency_ms, jitter_ms   delay before the response, +- jitter
+  error_rate              answer 500 or 503
+  reset_rate              reset the connection before the headers or mid-body
+  truncate_rate           close after half of the advertised body
+  drip_bytes, drip_ms     send the body in small pieces with a pause between
+
+A scenario file cycles through phases that override these settings, for
+example a clean hour followed by ten minutes of resets. The faults can also
+be changed at runtime with POST /mock/faults, and GET /mock/state reports the
+current phase and the time of the last injected fault for soak_device.py.
+
+  python3 tools/soak/mock_glances.py --corpus test/corpus/unraid-v4 \\
+      --scenario tools/soak/scenario.example.json --log mock.csv
+"""
+
+import argparse
+import csv
+import json
+import math
+import os
+import random
+import socket
+import socketserver
+import struct
+import sys
+import threading
+import time
+
+FAULT_KEYS = ("latency_ms", "jitter_ms", "error_rate", "reset_rate", "truncate_rate", "drip_bytes", "drip_ms")
+
+
+class Faults:
+    """Base fault settings, optionally overridden by the current scenario phase."""
+
+    def __init__(self, base, phases):
+        self.lock = threading.Lock()
+        self.base = dict(base)
+        self.phases = phases
+        self.start = time.monotonic()
+
+    def update(self, values):
+        for key in values:
+            if key not in FAULT_KEYS:
+                raise ValueError("unknown fault '%s'" % key)
+        with self.lock:
+            self.base.update({key: float(value) for key, value in values.items()})
+
+    def current(self):
+        with self.lock:
+            faults = dict(self.base)
+            phase = None
+            if self.phases:
+                total = sum(p["seconds"] for p in self.phases)
+                at = (time.monotonic() - self.start) % total
+                for p in self.phases:
+                    if at < p["seconds"]:
+                        phase = p
+                        break
+                    at -= p["seconds"]
+                faults.update({k: float(v) for k, v in phase.items() if k in FAULT_KEYS})
+            return faults, phase["name"] if phase else "base"
+
+
+class Payloads:
+    """Corpus responses, with synthetic ones for the scalar endpoints."""
+
+    # Endpoints whose *_gauge counters advance between requests
+    COUNTERS = {"network": ("bytes_recv_gauge", "bytes_sent_gauge", "cumulative_rx", "cumulative_tx"),
+                "diskio": ("read_bytes_gauge", "write_bytes_gauge", "read_count_gauge", "write_count_gauge")}
+
+    def __init__(self, corpus):
+        self.lock = threading.Lock()
+        self.start = time.monotonic()
+        self.last = self.start
+        self.data = {}
+        for name in os.listdir(corpus):
+            if name.endswith(".json") and name.count(".") == 1:
+                with open(os.path.join(corpus, name)) as f:
+                    self.data[name[:-5]] = json.load(f)
+        cores = len(self.data.get("percpu", [])) or 8
+        self.data.setdefault("cpu", {"total": 0.0, "cpucore": cores})
+        self.data.setdefault("mem", {"total": 16 * 2 ** 30, "percent": 0.0})
+        self.data.setdefault("load", {"min1": 0.0, "min5": 0.0, "min15": 0.0, "cpucore": cores})
+        self.data.setdefault("percpu", [{"cpu_number": i, "total": 0.0} for i in range(cores)])
+        self.synthetic_uptime = "uptime" not in self.data
+
+    def body(self, endpoint):
+        with self.lock:
+            if endpoint not in self.data and endpoint != "uptime":
+                return None
+            now = time.monotonic()
+            self._advance(now - self.last, now - self.start)
+            self.last = now
+            if endpoint == "uptime" and self.synthetic_uptime:
+                return json.dumps(self._uptime(now - self.start)).encode()
+            return json.dumps(self.data[endpoint]).encode()
+
+    def _advance(self, dt, t):
+        # Slow waves keep the gauges and counters believable over hours
+        wave = 0.5 + 0.5 * math.sin(t / 60.0)
+        self.data["cpu"]["total"] = round(5 + 60 * wave, 1)
+        self.data["mem"]["percent"] = round(40 + 10 * math.sin(t / 600.0), 1)
+        self.data["load"]["min1"] = round(0.2 + 3 * wave, 2)
+        for i, core in enumerate(self.data["percpu"]):
+            core["total"] = round(100 * (0.5 + 0.5 * math.sin(t / 20.0 + i)), 1)
+        for endpoint, keys in self.COUNTERS.items():
+            for i, item in enumerate(self.data.get(endpoint, [])):
+                for key in keys:
+                    if isinstance(item.get(key), int):
+                        rate = (2 ** 20 if "bytes" in key or "cumulative" in key else 200) * (1 + i) * wave
+                        item[key] += int(rate * dt)
+
+    @staticmethod
+    def _uptime(seconds):
+        seconds = int(seconds)
+        days, rest = divmod(seconds, 86400)
+        clock = "%d:%02d:%02d" % (rest // 3600, rest // 60 % 60, rest % 60)
+        return "%d days, %s" % (days, clock) if days else clock
+
+
+class State:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.requests = 0
+        self.counts = {}
+        self.last_fault = None
+        self.last_fault_unix = None
+
+    def record(self, fault):
+        with self.lock:
+            self.requests += 1
+            if fault:
+                self.counts[fault] = self.counts.get(fault, 0) + 1
+                self.last_fault = fault
+                self.last_fault_unix = time.time()
+
+
+class Handler(socketserver.StreamRequestHandler):
+    def handle(self):
+        server = self.server
+        request = self.rfile.readline(1024).decode("latin-1").split()
+        self.content_length = 0
+        while True:
+            line = self.rfile.readline(1024)
+            if line in (b"\r\n", b"\n", b""):
+                break
+            name, _, value = line.decode("latin-1").partition(":")
+            if name.strip().lower() == "content-length":
+                self.content_length = int(value.strip() or 0)
+        if len(request) < 2:
+            return
+        method, path = request[0], request[1].split("?")[0]
+        started = time.monotonic()
+
+        if path.startswith("/mock/"):
+            status, body = self.control(method, path)
+            self.respond(status, body)
+            return
+
+        faults, phase = server.faults.current()
+        body = server.payloads.body(path[len("/api/4/"):]) if path.startswith("/api/4/") else None
+        fault = None
+        status = 200 if body is not None else 404
+        if body is None:
+            body = b'{"error": "not found"}'
+
+        delay = faults["latency_ms"] + random.uniform(-faults["jitter_ms"], faults["jitter_ms"])
+        if delay > 0:
+            time.sleep(delay / 1000.0)
+
+        roll = random.random()
+        for name in ("reset", "error", "truncate"):
+            chance = faults[name + "_rate"]
+            if roll < chance:
+                fault = name
+                break
+            roll -= chance
+
+        sent = 0
+        if fault == "reset" and random.random() < 0.5:
+            self.reset()
+        elif fault == "error":
+            status = random.choice((500, 503))
+            sent = self.respond(status, b'{"error": "injected"}')
+        elif fault == "reset":
+            sent = self.respond(status, body, limit=len(body) // 2, drip=faults)
+            self.reset()
+        elif fault == "truncate":
+            sent = self.respond(status, body, limit=len(body) // 2, drip=faults)
+        else:
+            if faults["drip_bytes"] > 0:
+                fault = "drip"
+            sent = self.respond(status, body, drip=faults)
+
+        server.state.record(fault if fault != "drip" else None)
+        server.log(path, phase, fault or "", status, sent, (time.monotonic() - started) * 1000)
+
+    def control(self, method, path):
+        server = self.server
+        if path == "/mock/faults":
+            if method == "POST":
+                try:
+                    data = self.rfile.read(min(self.content_length, 4096))
+                    server.faults.update(json.loads(data or b"{}"))
+                except (ValueError, TypeError) as error:
+                    return 400, json.dumps({"error": str(error)}).encode()
+            faults, phase = server.faults.current()
+            return 200, json.dumps({"phase": phase, "faults": faults}).encode()
+        if path == "/mock/state":
+            faults, phase = server.faults.current()
+            with server.state.lock:
+                state = {"phase": phase, "faults": faults, "requests": server.state.requests,
+                         "injected": server.state.counts, "last_fault": server.state.last_fault,
+                         "last_fault_unix": server.state.last_fault_unix, "now_unix": time.time()}
+            return 200, json.dumps(state).encode()
+        return 404, b'{"error": "not found"}'
+
+    def respond(self, status, body, limit=None, drip=None):
+        reason = {200: "OK", 400: "Bad Request", 404: "Not Found", 500: "Internal Server Error",
+                  503: "Service Unavailable"}[status]
+        head = ("HTTP/1.0 %d %s\r\nContent-Type: application/json\r\nContent-Length: %d\r\n"
+                "Connection: close\r\n\r\n" % (status, reason, len(body))).encode()
+        payload = body if limit is None else body[:limit]
+        try:
+            self.wfile.write(head)
+            step = int(drip["drip_bytes"]) if drip and drip["drip_bytes"] > 0 else len(payload) or 1
+            for i in range(0, len(payload), step):
+                self.wfile.write(payload[i:i + step])
+                self.wfile.flush()
+                if step < len(payload):
+                    time.sleep(drip["drip_ms"] / 1000.0)
+        except OSError:
+            return 0
+        return len(payload)
+
+    def reset(self):
+        # SO_LINGER with a zero timeout turns close() into an RST
+        try:
+            self.wfile.flush()
+            self.connection.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack("ii", 1, 0))
+        except OSError:
+            pass
+
+
+class MockServer(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+    def __init__(self, address, payloads, faults, log_path):
+        super().__init__(address, Handler)
+        self.payloads = payloads
+        self.faults = faults
+        self.state = State()
+        self.log_lock = threading.Lock()
+        self.log_file = open(log_path, "w", newline="") if log_path else None
+        self.log_writer = csv.writer(self.log_file) if self.log_file else None
+        if self.log_writer:
+            self.log_writer.writerow(("unix", "path", "phase", "fault", "status", "bytes", "ms"))
+
+    def log(self, path, phase, fault, status, sent, ms):
+        if not self.log_writer:
+            return
+        with self.log_lock:
+            self.log_writer.writerow(("%.3f" % time.time(), path, phase, fault, status, sent, "%.1f" % ms))
+            self.log_file.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--corpus", default="test/corpus/linux-v4", help="directory of corpus responses")
+    parser.add_argument("--bind", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=61208)
+    parser.add_argument("--scenario", help="JSON list of phases: {name, seconds, <fault>: value...}")
+    parser.add_argument("--log", help="CSV file with one row per request")
+    parser.add_argument("--seed", type=int, help="seed the fault rolls for a repeatable run")
+    for key in FAULT_KEYS:
+        parser.add_argument("--" + key.replace("_", "-"), type=float, default=0.0, dest=key)
+    args = parser.parse_args()
+
+    if args.seed is not None:
+        random.seed(args.seed)
+    phases = []
+    if args.scenario:
+        with open(args.scenario) as f:
+            phases = json.load(f)
+        if not phases or any(p.get("seconds", 0) <= 0 for p in phases):
+            parser.error("every scenario phase needs seconds > 0")
+
+    faults = Faults({key: getattr(args, key) for key in FAULT_KEYS}, phases)
+    server = MockServer((args.bind, args.port), Payloads(args.corpus), faults, args.log)
+    print("Mock Glances on %s:%d serving %s" % (args.bind, args.port, args.corpus), file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Soak a device on the LAN against mock_glances.py.
+
+Point the device's Glances host at the machine running the mock, then poll
+both: the device's /api/telemetry for its heap and Glances cycle counters and
+the mock's /mock/state for the faults it injected. Every poll becomes a CSV
+row, and the summary reports cycle latency, the time from an injected fault
+to the device's next clean cycle, reboots, and the drift of the free heap,
+its largest block and the LVGL pool. Heap allocations per cycle are only
+counted by the esp32dev-soak build of the firmware.
+
+  python3 tools/soak/soak_device.py --device 192.168.1.50 \\
+      --mock http://127.0.0.1:61208 --hours 8 --csv device.csv
+"""
+
+import argparse
+import csv
+import json
+import statistics
+import sys
+import time
+import urllib.request
+
+
+def get_json(url, timeout):
+    with urllib.request.urlopen(url, timeout=timeout) as response:
+        return json.load(response)
+
+
+def median_of(values):
+    return statistics.median(values) if values else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--device", required=True, help="device address, as in http://<device>/api/telemetry")
+    parser.add_argument("--mock", default="http://127.0.0.1:61208", help="base URL of mock_glances.py")
+    parser.add_argument("--hours", type=float, default=1.0)
+    parser.add_argument("--interval", type=float, default=5.0, help="seconds between polls")
+    parser.add_argument("--csv", help="CSV file with one row per poll")
+    args = parser.parse_args()
+
+    telemetry_url = "http://%s/api/telemetry" % args.device
+    state_url = args.mock.rstrip("/") + "/mock/state"
+    out = open(args.csv, "w", newline="") if args.csv else None
+    writer = csv.writer(out) if out else None
+    if writer:
+        writer.writerow(("unix", "uptime", "cycles", "failed", "cycle_ms", "ok_age_ms", "heap_free", "heap_min",
+                         "heap_max_alloc", "allocs", "lvgl_used", "lvgl_biggest", "lvgl_frag", "phase",
+                         "last_fault"))
+
+    end = time.time() + args.hours * 3600
+    cycle_ms, free_heap, max_alloc, lvgl_frag, recoveries, allocs = [], [], [], [], [], []
+    last_uptime = None
+    reboots = 0
+    poll_errors = 0
+    pending_fault = None  # injected fault the device has not recovered from yet
+    first = last = None
+
+    while time.time() < end:
+        polled = time.time()
+        try:
+            device = get_json(telemetry_url, 10)
+        except (OSError, ValueError) as error:
+            poll_errors += 1
+            print("device poll failed: %s" % error, file=sys.stderr)
+            time.sleep(args.interval)
+            continue
+        try:
+            mock = get_json(state_url, 5)
+        except (OSError, ValueError):
+            mock = {}
+
+        glances = device.get("glances", {})
+        heap = device.get("heap", {})
+        lvgl = device.get("lvgl", {})
+        if last_uptime is not None and device["uptime"] < last_uptime:
+            reboots += 1
+            print("device rebooted at %s" % time.ctime(polled), file=sys.stderr)
+        last_uptime = device["uptime"]
+        first = first or glances
+        last = glances
+
+        cycle_ms.append(glances.get("cycleMs", 0))
+        free_heap.append(heap.get("free", 0))
+        max_alloc.append(heap.get("maxAlloc", 0))
+        lvgl_frag.append(lvgl.get("fragPct", 0))
+        if glances.get("allocs") is not None:
+            allocs.append(glances["allocs"])
+
+        # The device's last clean cycle ended okAgeMs before this poll; once
+        # that is after the latest fault, the device has recovered from it
+        fault_at = mock.get("last_fault_unix")
+        if fault_at and (pending_fault is None or fault_at > pending_fault):
+            pending_fault = fault_at
+        ok_age = glances.get("okAgeMs", -1)
+        if pending_fault and ok_age >= 0:
+            ok_at = polled - ok_age / 1000.0
+            if ok_at > pending_fault:
+                recoveries.append(ok_at - pending_fault)
+                pending_fault = None
+
+        if writer:
+            writer.writerow(("%.1f" % polled, device["uptime"], glances.get("cycles"), glances.get("failed"),
+                             glances.get("cycleMs"), ok_age, heap.get("free"), heap.get("min"),
+                             heap.get("maxAlloc"), glances.get("allocs"), lvgl.get("used"), lvgl.get("biggest"),
+                             lvgl.get("fragPct"), mock.get("phase", ""), mock.get("last_fault") or ""))
+            out.flush()
+        time.sleep(max(0.0, args.interval - (time.time() - polled)))
+
+    if not cycle_ms:
+        sys.exit("no telemetry received from %s" % telemetry_url)
+
+    # Compare the first and last tenth of the run, so one poll that caught
+    # a request in flight does not count as drift
+    tenth = max(1, len(free_heap) // 10)
+
+    def drift(values):
+        return median_of(values[-tenth:]) - median_of(values[:tenth])
+    cycles = last.get("cycles", 0) - first.get("cycles", 0)
+    failed = last.get("failed", 0) - first.get("failed", 0)
+    ordered = sorted(cycle_ms)
+    print("polls %d (%d failed), reboots %d" % (len(cycle_ms), poll_errors, reboots))
+    print("cycles %d, failed %d" % (cycles, failed))
+    print("cycle ms: p50 %d, p95 %d, max %d" % (median_of(ordered), ordered[(len(ordered) - 1) * 95 // 100],
+                                                ordered[-1]))
+    if recoveries:
+        print("recoveries %d: p50 %.1f s, max %.1f s" % (len(recoveries), median_of(recoveries), max(recoveries)))
+    else:
+        print("recoveries 0")
+    print("free heap: %d -> %d bytes, drift %+d, min %s" % (free_heap[0], free_heap[-1], drift(free_heap),
+                                                             heap.get("min", "?")))
+    print("largest heap block: %d -> %d bytes, drift %+d" % (max_alloc[0], max_alloc[-1], drift(max_alloc)))
+    if allocs:
+        print("allocations per cycle: p50 %d, max %d (max since boot %s)" % (
+            median_of(allocs), max(allocs), last.get("allocsMax")))
+    else:
+        print("allocations per cycle: not counted, flash the esp32dev-soak build to see them")
+    if lvgl:
+        print("lvgl pool: %s of %s bytes used, max %s, fragmentation %d%% -> %d%%" % (
+            lvgl.get("used"), lvgl.get("size"), lvgl.get("maxUsed"), lvgl_frag[0], lvgl_frag[-1]))
+
+
+if __name__ == "__main__":
+    main()